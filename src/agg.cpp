@@ -0,0 +1,565 @@
+/**
+ * @file agg.cpp
+ * @brief the agg builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Groups lines on a key field and sums, counts and takes the minimum,
+ * maximum and average of numeric fields in one pass, like the awk
+ * '{s[$1] += $3} END {...}' one-liners it replaces. Groups are kept in a
+ * KeyTable in the order their keys first appear. Numbers are parsed 8
+ * digits at a time within a 64-bit word, and integers are summed exactly.
+ * A mapped file is cut at newlines into one piece per core, each
+ * aggregated into its own table, and the tables are merged in order.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include "filters.h"
+#include "stream.h"
+#include "table.h"
+
+namespace
+{
+    // Inputs are only parsed in parallel in pieces of at least this size
+    const size_t PIECE_SIZE = 1 << 22;
+
+    // Highest field number agg takes, a slot being kept for every field up to the last one read
+    const size_t MAX_FIELD = 1 << 20;
+
+    inline bool eight_digits(const char* data)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        // Every byte is 0x30 to 0x39, the high nibble being 3 before and after adding 6
+        return ((word & 0xf0f0f0f0f0f0f0f0ULL) | (((word + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) >> 4))
+               == 0x3333333333333333ULL;
+    }
+
+    // The value of 8 digits, combined pairwise in three multiplications
+    inline uint32_t parse_eight(const char* data)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        word = (word & 0x0f0f0f0f0f0f0f0fULL) * 2561 >> 8;
+        word = (word & 0x00ff00ff00ff00ffULL) * 6553601 >> 16;
+        return static_cast<uint32_t>((word & 0x0000ffff0000ffffULL) * 42949672960001ULL >> 32);
+    }
+
+    /**
+    * @brief A number read from a field.
+    */
+    struct Number
+    {
+        bool exact; //!< Whether it is an integer, held in integer.
+        int64_t integer;
+        double real;
+    };
+
+    // Reads digits into a mantissa, 8 at a time while they fit, counting them; past 19 the count is 100
+    inline void read_digits(const char*& at, const char* end, uint64_t& mantissa, int& digits)
+    {
+        while (end - at >= 8 && digits <= 10 && eight_digits(at))
+        {
+            mantissa = mantissa * 100000000 + parse_eight(at);
+            at += 8;
+            digits += 8;
+        }
+        for (; at < end && *at >= '0' && *at <= '9'; ++at)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*at - '0');
+                ++digits;
+            }
+            else
+            {
+                digits = 100;
+            }
+        }
+    }
+
+    /**
+    * @brief Parses a number: integers exactly, others exactly too when their digits and exponent are small.
+    *
+    * @return false if the field is not a number.
+    */
+    bool parse_number(const char* begin, const char* end, Number& number)
+    {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const char* at = begin;
+        const bool negative = at < end && *at == '-';
+        if (at < end && (*at == '-' || *at == '+'))
+        {
+            ++at;
+        }
+        uint64_t mantissa = 0;
+        int digits = 0;
+        const char* start = at;
+        read_digits(at, end, mantissa, digits);
+        bool whole = true;
+        int exponent = 0;
+        if (at < end && *at == '.')
+        {
+            const char* fraction = ++at;
+            read_digits(at, end, mantissa, digits);
+            exponent = -static_cast<int>(at - fraction);
+            whole = false;
+        }
+        if (at - start <= (whole ? 0 : 1))
+        {
+            return false;
+        }
+        if (at < end && (*at == 'e' || *at == 'E'))
+        {
+            ++at;
+            const bool below = at < end && *at == '-';
+            if (at < end && (*at == '-' || *at == '+'))
+            {
+                ++at;
+            }
+            if (at == end)
+            {
+                return false;
+            }
+            int power = 0;
+            for (; at < end && *at >= '0' && *at <= '9'; ++at)
+            {
+                power = std::min(power * 10 + (*at - '0'), 100000);
+            }
+            exponent += below ? -power : power;
+            whole = false;
+        }
+        if (at != end)
+        {
+            return false;
+        }
+
+        number.exact = whole && digits <= 18;
+        if (number.exact)
+        {
+            number.integer = negative ? -static_cast<int64_t>(mantissa) : static_cast<int64_t>(mantissa);
+            number.real = static_cast<double>(number.integer);
+            return true;
+        }
+        // Clinger's fast path: both the digits and the power of ten are exact doubles
+        if (digits <= 15 && exponent >= -22 && exponent <= 22)
+        {
+            const double value = static_cast<double>(mantissa);
+            number.real = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+            number.real = negative ? -number.real : number.real;
+        }
+        else
+        {
+            number.real = std::strtod(std::string(begin, end).c_str(), nullptr);
+        }
+        number.integer = 0;
+        return true;
+    }
+
+    /**
+    * @brief The numbers of one field in one group.
+    */
+    struct Accumulator
+    {
+        uint64_t count = 0; //!< Numbers seen.
+        bool exact = true; //!< Whether all were integers and their sum fits 64 bits.
+        int64_t integer_sum = 0;
+        double real_sum = 0;
+        double compensation = 0; //!< What adding to real_sum lost, so the order of pieces hardly matters.
+        int64_t integer_low = 0;
+        int64_t integer_high = 0;
+        double low = 0;
+        double high = 0;
+
+        void add(const Number& number)
+        {
+            if (count++ == 0)
+            {
+                integer_low = integer_high = number.integer;
+                low = high = number.real;
+            }
+            add_real(number.real);
+            low = std::min(low, number.real);
+            high = std::max(high, number.real);
+            if (!number.exact || __builtin_add_overflow(integer_sum, number.integer, &integer_sum))
+            {
+                exact = false;
+            }
+            integer_low = std::min(integer_low, number.integer);
+            integer_high = std::max(integer_high, number.integer);
+        }
+
+        void merge(const Accumulator& other)
+        {
+            if (other.count == 0)
+            {
+                return;
+            }
+            if (count == 0)
+            {
+                *this = other;
+                return;
+            }
+            count += other.count;
+            exact = exact && other.exact && !__builtin_add_overflow(integer_sum, other.integer_sum, &integer_sum);
+            add_real(other.real_sum);
+            add_real(other.compensation);
+            integer_low = std::min(integer_low, other.integer_low);
+            integer_high = std::max(integer_high, other.integer_high);
+            low = std::min(low, other.low);
+            high = std::max(high, other.high);
+        }
+
+        double sum() const
+        {
+            return real_sum + compensation;
+        }
+
+    private:
+        // Neumaier's compensated summation
+        void add_real(const double value)
+        {
+            const double total = real_sum + value;
+            compensation += std::fabs(real_sum) >= std::fabs(value) ? (real_sum - total) + value : (value - total) + real_sum;
+            real_sum = total;
+        }
+    };
+
+    /**
+    * @brief A group: its lines and where its accumulators are.
+    */
+    struct Group
+    {
+        uint64_t lines = 0;
+        size_t first = 0; //!< Index of the accumulator of its first field.
+    };
+
+    /**
+    * @brief Groups of a part of the input.
+    */
+    struct Partial
+    {
+        cash::KeyTable<Group> table;
+        std::vector<Accumulator> accumulators; //!< Those of each group, one per field, in a row.
+        std::vector<Number> numbers; //!< The numbers of the line being added, one per field.
+        std::vector<char> present; //!< Whether each field of that line is a number.
+    };
+
+    /**
+    * @brief agg as a pipeline stage.
+    */
+    class Agg : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the options.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            if (!cash::get_options(args, "a:ck:m:M:s:t:", options, inputs))
+            {
+                return false;
+            }
+            if (options.count('k') && (!parse(options['k'], key) || key == 0))
+            {
+                cash::report("agg", "invalid field '" + options['k'] + "'");
+                return false;
+            }
+            if (options.count('t'))
+            {
+                if (options['t'].size() != 1 || options['t'][0] == '\n')
+                {
+                    cash::report("agg", "the delimiter must be a single character");
+                    return false;
+                }
+                separator = options['t'][0];
+            }
+            // The output has the key, then the count, sums, minimums, maximums and averages
+            const char kinds[] = {'s', 'm', 'M', 'a'};
+            for (int kind = 0; kind < 4; ++kind)
+            {
+                if (options.count(kinds[kind]) == 0)
+                {
+                    continue;
+                }
+                std::string list = options[kinds[kind]];
+                std::replace(list.begin(), list.end(), '\n', ',');
+                for (size_t begin = 0; begin <= list.size();)
+                {
+                    const size_t comma = std::min(list.find(',', begin), list.size());
+                    size_t field;
+                    if (!parse(list.substr(begin, comma - begin), field) || field == 0)
+                    {
+                        cash::report("agg", "invalid field list '" + options[kinds[kind]] + "'");
+                        return false;
+                    }
+                    const auto known = std::find(fields.begin(), fields.end(), field);
+                    columns.push_back(Column{static_cast<Kind>(kind), static_cast<size_t>(known - fields.begin())});
+                    if (known == fields.end())
+                    {
+                        fields.push_back(field);
+                    }
+                    begin = comma + 1;
+                }
+            }
+            counted = options.count('c') != 0 || columns.empty();
+            last_field = std::max(key, fields.empty() ? 0 : *std::max_element(fields.begin(), fields.end()));
+            slots.assign(last_field + 1, -1);
+            for (size_t f = 0; f < fields.size(); ++f)
+            {
+                slots[fields[f]] = static_cast<long>(f);
+            }
+            return true;
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            splitter.split(data, size, [this](const char* begin, const char* end)
+            {
+                aggregate(begin, end);
+            });
+            return true;
+        }
+
+        void finish() override
+        {
+            splitter.finish([this](const char* begin, const char* end)
+            {
+                add(total, begin, end);
+            });
+            std::string line;
+            char number[32];
+            for (const auto& entry : total.table.items())
+            {
+                line.clear();
+                const char out = separator != '\0' ? separator : ' ';
+                if (key != 0)
+                {
+                    line.append(entry.key, entry.length);
+                }
+                if (counted)
+                {
+                    std::snprintf(number, sizeof(number), "%" PRIu64, entry.value.lines);
+                    append(line, number, out);
+                }
+                for (const Column& column : columns)
+                {
+                    format(total.accumulators[entry.value.first + column.field], column.kind, number, sizeof(number));
+                    append(line, number, out);
+                }
+                line += '\n';
+                if (!emit(line.data(), line.size()))
+                {
+                    break;
+                }
+            }
+            end();
+        }
+
+    private:
+        enum Kind
+        {
+            SUM,
+            MIN,
+            MAX,
+            AVERAGE
+        };
+
+        /**
+        * @brief A column of the output after the key and count.
+        */
+        struct Column
+        {
+            Kind kind;
+            size_t field; //!< Index of the field among those aggregated.
+        };
+
+        static bool parse(const std::string& text, size_t& value)
+        {
+            if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+            {
+                return false;
+            }
+            value = std::stoul(text);
+            return value <= MAX_FIELD;
+        }
+
+        // Appends a column, after a separator unless it is the first
+        void append(std::string& line, const char* value, const char out) const
+        {
+            if (key != 0 || !line.empty())
+            {
+                line += out;
+            }
+            line += value;
+        }
+
+        // Writes an aggregate, - when the field had no numbers
+        static void format(const Accumulator& accumulator, const Kind kind, char* text, const size_t size)
+        {
+            if (accumulator.count == 0)
+            {
+                std::snprintf(text, size, kind == SUM ? "0" : "-");
+                return;
+            }
+            const bool exact = accumulator.exact;
+            switch (kind)
+            {
+            case SUM:
+                exact ? std::snprintf(text, size, "%" PRId64, accumulator.integer_sum)
+                      : std::snprintf(text, size, "%.15g", accumulator.sum());
+                break;
+            case MIN:
+                exact ? std::snprintf(text, size, "%" PRId64, accumulator.integer_low)
+                      : std::snprintf(text, size, "%.15g", accumulator.low);
+                break;
+            case MAX:
+                exact ? std::snprintf(text, size, "%" PRId64, accumulator.integer_high)
+                      : std::snprintf(text, size, "%.15g", accumulator.high);
+                break;
+            default:
+                std::snprintf(text, size, "%.15g", (exact ? static_cast<double>(accumulator.integer_sum) : accumulator.sum())
+                                                   / static_cast<double>(accumulator.count));
+                break;
+            }
+        }
+
+        // Aggregates whole lines, in parallel pieces if there are enough of them
+        void aggregate(const char* begin, const char* end)
+        {
+            const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+            const size_t pieces = std::min<size_t>(cores, (end - begin) / PIECE_SIZE);
+            if (pieces <= 1)
+            {
+                lines(total, begin, end);
+                return;
+            }
+            std::vector<const char*> cuts(1, begin);
+            for (size_t p = 1; p < pieces; ++p)
+            {
+                const char* cut = std::max(cuts.back(), begin + (end - begin) * p / pieces);
+                const char* newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+                cuts.push_back(newline != nullptr ? newline + 1 : end);
+            }
+            cuts.push_back(end);
+            std::vector<std::unique_ptr<Partial>> partials(pieces);
+            cash::parallel_for(pieces, [&](const size_t p)
+            {
+                partials[p].reset(new Partial());
+                lines(*partials[p], cuts[p], cuts[p + 1]);
+            });
+            // In order, so groups stay in the order their keys first appear
+            for (const auto& partial : partials)
+            {
+                for (auto& entry : partial->table.items())
+                {
+                    Group& group = find(total, entry.key, entry.length);
+                    group.lines += entry.value.lines;
+                    for (size_t f = 0; f < fields.size(); ++f)
+                    {
+                        total.accumulators[group.first + f].merge(partial->accumulators[entry.value.first + f]);
+                    }
+                }
+            }
+        }
+
+        // The group of a key, made with its accumulators if new
+        Group& find(Partial& partial, const char* key, const size_t length) const
+        {
+            const size_t groups = partial.table.items().size();
+            Group& group = partial.table(key, length);
+            if (partial.table.items().size() != groups)
+            {
+                group.first = partial.accumulators.size();
+                partial.accumulators.resize(group.first + fields.size());
+            }
+            return group;
+        }
+
+        // Aggregates lines ending with newlines
+        void lines(Partial& partial, const char* begin, const char* end) const
+        {
+            cash::for_each_line(begin, end, [&](const char* line, const size_t length)
+            {
+                add(partial, line, line + length);
+            });
+        }
+
+        // Aggregates a line
+        void add(Partial& partial, const char* line, const char* end) const
+        {
+            partial.numbers.resize(fields.size());
+            partial.present.assign(fields.size(), false);
+            // A line without the key field has an empty key
+            const char* key_begin = line;
+            const char* key_end = line;
+            const char* begin = line;
+            for (size_t field = 1; field <= last_field; ++field)
+            {
+                const char* stop = cash::field_end(begin, end, separator);
+                if (field == key)
+                {
+                    key_begin = begin;
+                    key_end = stop;
+                }
+                const long slot = slots[field];
+                if (slot >= 0)
+                {
+                    partial.present[slot] = parse_number(begin, stop, partial.numbers[slot]);
+                }
+                if (stop == end)
+                {
+                    break;
+                }
+                begin = cash::next_field(stop, end, separator);
+            }
+            Group& group = find(partial, key_begin, key_end - key_begin);
+            ++group.lines;
+            for (size_t f = 0; f < fields.size(); ++f)
+            {
+                if (partial.present[f])
+                {
+                    partial.accumulators[group.first + f].add(partial.numbers[f]);
+                }
+            }
+        }
+
+        size_t key = 0; //!< The key field, 0 for one group of everything.
+        char separator = '\0'; //!< Field separator, or '\0' for runs of blanks.
+        bool counted = false; //!< Whether the lines of each group are counted, for -c.
+        std::vector<size_t> fields; //!< The fields aggregated.
+        std::vector<Column> columns; //!< The aggregates printed.
+        size_t last_field = 0; //!< The last field read.
+        std::vector<long> slots; //!< The index in fields of each field, or -1.
+
+        Partial total; //!< Groups of the whole input.
+        cash::LineSplitter splitter;
+    };
+}
+
+std::unique_ptr<cash::Stage> cash::agg_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Agg> stage(new Agg());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+int cash::agg(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
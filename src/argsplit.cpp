@@ -0,0 +1,186 @@
+/**
+ * @file argsplit.cpp
+ * @brief splitting argument lists that exceed ARG_MAX
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Runs commands whose expanded arguments are too long for one execve in
+ * batches, in process, instead of going through a pipe into xargs.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include "argsplit.h"
+#include "variables.h"
+#include "cash.h"
+#include "profile.h"
+
+extern char** environ;
+
+namespace
+{
+    // Room left for the auxiliary vector and the program name, as xargs does
+    const size_t HEADROOM = 2048;
+
+    // Longest single argument Linux accepts (MAX_ARG_STRLEN, 32 pages)
+    const size_t MAX_WORD = 32 * 4096;
+
+    size_t word_size(const std::string& word)
+    {
+        return word.size() + 1 + sizeof(char*);
+    }
+}
+
+size_t cash::argument_budget()
+{
+    long limit = sysconf(_SC_ARG_MAX);
+    if (limit <= 0)
+    {
+        limit = 128 * 1024;
+    }
+
+    size_t environment = sizeof(char*);
+    for (char** entry = environ; *entry != nullptr; ++entry)
+    {
+        environment += std::strlen(*entry) + 1 + sizeof(char*);
+    }
+
+    const size_t used = environment + HEADROOM + sizeof(char*);
+    return static_cast<size_t>(limit) > used ? static_cast<size_t>(limit) - used : 0;
+}
+
+size_t cash::argument_size(const std::vector<std::string>& args)
+{
+    size_t size = 0;
+    for (const auto& arg : args)
+    {
+        size += word_size(arg);
+    }
+    return size;
+}
+
+std::vector<std::pair<size_t, size_t>> cash::split_arguments(const std::vector<std::string>& args,
+                                                              const size_t list_begin, const size_t list_end,
+                                                              const size_t budget)
+{
+    std::vector<std::pair<size_t, size_t>> batches;
+
+    // Words outside the list go into every batch
+    size_t fixed = 0;
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        if (i < list_begin || i >= list_end)
+        {
+            fixed += word_size(args[i]);
+        }
+    }
+    if (fixed >= budget)
+    {
+        return batches;
+    }
+
+    size_t begin = list_begin, used = fixed;
+    for (size_t i = list_begin; i < list_end; ++i)
+    {
+        const size_t size = word_size(args[i]);
+        if (fixed + size > budget || args[i].size() >= MAX_WORD)
+        {
+            // This word cannot be passed at all
+            batches.clear();
+            return batches;
+        }
+        if (used + size > budget)
+        {
+            batches.emplace_back(begin, i);
+            begin = i;
+            used = fixed;
+        }
+        used += size;
+    }
+    if (begin < list_end)
+    {
+        batches.emplace_back(begin, list_end);
+    }
+    return batches;
+}
+
+int cash::spawn_batches(const std::vector<std::string>& args, const size_t list_begin, const size_t list_end)
+{
+    const auto batches = split_arguments(args, list_begin, list_end, argument_budget());
+    if (batches.empty())
+    {
+        std::cout << RED << "cash: " << args[0] << ": an argument is too long to pass at all." << RESET << std::endl;
+        return 1;
+    }
+
+    long long jobs = get_integer("ARGSPLIT_JOBS");
+    if (jobs < 1)
+    {
+        jobs = 1;
+    }
+
+    // Only the batches' own children are waited for, other children of the shell such as coprocesses are left alone
+    int result = 0;
+    std::deque<pid_t> running;
+    auto wait_oldest = [&]()
+    {
+        int status = 0;
+        const pid_t pid = running.front();
+        running.pop_front();
+        while (waitpid(pid, &status, 0) == -1)
+        {
+            if (errno != EINTR)
+            {
+                status = -1;
+                break;
+            }
+        }
+        const int code = status != -1 && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        result = result == 0 ? code : result;
+    };
+    for (const auto& batch : batches)
+    {
+        // Waits for a slot when enough batches are already running
+        if (static_cast<long long>(running.size()) == jobs)
+        {
+            wait_oldest();
+        }
+
+        std::vector<char*> c_args;
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            if (i < list_begin || i >= list_end || (i >= batch.first && i < batch.second))
+            {
+                c_args.push_back(const_cast<char*>(args[i].c_str()));
+            }
+        }
+        c_args.push_back(nullptr);
+
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cout << RED << "fork: " << strerror(errno) << RESET << std::endl;
+            result = -1;
+            break;
+        }
+        if (pid == 0)
+        {
+            profile_exec();
+            execvp(c_args[0], c_args.data());
+            std::cout << RED << "execvp: " << strerror(errno) << RESET << std::endl;
+            exit_child(EXIT_FAILURE);
+        }
+        running.push_back(pid);
+    }
+
+    while (!running.empty())
+    {
+        wait_oldest();
+    }
+    return result;
+}
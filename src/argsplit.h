@@ -0,0 +1,64 @@
+/**
+ * @file argsplit.h
+ * @brief splitting argument lists that exceed ARG_MAX
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations used by set -o argsplit.
+ */
+
+
+#ifndef CASH_ARGSPLIT_H
+#define CASH_ARGSPLIT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief Bytes of arguments execve accepts, after the environment is accounted for.
+    *
+    * @return the budget for argv strings and pointers.
+    */
+    size_t argument_budget();
+
+    /**
+    * @brief Bytes an argv takes on the new process's stack, strings and pointers included.
+    *
+    * @param args arguments.
+    * @return the size.
+    */
+    size_t argument_size(const std::vector<std::string>& args);
+
+    /**
+    * @brief Splits the list part of an argv into the fewest batches that fit the budget.
+    *
+    * Every batch repeats the words before and after the list. Packing greedily
+    * in order gives the fewest batches, since all list words cost the same in
+    * every batch.
+    *
+    * @param args the whole argv.
+    * @param list_begin first word of the list that may be split.
+    * @param list_end one past the last word of that list.
+    * @param budget bytes available, from argument_budget().
+    * @return [begin, end) ranges of the list, empty if a single word does not fit.
+    */
+    std::vector<std::pair<size_t, size_t>> split_arguments(const std::vector<std::string>& args,
+                                                            size_t list_begin, size_t list_end, size_t budget);
+
+    /**
+    * @brief Runs a command once per batch of its list, like xargs.
+    *
+    * Batches run one after another, or up to $ARGSPLIT_JOBS at a time.
+    *
+    * @param args the whole argv.
+    * @param list_begin first word of the list that may be split.
+    * @param list_end one past the last word of that list.
+    * @return an integer, the first non-zero exit status of the batches, or 0.
+    */
+    int spawn_batches(const std::vector<std::string>& args, size_t list_begin, size_t list_end);
+}
+
+#endif //CASH_ARGSPLIT_H
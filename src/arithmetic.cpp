@@ -0,0 +1,420 @@
+/**
+ * @file arithmetic.cpp
+ * @brief integer arithmetic for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * A precedence climbing parser building a small expression tree, evaluated
+ * directly against integer variables.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "arithmetic.h"
+#include "variables.h"
+#include "cash.h"
+
+/**
+* @brief A node of a parsed expression.
+*/
+struct cash::Arithmetic::Term
+{
+    enum Kind { NUMBER, VARIABLE, UNARY, BINARY, ASSIGN, PREFIX, POSTFIX, TERNARY };
+
+    Kind kind;
+    std::string op; //!< Operator text, "=" or "+=" etc. for assignments.
+    long long value = 0; //!< NUMBER value.
+    std::string name; //!< VARIABLE, ASSIGN, PREFIX and POSTFIX target.
+    std::unique_ptr<Term> a, b, c; //!< Operands.
+
+    explicit Term(const Kind kind) : kind(kind) {}
+};
+
+namespace
+{
+    typedef cash::Arithmetic::Term Term;
+
+    // Operators, longest first so that the tokenizer is greedy
+    const char* const OPERATORS[] = {
+        "<<=", ">>=", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+        "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+        "+", "-", "*", "/", "%", "<", ">", "&", "|", "^", "!", "~", "?", ":", "=", ",", "(", ")"
+    };
+
+    // Binary operators by precedence, loosest first
+    const char* const LEVELS[][4] = {
+        {"||"}, {"&&"}, {"|"}, {"^"}, {"&"}, {"==", "!="}, {"<", "<=", ">", ">="},
+        {"<<", ">>"}, {"+", "-"}, {"*", "/", "%"}
+    };
+    const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+    struct Parser
+    {
+        const std::string& text;
+        size_t pos;
+        std::string token; //!< Current token, empty at the end.
+        bool error;
+
+        void next()
+        {
+            while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+            {
+                ++pos;
+            }
+            token.clear();
+            if (pos >= text.size())
+            {
+                return;
+            }
+
+            const char ch = text[pos];
+            if (std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '$')
+            {
+                const size_t begin = pos++;
+                while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_'))
+                {
+                    ++pos;
+                }
+                token = text.substr(begin, pos - begin);
+                return;
+            }
+            for (const char* op : OPERATORS)
+            {
+                const size_t length = std::strlen(op);
+                if (text.compare(pos, length, op) == 0)
+                {
+                    token = op;
+                    pos += length;
+                    return;
+                }
+            }
+            error = true;
+        }
+
+        bool is_name() const
+        {
+            const std::string name = !token.empty() && token[0] == '$' ? token.substr(1) : token;
+            return cash::is_name(name);
+        }
+
+        std::unique_ptr<Term> comma()
+        {
+            std::unique_ptr<Term> left = assignment();
+            while (!error && token == ",")
+            {
+                next();
+                std::unique_ptr<Term> term(new Term(Term::BINARY));
+                term->op = ",";
+                term->a = std::move(left);
+                term->b = assignment();
+                left = std::move(term);
+            }
+            return left;
+        }
+
+        std::unique_ptr<Term> assignment()
+        {
+            std::unique_ptr<Term> left = ternary();
+            if (error || token.empty() || token.back() != '=' || token == "==" || token == "!="
+                || token == "<=" || token == ">=")
+            {
+                return left;
+            }
+            if (left->kind != Term::VARIABLE)
+            {
+                error = true;
+                return left;
+            }
+            std::unique_ptr<Term> term(new Term(Term::ASSIGN));
+            term->op = token;
+            term->name = left->name;
+            next();
+            // Assignments are right associative
+            term->a = assignment();
+            return term;
+        }
+
+        std::unique_ptr<Term> ternary()
+        {
+            std::unique_ptr<Term> condition = binary(0);
+            if (error || token != "?")
+            {
+                return condition;
+            }
+            next();
+            std::unique_ptr<Term> term(new Term(Term::TERNARY));
+            term->a = std::move(condition);
+            term->b = comma();
+            if (token != ":")
+            {
+                error = true;
+                return term;
+            }
+            next();
+            term->c = assignment();
+            return term;
+        }
+
+        std::unique_ptr<Term> binary(const int level)
+        {
+            if (level == LEVEL_COUNT)
+            {
+                return unary();
+            }
+            std::unique_ptr<Term> left = binary(level + 1);
+            while (!error)
+            {
+                bool found = false;
+                for (const char* op : LEVELS[level])
+                {
+                    found = found || (op != nullptr && token == op);
+                }
+                if (!found)
+                {
+                    break;
+                }
+                std::unique_ptr<Term> term(new Term(Term::BINARY));
+                term->op = token;
+                next();
+                term->a = std::move(left);
+                term->b = binary(level + 1);
+                left = std::move(term);
+            }
+            return left;
+        }
+
+        std::unique_ptr<Term> unary()
+        {
+            if (token == "++" || token == "--")
+            {
+                std::unique_ptr<Term> term(new Term(Term::PREFIX));
+                term->op = token;
+                next();
+                if (!is_name())
+                {
+                    error = true;
+                    return term;
+                }
+                term->name = token[0] == '$' ? token.substr(1) : token;
+                next();
+                return term;
+            }
+            if (token == "-" || token == "+" || token == "!" || token == "~")
+            {
+                std::unique_ptr<Term> term(new Term(Term::UNARY));
+                term->op = token;
+                next();
+                term->a = unary();
+                return term;
+            }
+            return postfix();
+        }
+
+        std::unique_ptr<Term> postfix()
+        {
+            std::unique_ptr<Term> term = primary();
+            if (!error && term->kind == Term::VARIABLE && (token == "++" || token == "--"))
+            {
+                std::unique_ptr<Term> update(new Term(Term::POSTFIX));
+                update->op = token;
+                update->name = term->name;
+                next();
+                return update;
+            }
+            return term;
+        }
+
+        std::unique_ptr<Term> primary()
+        {
+            if (token == "(")
+            {
+                next();
+                std::unique_ptr<Term> term = comma();
+                if (token != ")")
+                {
+                    error = true;
+                }
+                next();
+                return term;
+            }
+            if (!token.empty() && std::isdigit(static_cast<unsigned char>(token[0])))
+            {
+                std::unique_ptr<Term> term(new Term(Term::NUMBER));
+                char* end = nullptr;
+                // Accepts 0x hexadecimal and 0 octal like C
+                term->value = std::strtoll(token.c_str(), &end, 0);
+                error = error || *end != '\0';
+                next();
+                return term;
+            }
+            if (is_name())
+            {
+                std::unique_ptr<Term> term(new Term(Term::VARIABLE));
+                term->name = token[0] == '$' ? token.substr(1) : token;
+                next();
+                return term;
+            }
+            error = true;
+            return std::unique_ptr<Term>(new Term(Term::NUMBER));
+        }
+    };
+
+    // Overflow wraps around, as in bash, instead of being undefined
+    long long wrap(const unsigned long long value)
+    {
+        return static_cast<long long>(value);
+    }
+
+    long long apply(const std::string& op, const long long a, const long long b, bool& error)
+    {
+        typedef unsigned long long Bits;
+        switch (op[0])
+        {
+        case '+': return wrap(static_cast<Bits>(a) + static_cast<Bits>(b));
+        case '-': return wrap(static_cast<Bits>(a) - static_cast<Bits>(b));
+        case '*': return wrap(static_cast<Bits>(a) * static_cast<Bits>(b));
+        case '/':
+        case '%':
+            if (b == 0)
+            {
+                error = true;
+                return 0;
+            }
+            // The smallest number divided by -1 would trap
+            if (b == -1)
+            {
+                return op[0] == '/' ? wrap(0 - static_cast<Bits>(a)) : 0;
+            }
+            return op[0] == '/' ? a / b : a % b;
+        case '<':
+            // Shift counts are taken modulo 64, as bash does
+            if (op == "<<") return wrap(static_cast<Bits>(a) << (b & 63));
+            return op == "<=" ? a <= b : a < b;
+        case '>':
+            if (op == ">>") return a >> (b & 63);
+            return op == ">=" ? a >= b : a > b;
+        case '=': return a == b;
+        case '!': return a != b;
+        case '&': return a & b;
+        case '|': return a | b;
+        case '^': return a ^ b;
+        case ',': return b;
+        default:
+            error = true;
+            return 0;
+        }
+    }
+
+    long long evaluate(const Term& term, bool& error)
+    {
+        switch (term.kind)
+        {
+        case Term::NUMBER:
+            return term.value;
+        case Term::VARIABLE:
+            return cash::get_integer(term.name);
+        case Term::UNARY:
+        {
+            const long long value = evaluate(*term.a, error);
+            switch (term.op[0])
+            {
+            case '-': return wrap(0 - static_cast<unsigned long long>(value));
+            case '!': return !value;
+            case '~': return ~value;
+            default: return value;
+            }
+        }
+        case Term::BINARY:
+        {
+            const long long a = evaluate(*term.a, error);
+            // Logical operators short-circuit
+            if (term.op == "&&")
+            {
+                return a && evaluate(*term.b, error);
+            }
+            if (term.op == "||")
+            {
+                return a || evaluate(*term.b, error);
+            }
+            return apply(term.op, a, evaluate(*term.b, error), error);
+        }
+        case Term::ASSIGN:
+        {
+            long long value = evaluate(*term.a, error);
+            if (term.op != "=")
+            {
+                const std::string op = term.op.substr(0, term.op.size() - 1);
+                value = apply(op, cash::get_integer(term.name), value, error);
+            }
+            cash::set_integer(term.name, value);
+            return value;
+        }
+        case Term::PREFIX:
+        case Term::POSTFIX:
+        {
+            const long long old = cash::get_integer(term.name);
+            const long long updated = apply(term.op == "++" ? "+" : "-", old, 1, error);
+            cash::set_integer(term.name, updated);
+            return term.kind == Term::PREFIX ? updated : old;
+        }
+        case Term::TERNARY:
+            return evaluate(*term.a, error) ? evaluate(*term.b, error) : evaluate(*term.c, error);
+        }
+        return 0;
+    }
+}
+
+cash::Arithmetic::Arithmetic(const std::string& text) : text(text), invalid(false)
+{
+    Parser parser{text, 0, "", false};
+    parser.next();
+    if (parser.token.empty() && !parser.error)
+    {
+        return;
+    }
+    root = parser.comma();
+    invalid = parser.error || !parser.token.empty();
+}
+
+cash::Arithmetic::~Arithmetic() = default;
+
+long long cash::Arithmetic::evaluate(bool& error) const
+{
+    if (invalid)
+    {
+        std::cout << RED << "cash: Bad arithmetic expression: " << text << RESET << std::endl;
+        error = true;
+        return 0;
+    }
+    if (!root)
+    {
+        return 0;
+    }
+    const long long value = ::evaluate(*root, error);
+    if (error)
+    {
+        std::cout << RED << "cash: Division by zero: " << text << RESET << std::endl;
+        return 0;
+    }
+    return value;
+}
+
+bool cash::Arithmetic::empty() const
+{
+    return !root && !invalid;
+}
+
+int cash::arithmetic(const std::vector<std::string>& args)
+{
+    const std::string& word = args[0];
+    if (args.size() != 1 || word.size() < 4 || word.compare(word.size() - 2, 2, "))") != 0)
+    {
+        std::cout << RED << "cash: Bad syntax. Expected ((expression))." << RESET << std::endl;
+        return 1;
+    }
+    const Arithmetic expression(word.substr(2, word.size() - 4));
+    bool error = false;
+    return expression.evaluate(error) != 0 && !error ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file arithmetic.h
+ * @brief integer arithmetic for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the declaration of compiled arithmetic expressions, as used by
+ * ((...)), $((...)) and for ((...)) loops.
+ */
+
+
+#ifndef CASH_ARITHMETIC_H
+#define CASH_ARITHMETIC_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief An arithmetic expression, parsed once and evaluated many times.
+    *
+    * Supports integer literals, variables (with or without $), parentheses,
+    * unary + - ! ~, prefix and postfix ++ --, * / %, + -, << >>, comparisons,
+    * == !=, & ^ |, && ||, ?:, the assignment operators and the comma operator.
+    * Variables are read and written as native integers.
+    */
+    class Arithmetic
+    {
+    public:
+        /**
+        * @brief Parses an expression. An empty expression evaluates to 0.
+        *
+        * @param text the expression.
+        */
+        explicit Arithmetic(const std::string& text);
+        ~Arithmetic();
+
+        /**
+        * @brief Evaluates the expression.
+        *
+        * @param error set to true on syntax errors and division by zero.
+        * @return the value, 0 on errors.
+        */
+        long long evaluate(bool& error) const;
+
+        /**
+        * @brief Checks whether the expression has no terms, like the missing condition of for ((;;)).
+        *
+        * @return true if the text was blank.
+        */
+        bool empty() const;
+
+        struct Term;
+
+    private:
+        std::unique_ptr<Term> root; //!< Parsed expression, nullptr for an empty one.
+        std::string text; //!< Original text, for error messages.
+        bool invalid; //!< Whether parsing failed.
+    };
+
+    /**
+    * @brief Evaluates ((expr)).
+    *
+    * @param args arguments, the first being the whole ((expr)) word.
+    * @return 0 if the expression is non-zero, 1 if it is zero or invalid.
+    */
+    int arithmetic(const std::vector<std::string>& args);
+}
+
+#endif //CASH_ARITHMETIC_H
@@ -8,16 +8,36 @@
  * The main cpp file of cash, a toy shell project.
  */
 
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/types.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <sstream>
 #include "cash.h"
+#include "argsplit.h"
+#include "pipeline.h"
+#include "prefetch.h"
+#include "profile.h"
+#include "redirect.h"
+#include "stream.h"
+#include "syntax.h"
+#include "variables.h"
+
+std::set<std::string> cash::options;
+
+namespace
+{
+    // Options understood by set -o
+    const char* const KnownOptions[] = {"argsplit", "pipefail"};
+}
 
 int cash::help(const std::vector<std::string>& args)
 {
@@ -30,6 +50,11 @@ int cash::help(const std::vector<std::string>& args)
     {
         std::cout << "    " << BOLD << MAGENTA << command.name << RESET << ": " << command.description << std::endl;
     }
+    std::cout << "Built-in filters (no fork at the end of a pipeline):" << std::endl;
+    for (const auto& command : cash::StreamCommands)
+    {
+        std::cout << "    " << BOLD << MAGENTA << command.name << RESET << ": " << command.description << std::endl;
+    }
 
     return 0;
 }
@@ -72,6 +97,41 @@ int cash::history(const std::vector<std::string>& args)
     return 0;
 }
 
+int cash::set(const std::vector<std::string>& args)
+{
+    if (args.size() == 2 && args[1] == "-o")
+    {
+        for (const char* option : KnownOptions)
+        {
+            std::cout << option << "\t" << (options.count(option) ? "on" : "off") << std::endl;
+        }
+        return 0;
+    }
+    if (args.size() != 3 || (args[1] != "-o" && args[1] != "+o"))
+    {
+        std::cout << "Usage: set -o|+o option" << std::endl;
+        return 2;
+    }
+
+    for (const char* option : KnownOptions)
+    {
+        if (args[2] == option)
+        {
+            if (args[1] == "-o")
+            {
+                options.insert(option);
+            }
+            else
+            {
+                options.erase(option);
+            }
+            return 0;
+        }
+    }
+    std::cout << RED << "set: unknown option " << args[2] << RESET << std::endl;
+    return 2;
+}
+
 int cash::greet()
 {
     std::cout << "cash: Can\'t Afford a SHell by Angine, version 0.1" << std::endl
@@ -79,40 +139,81 @@ int cash::greet()
     return 0;
 }
 
-std::vector<std::string> cash::parse(const std::string& input, const char delimiter)
+std::vector<std::string> cash::parse(const std::string& input, const char delimiter, std::vector<bool>* quoted_words)
 {
     std::vector<std::string> args;
+    std::vector<bool> patterns_quoted;
     std::string arg;
     bool quoted = false;
+    // Whether a *, ? or [ of the current argument was inside quotes
+    bool pattern_quoted = false;
+    char previous = '\0';
+    // Parentheses still open in an arithmetic ((...)) word, which may contain spaces and ;
+    int arithmetic_depth = 0;
 
     for (const char ch : input)
     {
-        if (ch == '"')
+        if (arithmetic_depth > 0)
+        {
+            arg += ch;
+            arithmetic_depth += ch == '(' ? 1 : ch == ')' ? -1 : 0;
+        }
+        else if (ch == '(' && !quoted && previous == '(' && (arg == "(" || (arg.size() >= 2 && arg.compare(arg.size() - 2, 2, "$(") == 0)))
+        {
+            arg += ch;
+            arithmetic_depth = 2;
+        }
+        else if (ch == '"')
         {
             // Set quoted status when encountering a double quote
             quoted = !quoted;
         }
+        else if (ch == ';' && !quoted)
+        {
+            // Semicolons are words of their own, and two in a row make ;;
+            if (!arg.empty())
+            {
+                args.push_back(arg);
+                patterns_quoted.push_back(pattern_quoted);
+                arg.clear();
+                pattern_quoted = false;
+            }
+            if (previous == ';' && args.back() == ";")
+            {
+                args.back() = ";;";
+            }
+            else
+            {
+                args.push_back(";");
+                patterns_quoted.push_back(false);
+            }
+        }
         else if (ch == delimiter && !quoted)
         {
             // If not within quotes and at a delimiter, finalize the current argument
             if (!arg.empty())
             {
                 args.push_back(arg);
+                patterns_quoted.push_back(pattern_quoted);
                 // Clear arg for the next argument
                 arg.clear();
+                pattern_quoted = false;
             }
         }
         else
         {
             // Otherwise, add character to the current argument
             arg += ch;
+            pattern_quoted = pattern_quoted || (quoted && (ch == '*' || ch == '?' || ch == '['));
         }
+        previous = ch;
     }
 
     // Add the last argument if it's not empty
     if (!arg.empty())
     {
         args.push_back(arg);
+        patterns_quoted.push_back(pattern_quoted);
     }
 
     // If quotation marks do not appear in pairs
@@ -122,8 +223,13 @@ std::vector<std::string> cash::parse(const std::string& input, const char delimi
         std::cout << "cash: Bad syntax. Unmatched quotation marks." << std::endl;
         // Clear the args as empty output should be given to a bad input
         args.clear();
+        patterns_quoted.clear();
     }
 
+    if (quoted_words != nullptr)
+    {
+        *quoted_words = patterns_quoted;
+    }
     return args;
 }
 
@@ -135,77 +241,333 @@ int cash::execute(const std::vector<std::string>& args)
         return 1;
     }
 
-    // Check if in the built-in commands list
-    for (const auto& builtin_command : cash::BuiltinCommands)
+    bool incomplete = false;
+    const NodePtr tree = parse_tree(args, incomplete);
+    if (incomplete)
+    {
+        std::cout << RED << "cash: Bad syntax. Unexpected end of input." << RESET << std::endl;
+    }
+    if (!tree)
+    {
+        return 2;
+    }
+    return tree->run();
+}
+
+int cash::execute_pipeline(const std::vector<std::string>& args, const std::vector<bool>* quoted)
+{
+    // Splits the args into commands at each pipe
+    std::vector<std::vector<std::string>> commands(1);
+    std::vector<std::vector<bool>> literals(1);
+    for (size_t i = 0; i < args.size(); ++i)
     {
-        if (args[0] == builtin_command.name)
+        if (args[i] == "|")
+        {
+            commands.emplace_back();
+            literals.emplace_back();
+        }
+        else
         {
-            return builtin_command.func(args);
+            commands.back().push_back(args[i]);
+            literals.back().push_back(quoted != nullptr && i < quoted->size() && (*quoted)[i]);
         }
     }
 
-    // Processing pipes
-    std::vector<std::string> command1, command2;
-    bool found_pipe = false;
+    // No pipe, run the command directly
+    if (commands.size() == 1)
+    {
+        return execute_command(args, quoted);
+    }
 
-    // Splits the args into to sets of args
-    for (const auto& arg : args)
+    std::vector<std::vector<std::string>> expanded;
+    std::vector<std::unique_ptr<Redirections>> redirections;
+    for (size_t c = 0; c < commands.size(); ++c)
+    {
+        if (commands[c].empty())
+        {
+            std::cout << RED << "cash: Bad syntax. Empty command in pipeline." << RESET << std::endl;
+            return 2;
+        }
+        expanded.push_back(expand_all(commands[c], &literals[c]));
+        redirections.emplace_back(new Redirections());
+        redirections.back()->take(expanded.back());
+        // Counted here, the children's counts would be lost
+        if (!expanded.back().empty() && find_builtin(expanded.back()[0], false) == nullptr
+            && find_builtin(expanded.back()[0], true) == nullptr)
+        {
+            record_execution(expanded.back()[0]);
+        }
+    }
+
+    // cat of one file at the head of a pipeline is skipped, the file itself becomes the input of the next command
+    int input = -1;
+    if (expanded[0].size() == 2 && expanded[0][0] == "cat" && expanded[0][1][0] != '-' && redirections[0]->empty())
     {
-        // Sets flag if there is pipe
-        if (arg == "|")
+        input = open(expanded[0][1].c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (input != -1 && (fstat(input, &info) != 0 || !S_ISREG(info.st_mode)))
+        {
+            close(input);
+            input = -1;
+        }
+        if (input != -1)
         {
-            found_pipe = true;
+            commands.erase(commands.begin());
+            expanded.erase(expanded.begin());
+            redirections.erase(redirections.begin());
         }
-        // When the pipe has not been met, args goes into the first command
-        else if (!found_pipe)
+    }
+
+    // Adjacent builtins with stage builders are fused, passing chunks in one process instead of through pipes
+    std::vector<std::pair<size_t, size_t>> stages;
+    bool fusable = false;
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        const BuiltinCommand* builtin = expanded[i].empty() ? nullptr : find_builtin(expanded[i][0], true);
+        const bool can_fuse = builtin != nullptr && builtin->stage != nullptr && redirections[i]->empty()
+            && (builtin->fusable == nullptr || builtin->fusable(expanded[i]));
+        if (can_fuse && fusable)
         {
-            command1.push_back(arg);
+            stages.back().second = i + 1;
         }
-        // Everything after the pipe goes to the second command
         else
         {
-            command2.push_back(arg);
+            stages.emplace_back(i, i + 1);
         }
+        fusable = can_fuse;
     }
 
-    // when there is pipe
-    if (found_pipe)
+    // The children share a process group, stopped early once their output is not wanted
+    PipelineGroup processes(options.count("pipefail") > 0);
+    for (size_t s = 0; s < stages.size(); ++s)
     {
+        const size_t i = stages[s].first;
+        const bool is_last = s + 1 == stages.size();
+        const bool fused = stages[s].second - i > 1;
+        const std::vector<std::vector<std::string>> group(expanded.begin() + i, expanded.begin() + stages[s].second);
+
+        // A builtin filter at the end runs in the shell, saving a fork
+        const BuiltinCommand* filter = is_last && !expanded[i].empty() ? find_builtin(expanded[i][0], true) : nullptr;
+        if (filter != nullptr)
+        {
+            std::cout.flush();
+            const int saved = dup(STDIN_FILENO);
+            // A pipeline fused into one stage keeps the shell's standard input
+            if (input != -1)
+            {
+                dup2(input, STDIN_FILENO);
+                close(input);
+                input = -1;
+            }
+            processes.watch_in_background();
+            int result = 1;
+            if (redirections[i]->apply(expanded[i][0]))
+            {
+                result = fused ? run_stages(group) : filter->func(expanded[i]);
+                redirections[i]->restore();
+            }
+            processes.add_finished(result);
+            // Restoring standard input closes the pipe, so writers still running get SIGPIPE
+            dup2(saved, STDIN_FILENO);
+            close(saved);
+            break;
+        }
+
         // Initialize pipe file descriptors
-        int pipe_file[2];
-        pipe(pipe_file);
+        int pipe_file[2] = {-1, -1};
+        if (!is_last && pipe(pipe_file) != 0)
+        {
+            std::cout << RED << "pipe: " << strerror(errno) << RESET << std::endl;
+            break;
+        }
 
-        // Forks for the first command
-        if (fork() == 0)
+        std::cout.flush();
+        const pid_t pid = fork();
+        if (pid == -1)
         {
-            // Redirects standard output to the pipe file 1
-            dup2(pipe_file[1], STDOUT_FILENO);
-            close(pipe_file[0]);
-            close(pipe_file[1]);
-            // Spawn the first process
-            spawn(command1);
-            std::exit(0);
+            std::cout << RED << "fork: " << strerror(errno) << RESET << std::endl;
+            if (!is_last)
+            {
+                close(pipe_file[0]);
+                close(pipe_file[1]);
+            }
+            break;
+        }
+        if (pid == 0)
+        {
+            processes.join();
+            // Reads from the previous command and writes to the pipe of the next
+            if (input != -1)
+            {
+                dup2(input, STDIN_FILENO);
+                close(input);
+            }
+            if (!is_last)
+            {
+                dup2(pipe_file[1], STDOUT_FILENO);
+                close(pipe_file[0]);
+                close(pipe_file[1]);
+            }
+            if (!redirections[i]->apply(expanded[i].empty() ? "cash" : expanded[i][0]))
+            {
+                exit_child(EXIT_FAILURE);
+            }
+            if (fused)
+            {
+                exit_child(run_stages(group));
+            }
+            run_stage(commands[i], expanded[i]);
         }
-        // Forks for the second command
-        if (fork() == 0)
+        processes.add(pid);
+
+        if (input != -1)
+        {
+            close(input);
+        }
+        if (!is_last)
         {
-            // Redirects the pipe file 0 to standard input
-            dup2(pipe_file[0], STDIN_FILENO);
             close(pipe_file[1]);
-            close(pipe_file[0]);
-            spawn(command2);
-            std::exit(0);
+            input = pipe_file[0];
         }
-        close(pipe_file[0]);
-        close(pipe_file[1]);
-        wait(nullptr);
-        wait(nullptr);
     }
-    else
+    if (input != -1)
     {
-        spawn(args);
+        close(input);
     }
-    return 0;
+
+    // The status of a pipeline is the status of its last command, or with pipefail of the last that failed
+    return processes.wait();
+}
+
+void cash::run_stage(const std::vector<std::string>& args, const std::vector<std::string>& expanded)
+{
+    if (expanded.empty())
+    {
+        exit_child(0);
+    }
+
+    // Builtins and special forms run in this child, everything else replaces it
+    const BuiltinCommand* builtin = find_builtin(expanded[0], false);
+    if (builtin == nullptr)
+    {
+        builtin = find_builtin(expanded[0], true);
+    }
+    if (builtin != nullptr || args[0] == "[[" || args[0].compare(0, 2, "((") == 0
+        || (args.size() == 1 && args[0].find('=') != std::string::npos))
+    {
+        exit_child(builtin != nullptr ? builtin->func(expanded) : execute_command(args));
+    }
+
+    std::vector<char*> c_args;
+    for (const auto& arg : expanded)
+    {
+        c_args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    c_args.push_back(nullptr);
+    profile_exec();
+    execvp(c_args[0], c_args.data());
+    std::cout << RED << "execvp: " << strerror(errno) << RESET << std::endl;
+    exit_child(EXIT_FAILURE);
+}
+
+void cash::exit_child(const int status)
+{
+    std::cout.flush();
+    std::fflush(stdout);
+    _exit(status);
+}
+
+const cash::BuiltinCommand* cash::find_builtin(const std::string& name, const bool streams)
+{
+    if (streams)
+    {
+        for (const auto& command : StreamCommands)
+        {
+            if (command.name == name)
+            {
+                return &command;
+            }
+        }
+        return nullptr;
+    }
+    for (const auto& command : BuiltinCommands)
+    {
+        if (command.name == name)
+        {
+            return &command;
+        }
+    }
+    return nullptr;
+}
+
+int cash::execute_command(const std::vector<std::string>& args, const std::vector<bool>* quoted)
+{
+    // Conditional and arithmetic expressions expand their own operands
+    if (args[0] == "[[")
+    {
+        return conditional(args);
+    }
+    if (args[0].compare(0, 2, "((") == 0)
+    {
+        return arithmetic(args);
+    }
+
+    // A command made only of NAME=value words sets variables
+    bool assignments = true;
+    for (const auto& arg : args)
+    {
+        assignments = assignments && arg.find('=') != std::string::npos && is_name(arg.substr(0, arg.find('=')));
+    }
+    if (assignments)
+    {
+        for (const auto& arg : args)
+        {
+            assign(arg);
+        }
+        return 0;
+    }
+
+    size_t list_begin = 0, list_end = 0;
+    std::vector<std::string> expanded = expand_all(args, quoted, &list_begin, &list_end);
+
+    // Redirections like >&5 hold while the command runs, in the shell so builtins see them too
+    Redirections redirections;
+    redirections.take(expanded, &list_begin, &list_end);
+    if (!redirections.apply(expanded.empty() ? "cash" : expanded[0]))
+    {
+        return 1;
+    }
+    if (expanded.empty())
+    {
+        return 0;
+    }
+    if (expanded[0] == "exec")
+    {
+        redirections.keep();
+    }
+
+    // Check if in the built-in commands lists
+    const BuiltinCommand* builtin = find_builtin(expanded[0], false);
+    if (builtin == nullptr)
+    {
+        builtin = find_builtin(expanded[0], true);
+    }
+    if (builtin != nullptr)
+    {
+        std::cout.flush();
+        return builtin->func(expanded);
+    }
+
+    record_execution(expanded[0]);
+
+    // Too long for one execve, run it in batches
+    if (options.count("argsplit") && list_end - list_begin > 1
+        && argument_size(expanded) > argument_budget())
+    {
+        return spawn_batches(expanded, list_begin, list_end);
+    }
+
+    return spawn(expanded);
 }
 
 int cash::spawn(const std::vector<std::string>& args)
@@ -230,11 +592,16 @@ int cash::spawn(const std::vector<std::string>& args)
     if (pid == 0)
     {
         // Child process: execute the command
+        profile_exec();
         if (execvp(c_args[0], c_args.data()) == -1)
         {
             // If execvp fails, print error and exit
             std::cout << RED << "execvp: " << strerror(errno) << RESET << std::endl;
-            std::exit(EXIT_FAILURE);
+            if (errno == E2BIG)
+            {
+                std::cout << "cash: \"set -o argsplit\" runs such commands in batches." << std::endl;
+            }
+            exit_child(EXIT_FAILURE);
         }
     }
     else
@@ -262,6 +629,7 @@ int cash::spawn(const std::vector<std::string>& args)
 
 int cash::loop()
 {
+    size_t number = 0;
     while (true)
     {
         std::string input;
@@ -274,17 +642,85 @@ int cash::loop()
             break;
         }
 
+        const size_t first = ++number;
+        profile_line(number, input);
+
+        // Reads more lines while a compound command is left open
+        std::vector<bool> quoted;
+        std::vector<std::string> args = parse(input, ' ', &quoted);
+        std::vector<size_t> lines(args.size(), number);
+        bool incomplete = false;
+        NodePtr tree = parse_tree(args, incomplete, &lines, &quoted);
+        while (incomplete)
+        {
+            std::cout << BOLD << CYAN << "> " << RESET;
+            std::string more;
+            if (!std::getline(std::cin, more))
+            {
+                std::cout << RED << "cash: Bad syntax. Unexpected end of input." << RESET << std::endl;
+                break;
+            }
+            ++number;
+            profile_line(number, more);
+            // A line break ends a command unless the line ends with an operator
+            const std::string& last = args.back();
+            const bool joined = last == "|" || last == "|+" || last == "&&" || last == "||";
+            input += joined ? " " : "; ";
+            input += more;
+            args = parse(input, ' ', &quoted);
+            if (!joined)
+            {
+                lines.push_back(number - 1);
+            }
+            lines.resize(lines.size() + parse(more, ' ').size(), number);
+            // A quote left open across lines splits differently, its words are put on the first line
+            if (lines.size() != args.size())
+            {
+                lines.assign(args.size(), first);
+            }
+            tree = parse_tree(args, incomplete, &lines, &quoted);
+        }
+
         // Saves history
         history_commands.push_back(input);
-        std::vector<std::string> args = parse(input, ' ');
 
-        execute(args);
+        if (tree)
+        {
+            last_status = tree->run();
+        }
     }
     return 0;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Every argument is checked before profiling starts, which would report on exit
+    bool profiled = false;
+    std::string folded_path = "cash-profile.folded";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--profile")
+        {
+            profiled = true;
+        }
+        else if (arg.compare(0, 10, "--profile=") == 0)
+        {
+            profiled = true;
+            folded_path = arg.substr(10);
+        }
+        else
+        {
+            cash::report("cash", "usage: cash [--profile[=file]]");
+            return 2;
+        }
+    }
+    if (profiled)
+    {
+        cash::start_profile(folded_path);
+    }
+    cash::load_exec_counts();
+    cash::start_prefetch();
     cash::greet();
     cash::loop();
     return EXIT_SUCCESS;
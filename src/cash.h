@@ -18,6 +18,15 @@
 #define CYAN    "\033[36m"      /* Cyan */
 #define BOLD    "\033[1m"      /* Bold */
 
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "conditional.h"
+#include "coproc.h"
+#include "filters.h"
+#include "redirect.h"
+
 namespace cash
 {
     /**
@@ -39,15 +48,21 @@ namespace cash
     *
     * @param input User input.
     * @param delimiter Delimiter used for splitting input into arguments.
+    * @param quoted if given, set to whether each argument has a *, ? or [ inside quotes, so it is not a pattern.
     * @return arguments, in a vector of strings.
     */
-    std::vector<std::string> parse(const std::string& input, char delimiter);
+    std::vector<std::string> parse(const std::string& input, char delimiter, std::vector<bool>* quoted = nullptr);
 
     /**
     * @brief Stores history commands.
     */
     static std::vector<std::string> history_commands;
 
+    /**
+    * @brief Shell options enabled with set -o.
+    */
+    extern std::set<std::string> options;
+
     /**
     * @brief Prints help message.
     *
@@ -80,6 +95,14 @@ namespace cash
     */
     int history(const std::vector<std::string>& args);
 
+    /**
+    * @brief Enables (set -o name) or disables (set +o name) shell options, or lists them (set -o).
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int set(const std::vector<std::string>& args);
+
     /**
     * @brief Spawns new process.
     *
@@ -89,13 +112,50 @@ namespace cash
     int spawn(const std::vector<std::string>& args);
 
     /**
-    * @brief Executes the command.
+    * @brief Parses and executes the command.
     *
     * @param args arguments.
     * @return an integer, exit status.
     */
     int execute(const std::vector<std::string>& args);
 
+    /**
+    * @brief Executes a pipeline.
+    *
+    * @param args arguments.
+    * @param quoted if given, whether each argument is kept from file name matching.
+    * @return an integer, exit status of the last command.
+    */
+    int execute_pipeline(const std::vector<std::string>& args, const std::vector<bool>* quoted = nullptr);
+
+    /**
+    * @brief Expands and executes a single command, assignment or conditional expression.
+    *
+    * @param args arguments.
+    * @param quoted if given, whether each argument is kept from file name matching.
+    * @return an integer, exit status.
+    */
+    int execute_command(const std::vector<std::string>& args, const std::vector<bool>* quoted = nullptr);
+
+    /**
+    * @brief Runs a pipeline stage in a forked child, never returns.
+    *
+    * @param args arguments, unexpanded.
+    * @param expanded arguments, expanded.
+    */
+    [[noreturn]] void run_stage(const std::vector<std::string>& args, const std::vector<std::string>& expanded);
+
+    /**
+    * @brief Ends a forked child, flushing its output but leaving the shell's input alone.
+    *
+    * std::exit would sync the inherited standard input stream, moving the
+    * offset of a script file shared with the shell back to where the child
+    * had buffered it, and the shell would run those lines again.
+    *
+    * @param status exit status.
+    */
+    [[noreturn]] void exit_child(int status);
+
     /**
     * @brief Built-in Command.
     */
@@ -104,14 +164,55 @@ namespace cash
         std::string name; //!< Name of the built-in command.
         int (*func)(const std::vector<std::string>& args); //!< Pointer to the built-in function.
         std::string description; //!< Description of the built-in command.
+        std::unique_ptr<Stage> (*stage)(const std::vector<std::string>& args); //!< Builds it as a fusable stage, if it can be one.
+        bool (*fusable)(const std::vector<std::string>& args); //!< Whether these arguments can run as a stage, if not all can.
     };
 
     static const BuiltinCommand BuiltinCommands[] = {
-        BuiltinCommand{"help", help, "shows this message."},
-        BuiltinCommand{"cd", cd, "changes directory."},
-        BuiltinCommand{"exit", exit, "exits the shell program."},
-        BuiltinCommand{"history", history, "shows history commands"}
+        BuiltinCommand{"help", help, "shows this message.", nullptr, nullptr},
+        BuiltinCommand{"cd", cd, "changes directory.", nullptr, nullptr},
+        BuiltinCommand{"exit", exit, "exits the shell program.", nullptr, nullptr},
+        BuiltinCommand{"history", history, "shows history commands", nullptr, nullptr},
+        BuiltinCommand{"set", set, "sets shell options: argsplit runs commands with too many arguments in batches, pipefail fails pipelines on any failed command.", nullptr, nullptr},
+        BuiltinCommand{"coproc", coproc, "starts a command behind pipes: coproc NAME cmd, then cmd >&${NAME[1]} and read -u ${NAME[0]}.", nullptr, nullptr},
+        BuiltinCommand{"read", read_line, "reads a line into variables, from a descriptor with -u.", nullptr, nullptr},
+        BuiltinCommand{"exec", exec, "keeps redirections like 5>&- for the shell, or replaces it with a command.", nullptr, nullptr},
+        BuiltinCommand{"[[", conditional, "evaluates a conditional expression, e.g. [[ $s =~ ^(a+)b$ ]].", nullptr, nullptr}
     }; //!< Array for built-in commands.
+
+    static const BuiltinCommand StreamCommands[] = {
+        BuiltinCommand{"cat", cat, "concatenates files, copied by the kernel without passing through the shell.", nullptr, nullptr},
+        BuiltinCommand{"wc", wc, "counts lines, words and bytes.", nullptr, nullptr},
+        BuiltinCommand{"grep", grep, "prints lines containing fixed strings.", grep_stage, grep_in_process},
+        BuiltinCommand{"tr", tr, "translates, deletes or squeezes characters.", tr_stage, tr_in_process},
+        BuiltinCommand{"head", head, "prints the first lines, reading no further.", head_stage, head_in_process},
+        BuiltinCommand{"tail", tail, "prints the last lines, reading files backwards; -f follows them.", nullptr, nullptr},
+        BuiltinCommand{"sort", sort, "sorts lines on every core, spilling to temporary files past a memory budget.", nullptr, nullptr},
+        BuiltinCommand{"cut", cut, "prints selected fields of lines.", cut_stage, cut_in_process},
+        BuiltinCommand{"count", count, "counts distinct lines or fields, most frequent first.", count_stage, nullptr},
+        BuiltinCommand{"hjoin", hjoin, "joins two unsorted files on a field through a hash table.", hjoin_stage, nullptr},
+        BuiltinCommand{"agg", agg, "sums, counts and averages numeric fields per key.", agg_stage, nullptr},
+        BuiltinCommand{"map", map, "runs a line filter like sed or awk on blocks of the input on every core, keeping their order.", nullptr, nullptr},
+        BuiltinCommand{"seq", seq, "prints a sequence of integers, vmspliced into pipes.", nullptr, nullptr},
+        BuiltinCommand{"yes", yes, "prints a line until stopped, vmspliced into pipes.", nullptr, nullptr},
+        BuiltinCommand{"hashsum", hashsum, "prints or checks sha256, xxh3 or crc32c digests of files.", nullptr, nullptr},
+        BuiltinCommand{"csv", csv, "reads CSV or TSV, keeping only the columns asked for.", csv_stage, nullptr},
+        BuiltinCommand{"json", json, "selects values from JSON and NDJSON with jq's paths.", json_stage, nullptr},
+        BuiltinCommand{"from-csv", from_csv, "reads CSV into records for the record builtins.", from_csv_stage, nullptr},
+        BuiltinCommand{"where", where, "keeps the records whose column passes a test.", where_stage, nullptr},
+        BuiltinCommand{"select", select, "keeps some columns of records.", select_stage, nullptr},
+        BuiltinCommand{"sort-by", sort_by, "sorts records by columns, numbers by value.", sort_by_stage, nullptr},
+        BuiltinCommand{"to-text", to_text, "writes records as tab-separated lines.", to_text_stage, nullptr}
+    }; //!< Array for built-in commands that filter data, which run in the shell as the last stage of a pipeline.
+
+    /**
+    * @brief Looks up a built-in command.
+    *
+    * @param name the command name.
+    * @param streams whether to look in StreamCommands instead of BuiltinCommands.
+    * @return the command, or nullptr.
+    */
+    const BuiltinCommand* find_builtin(const std::string& name, bool streams);
 }
 
 #endif //CASH_H
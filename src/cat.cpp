@@ -0,0 +1,193 @@
+/**
+ * @file cat.cpp
+ * @brief the cat builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Files are copied by the kernel without passing through this process:
+ * splice when either end is a pipe, copy_file_range between regular files
+ * and sendfile to anything else, such as a terminal or a socket. Only
+ * inputs none of them take, like a terminal, are read and written here.
+ * A pipeline starting with cat of one file skips cat altogether, see
+ * execute_pipeline.
+ */
+
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    // The most each system call is asked to move
+    const size_t TRANSFER_SIZE = 1 << 30;
+
+    /**
+    * @brief Outcome of one way of copying.
+    */
+    enum Copy
+    {
+        COPIED, //!< Everything up to the end of the input.
+        FAILED, //!< An error, in errno.
+        UNSUPPORTED //!< These kinds of file cannot be copied this way, try another from where it stopped.
+    };
+
+    // Whether an error means the call does not work for these files
+    bool unsupported(const int error)
+    {
+        return error == EINVAL || error == ENOSYS || error == EXDEV || error == EBADF || error == EOPNOTSUPP;
+    }
+
+    // Copies with a system call of the same shape as splice
+    template <typename Call>
+    Copy transfer(const int input, const int output, const Call& call)
+    {
+        while (true)
+        {
+            const ssize_t moved = call(input, output, TRANSFER_SIZE);
+            if (moved > 0)
+            {
+                continue;
+            }
+            if (moved == 0)
+            {
+                return COPIED;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return unsupported(errno) ? UNSUPPORTED : FAILED;
+        }
+    }
+
+    Copy read_write(const int input, const int output)
+    {
+        char buffer[1 << 16];
+        while (true)
+        {
+            const ssize_t got = read(input, buffer, sizeof(buffer));
+            if (got == 0)
+            {
+                return COPIED;
+            }
+            if (got < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return FAILED;
+            }
+            for (ssize_t written = 0; written < got; )
+            {
+                const ssize_t put = write(output, buffer + written, got - written);
+                if (put < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return FAILED;
+                }
+                written += put;
+            }
+        }
+    }
+
+    /**
+    * @brief Copies the rest of an input to an output, by the cheapest means the two allow.
+    *
+    * @return false on errors, left in errno.
+    */
+    bool copy(const int input, const struct stat& in, const int output, const struct stat& out)
+    {
+        Copy result = UNSUPPORTED;
+        if (S_ISFIFO(in.st_mode) || S_ISFIFO(out.st_mode))
+        {
+            result = transfer(input, output, [](const int from, const int to, const size_t size)
+            {
+                return splice(from, nullptr, to, nullptr, size, SPLICE_F_MOVE);
+            });
+        }
+        if (result == UNSUPPORTED && S_ISREG(in.st_mode) && S_ISREG(out.st_mode))
+        {
+            result = transfer(input, output, [](const int from, const int to, const size_t size)
+            {
+                return copy_file_range(from, nullptr, to, nullptr, size, 0);
+            });
+        }
+        if (result == UNSUPPORTED && S_ISREG(in.st_mode))
+        {
+            result = transfer(input, output, [](const int from, const int to, const size_t size)
+            {
+                return sendfile(to, from, nullptr, size);
+            });
+        }
+        if (result == UNSUPPORTED)
+        {
+            result = read_write(input, output);
+        }
+        return result == COPIED;
+    }
+}
+
+int cash::cat(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    // -u asks for what is done anyway, the other options change the output and run the cat in PATH
+    if (!get_options(args, "u", options, operands, true))
+    {
+        return spawn(args);
+    }
+    if (operands.empty())
+    {
+        operands.push_back("-");
+    }
+
+    struct stat out = {};
+    fstat(STDOUT_FILENO, &out);
+    int status = 0;
+    for (const auto& operand : operands)
+    {
+        const int fd = open_input("cat", operand);
+        if (fd == -1)
+        {
+            status = 1;
+            continue;
+        }
+        struct stat in = {};
+        fstat(fd, &in);
+        // Copying a file onto its own end would never reach the end
+        if (S_ISREG(in.st_mode) && in.st_dev == out.st_dev && in.st_ino == out.st_ino)
+        {
+            report("cat", operand + ": input file is output file");
+            close_input(fd);
+            status = 1;
+            continue;
+        }
+        if (!copy(fd, in, STDOUT_FILENO, out))
+        {
+            const int error = errno;
+            close_input(fd);
+            // Nobody reads the output any more
+            if (error == EPIPE)
+            {
+                return 1;
+            }
+            report("cat", operand + ": " + strerror(error));
+            status = 1;
+            continue;
+        }
+        close_input(fd);
+    }
+    return status;
+}
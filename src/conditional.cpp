@@ -0,0 +1,282 @@
+/**
+ * @file conditional.cpp
+ * @brief [[ ... ]] conditional expressions for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * A recursive descent evaluator for conditional expressions, with regex
+ * matching through a cache of compiled patterns.
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fnmatch.h>
+#include <cstdlib>
+#include <iostream>
+#include "conditional.h"
+#include "variables.h"
+#include "cash.h"
+
+cash::RegexCache::RegexCache(const size_t capacity) : capacity(capacity)
+{
+}
+
+std::shared_ptr<const cash::CompiledRegex> cash::RegexCache::get(const std::string& pattern, std::string& error)
+{
+    const auto found = index.find(pattern);
+    if (found != index.end())
+    {
+        // Move the hit to the front
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->second;
+    }
+
+    regex_t regex;
+    const int code = regcomp(&regex, pattern.c_str(), REG_EXTENDED);
+    if (code != 0)
+    {
+        char message[256];
+        regerror(code, &regex, message, sizeof(message));
+        error = message;
+        return nullptr;
+    }
+    std::shared_ptr<CompiledRegex> compiled(new CompiledRegex);
+    compiled->regex = regex;
+
+    entries.emplace_front(pattern, compiled);
+    index[pattern] = entries.begin();
+
+    // Evict the least recently used pattern
+    if (entries.size() > capacity)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    return compiled;
+}
+
+namespace
+{
+    cash::RegexCache regex_cache(64);
+
+    /**
+    * @brief Parser state over the words between [[ and ]].
+    */
+    struct Evaluator
+    {
+        const std::vector<std::string>& words;
+        size_t pos;
+        bool error;
+        bool active; //!< False while parsing a short-circuited operand.
+
+        bool at(const char* word) const
+        {
+            return pos < words.size() && words[pos] == word;
+        }
+
+        bool disjunction();
+        bool conjunction();
+        bool negation();
+        bool primary();
+    };
+
+    bool match_regex(const std::string& text, const std::string& pattern, bool& error)
+    {
+        std::string message;
+        const auto compiled = regex_cache.get(pattern, message);
+        if (!compiled)
+        {
+            std::cout << RED << "[[: " << message << RESET << std::endl;
+            error = true;
+            return false;
+        }
+
+        std::vector<regmatch_t> groups(compiled->regex.re_nsub + 1);
+        if (regexec(&compiled->regex, text.c_str(), groups.size(), groups.data(), 0) != 0)
+        {
+            cash::unset_variable("BASH_REMATCH");
+            return false;
+        }
+
+        std::vector<std::string> captures;
+        captures.reserve(groups.size());
+        for (const auto& group : groups)
+        {
+            captures.push_back(group.rm_so == -1 ? "" : text.substr(group.rm_so, group.rm_eo - group.rm_so));
+        }
+        cash::set_array("BASH_REMATCH", captures);
+        return true;
+    }
+
+    bool test_file(const std::string& op, const std::string& path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            return false;
+        }
+        switch (op[1])
+        {
+        case 'f': return S_ISREG(info.st_mode);
+        case 'd': return S_ISDIR(info.st_mode);
+        case 'r': return access(path.c_str(), R_OK) == 0;
+        case 'w': return access(path.c_str(), W_OK) == 0;
+        case 'x': return access(path.c_str(), X_OK) == 0;
+        default: return true;
+        }
+    }
+
+    bool Evaluator::disjunction()
+    {
+        bool result = conjunction();
+        while (!error && at("||"))
+        {
+            ++pos;
+            // The right side is still parsed for syntax errors, but without side effects
+            const bool saved = active;
+            active = active && !result;
+            const bool right = conjunction();
+            active = saved;
+            result = result || right;
+        }
+        return result;
+    }
+
+    bool Evaluator::conjunction()
+    {
+        bool result = negation();
+        while (!error && at("&&"))
+        {
+            ++pos;
+            const bool saved = active;
+            active = active && result;
+            const bool right = negation();
+            active = saved;
+            result = result && right;
+        }
+        return result;
+    }
+
+    bool Evaluator::negation()
+    {
+        if (at("!"))
+        {
+            ++pos;
+            return !negation();
+        }
+        return primary();
+    }
+
+    bool Evaluator::primary()
+    {
+        if (pos >= words.size())
+        {
+            error = true;
+            return false;
+        }
+
+        if (at("("))
+        {
+            ++pos;
+            const bool result = disjunction();
+            if (!at(")"))
+            {
+                error = true;
+                return false;
+            }
+            ++pos;
+            return result;
+        }
+
+        // Unary operators
+        const std::string& first = words[pos];
+        if (first.size() == 2 && first[0] == '-' && pos + 1 < words.size()
+            && std::string("nzefdrwx").find(first[1]) != std::string::npos)
+        {
+            const std::string operand = cash::expand_word(words[pos + 1]);
+            pos += 2;
+            if (first == "-n")
+            {
+                return !operand.empty();
+            }
+            if (first == "-z")
+            {
+                return operand.empty();
+            }
+            return test_file(first, operand);
+        }
+
+        const std::string left = cash::expand_word(first);
+        ++pos;
+        if (pos >= words.size() || at("&&") || at("||") || at(")"))
+        {
+            // A lone word is true when non-empty
+            return !left.empty();
+        }
+
+        const std::string op = words[pos];
+        if (pos + 1 >= words.size())
+        {
+            error = true;
+            return false;
+        }
+        const std::string right = cash::expand_word(words[pos + 1]);
+        pos += 2;
+
+        if (op == "=~")
+        {
+            return active && match_regex(left, right, error);
+        }
+        if (op == "==" || op == "=")
+        {
+            return fnmatch(right.c_str(), left.c_str(), 0) == 0;
+        }
+        if (op == "!=")
+        {
+            return fnmatch(right.c_str(), left.c_str(), 0) != 0;
+        }
+        if (op == "<")
+        {
+            return left < right;
+        }
+        if (op == ">")
+        {
+            return left > right;
+        }
+
+        const long long a = std::strtoll(left.c_str(), nullptr, 10);
+        const long long b = std::strtoll(right.c_str(), nullptr, 10);
+        if (op == "-eq") return a == b;
+        if (op == "-ne") return a != b;
+        if (op == "-lt") return a < b;
+        if (op == "-le") return a <= b;
+        if (op == "-gt") return a > b;
+        if (op == "-ge") return a >= b;
+
+        std::cout << RED << "[[: unknown operator " << op << RESET << std::endl;
+        error = true;
+        return false;
+    }
+}
+
+int cash::conditional(const std::vector<std::string>& args)
+{
+    if (args.size() < 2 || args.back() != "]]")
+    {
+        std::cout << RED << "[[: missing ]]" << RESET << std::endl;
+        return 2;
+    }
+
+    const std::vector<std::string> words(args.begin() + 1, args.end() - 1);
+    Evaluator evaluator{words, 0, false, true};
+    const bool result = evaluator.disjunction();
+    if (evaluator.error || evaluator.pos != words.size())
+    {
+        if (!evaluator.error)
+        {
+            std::cout << RED << "[[: syntax error near " << words[evaluator.pos] << RESET << std::endl;
+        }
+        return 2;
+    }
+    return result ? 0 : 1;
+}
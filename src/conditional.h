@@ -0,0 +1,79 @@
+/**
+ * @file conditional.h
+ * @brief [[ ... ]] conditional expressions for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of the conditional command and the regex cache.
+ */
+
+
+#ifndef CASH_CONDITIONAL_H
+#define CASH_CONDITIONAL_H
+
+#include <regex.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief A compiled POSIX extended regex, freed on destruction.
+    */
+    struct CompiledRegex
+    {
+        regex_t regex; //!< The compiled regex.
+
+        CompiledRegex() = default;
+        CompiledRegex(const CompiledRegex&) = delete;
+        CompiledRegex& operator=(const CompiledRegex&) = delete;
+        ~CompiledRegex() { regfree(&regex); }
+    };
+
+    /**
+    * @brief Least recently used cache of compiled regexes, keyed by pattern text.
+    */
+    class RegexCache
+    {
+    public:
+        /**
+        * @brief Creates a cache.
+        *
+        * @param capacity maximum number of regexes kept compiled.
+        */
+        explicit RegexCache(size_t capacity);
+
+        /**
+        * @brief Looks up a pattern, compiling and inserting it if absent.
+        *
+        * @param pattern the regex text.
+        * @param error set to the regcomp message when compilation fails.
+        * @return the compiled regex, or nullptr if the pattern is invalid.
+        */
+        std::shared_ptr<const CompiledRegex> get(const std::string& pattern, std::string& error);
+
+    private:
+        typedef std::pair<std::string, std::shared_ptr<const CompiledRegex>> Entry;
+
+        size_t capacity; //!< Maximum number of entries.
+        std::list<Entry> entries; //!< Most recently used first.
+        std::unordered_map<std::string, std::list<Entry>::iterator> index; //!< Pattern to entry.
+    };
+
+    /**
+    * @brief Evaluates a [[ ... ]] conditional expression.
+    *
+    * Supports !, &&, ||, parentheses, -n, -z, -e, -f, -d, -r, -w, -x, ==, !=, <, >,
+    * the arithmetic comparisons and =~. A successful =~ stores the match and its
+    * capture groups in the BASH_REMATCH array.
+    *
+    * @param args arguments, including the surrounding [[ and ]].
+    * @return 0 if the expression is true, 1 if it is false, 2 on syntax errors.
+    */
+    int conditional(const std::vector<std::string>& args);
+}
+
+#endif //CASH_CONDITIONAL_H
@@ -0,0 +1,349 @@
+/**
+ * @file coproc.cpp
+ * @brief coprocesses for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * A coprocess is started like a pipeline stage, but with both its
+ * standard input and output on pipes whose other ends stay open in the
+ * shell, close-on-exec so that other commands only get them through a
+ * redirection. read takes its answers a line at a time, never reading
+ * past the newline, so the rest stays in the pipe for the next read.
+ */
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include "cash.h"
+#include "coproc.h"
+#include "redirect.h"
+#include "stream.h"
+#include "variables.h"
+
+namespace
+{
+    /**
+    * @brief The shell's ends of a pipe, known by inode so that a reused descriptor is not taken for it.
+    */
+    struct End
+    {
+        int fd = -1;
+        dev_t device = 0;
+        ino_t inode = 0;
+    };
+
+    /**
+    * @brief A running or ended coprocess.
+    */
+    struct Coprocess
+    {
+        pid_t pid = -1;
+        bool ended = false;
+        End output; //!< Where the shell reads the output of the command.
+        End input; //!< Where the shell writes to the command.
+    };
+
+    // Coprocesses by name
+    std::map<std::string, Coprocess> coprocesses;
+
+    End end_of(const int fd)
+    {
+        End end;
+        struct stat info;
+        if (fstat(fd, &info) == 0)
+        {
+            end.fd = fd;
+            end.device = info.st_dev;
+            end.inode = info.st_ino;
+        }
+        return end;
+    }
+
+    // Closes an end unless it was closed already and its descriptor reused
+    void close_end(const End& end)
+    {
+        struct stat info;
+        if (end.fd != -1 && fstat(end.fd, &info) == 0 && info.st_dev == end.device && info.st_ino == end.inode)
+        {
+            close(end.fd);
+        }
+    }
+
+    // Collects the coprocesses that have exited, so they do not stay zombies
+    void reap()
+    {
+        for (auto& entry : coprocesses)
+        {
+            Coprocess& coprocess = entry.second;
+            if (!coprocess.ended && waitpid(coprocess.pid, nullptr, WNOHANG) == coprocess.pid)
+            {
+                coprocess.ended = true;
+            }
+        }
+    }
+
+    /**
+    * @brief Reads a line without reading past its newline.
+    *
+    * Files are read in blocks and the offset moved back after the newline;
+    * pipes and terminals a byte at a time, as they cannot be moved back.
+    *
+    * @param fd the descriptor.
+    * @param line the line is appended here, without its newline.
+    * @return true if a newline ended the line, false at the end of the input.
+    */
+    bool read_raw(const int fd, std::string& line)
+    {
+        char buffer[4096];
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        const size_t size = offset == -1 ? 1 : sizeof(buffer);
+        while (true)
+        {
+            const ssize_t got = read(fd, buffer, size);
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (got <= 0)
+            {
+                return false;
+            }
+            const char* newline = static_cast<const char*>(std::memchr(buffer, '\n', static_cast<size_t>(got)));
+            if (newline == nullptr)
+            {
+                line.append(buffer, static_cast<size_t>(got));
+                offset += offset == -1 ? 0 : got;
+                continue;
+            }
+            line.append(buffer, newline - buffer);
+            if (offset != -1)
+            {
+                lseek(fd, offset + (newline - buffer) + 1, SEEK_SET);
+            }
+            return true;
+        }
+    }
+
+    // The shell's own input is read through std::cin, which may have buffered it already
+    bool read_raw_line(const int fd, std::string& line)
+    {
+        if (fd == STDIN_FILENO && !cash::Redirections::active(STDIN_FILENO))
+        {
+            std::string input;
+            const bool got = static_cast<bool>(std::getline(std::cin, input));
+            line += input;
+            return got && !std::cin.eof();
+        }
+        return read_raw(fd, line);
+    }
+
+    // Whitespace of IFS, which the default IFS is made of
+    bool is_ifs_blank(const char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\n';
+    }
+}
+
+int cash::coproc(const std::vector<std::string>& args)
+{
+    if (args.size() < 3)
+    {
+        report("coproc", "usage: coproc NAME command [arg...]");
+        return 2;
+    }
+    const std::string& name = args[1];
+    if (!is_name(name))
+    {
+        report("coproc", "'" + name + "' is not a valid name");
+        return 2;
+    }
+    reap();
+    const auto found = coprocesses.find(name);
+    if (found != coprocesses.end())
+    {
+        if (!found->second.ended)
+        {
+            report("coproc", name + " is still running as " + std::to_string(found->second.pid));
+            return 1;
+        }
+        close_end(found->second.output);
+        close_end(found->second.input);
+        coprocesses.erase(found);
+    }
+
+    int input[2], output[2];
+    if (pipe2(input, O_CLOEXEC) != 0)
+    {
+        report("coproc", std::string("pipe: ") + strerror(errno));
+        return 1;
+    }
+    if (pipe2(output, O_CLOEXEC) != 0)
+    {
+        report("coproc", std::string("pipe: ") + strerror(errno));
+        close(input[0]);
+        close(input[1]);
+        return 1;
+    }
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == -1)
+    {
+        report("coproc", std::string("fork: ") + strerror(errno));
+        close(input[0]);
+        close(input[1]);
+        close(output[0]);
+        close(output[1]);
+        return 1;
+    }
+    if (pid == 0)
+    {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        close(input[0]);
+        close(input[1]);
+        close(output[0]);
+        close(output[1]);
+        // A builtin runs without exec, and must not keep the input of other coprocesses open
+        for (const auto& entry : coprocesses)
+        {
+            close_end(entry.second.output);
+            close_end(entry.second.input);
+        }
+        const std::vector<std::string> command(args.begin() + 2, args.end());
+        run_stage(command, command);
+    }
+    close(input[0]);
+    close(output[1]);
+
+    Coprocess& coprocess = coprocesses[name];
+    coprocess.pid = pid;
+    coprocess.output = end_of(output[0]);
+    coprocess.input = end_of(input[1]);
+    set_array(name, {std::to_string(output[0]), std::to_string(input[1])});
+    set_variable(name + "_PID", std::to_string(pid));
+    return 0;
+}
+
+int cash::read_line(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> names;
+    if (!get_options(args, "ru:", options, names))
+    {
+        return 2;
+    }
+    int fd = STDIN_FILENO;
+    if (options.count('u'))
+    {
+        const std::string& text = options['u'];
+        if (text.empty() || text.size() > 4 || text.find_first_not_of("0123456789") != std::string::npos)
+        {
+            report("read", "invalid file descriptor '" + text + "'");
+            return 2;
+        }
+        fd = std::stoi(text);
+    }
+    if (fcntl(fd, F_GETFD) == -1)
+    {
+        report("read", std::to_string(fd) + ": " + strerror(errno));
+        return 1;
+    }
+    for (const auto& name : names)
+    {
+        if (!is_name(name))
+        {
+            report("read", "'" + name + "' is not a valid name");
+            return 2;
+        }
+    }
+
+    // Without -r, a backslash keeps the next character from splitting, and one at the end joins the next line
+    const bool raw = options.count('r') > 0;
+    std::string text;
+    std::vector<bool> escaped;
+    bool newline = false;
+    for (bool continued = true; continued;)
+    {
+        std::string line;
+        newline = read_raw_line(fd, line);
+        continued = false;
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            if (!raw && line[i] == '\\')
+            {
+                if (i + 1 == line.size())
+                {
+                    continued = newline;
+                    break;
+                }
+                text += line[++i];
+                escaped.push_back(true);
+                continue;
+            }
+            text += line[i];
+            escaped.push_back(false);
+        }
+    }
+
+    if (names.empty())
+    {
+        set_variable("REPLY", text);
+        return newline ? 0 : 1;
+    }
+    const auto ifs_variable = variables.find("IFS");
+    const std::string ifs = ifs_variable == variables.end() ? " \t\n"
+        : ifs_variable->second.values.empty() ? "" : ifs_variable->second.values[0];
+    auto separates = [&](const size_t i)
+    {
+        return !escaped[i] && ifs.find(text[i]) != std::string::npos;
+    };
+    auto blank = [&](const size_t i)
+    {
+        return separates(i) && is_ifs_blank(text[i]);
+    };
+
+    // Blanks of IFS around fields are dropped, other IFS characters end one field each
+    size_t position = 0;
+    while (position < text.size() && blank(position))
+    {
+        ++position;
+    }
+    for (size_t n = 0; n < names.size(); ++n)
+    {
+        if (n + 1 == names.size())
+        {
+            size_t end = text.size();
+            while (end > position && blank(end - 1))
+            {
+                --end;
+            }
+            set_variable(names[n], text.substr(position, end - position));
+            break;
+        }
+        const size_t start = position;
+        while (position < text.size() && !separates(position))
+        {
+            ++position;
+        }
+        set_variable(names[n], text.substr(start, position - start));
+        while (position < text.size() && blank(position))
+        {
+            ++position;
+        }
+        if (position < text.size() && separates(position))
+        {
+            ++position;
+            while (position < text.size() && blank(position))
+            {
+                ++position;
+            }
+        }
+    }
+    return newline ? 0 : 1;
+}
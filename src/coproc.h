@@ -0,0 +1,47 @@
+/**
+ * @file coproc.h
+ * @brief coprocesses for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of coproc, which keeps a helper running behind a
+ * pair of pipes, and of read, which takes lines from it or any descriptor.
+ */
+
+
+#ifndef CASH_COPROC_H
+#define CASH_COPROC_H
+
+#include <string>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief Starts a coprocess: coproc NAME command [arg...]
+    *
+    * NAME is set to an array of two descriptors, ${NAME[0]} reading the
+    * output of the command and ${NAME[1]} writing to its input, and NAME_PID
+    * to its process ID. Commands use them through redirections, like
+    * echo 1+2 >&${NAME[1]}, and read -u ${NAME[0]} takes the answers.
+    * Closing ${NAME[1]} with exec ${NAME[1]}>&- ends the input of the command.
+    *
+    * @param args arguments.
+    * @return 0, 1 if NAME is still running or the command cannot be started, 2 on invalid arguments.
+    */
+    int coproc(const std::vector<std::string>& args);
+
+    /**
+    * @brief Reads a line into variables: read [-r] [-u fd] [name...]
+    *
+    * The line is split into fields at the characters of IFS (blanks by
+    * default), the last name taking the rest, REPLY without names. Unless
+    * -r is given, a backslash escapes the next character and joins lines.
+    *
+    * @param args arguments.
+    * @return 0, 1 at the end of the input, 2 on invalid arguments.
+    */
+    int read_line(const std::vector<std::string>& args);
+}
+
+#endif //CASH_COPROC_H
@@ -0,0 +1,193 @@
+/**
+ * @file count.cpp
+ * @brief the count builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Counts distinct lines or fields in one pass over unsorted input, with a
+ * hash table whose keys live in an arena, instead of sort | uniq -c | sort.
+ * With -n only the most frequent keys are kept, through a heap of that size.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+#include <queue>
+#include <string>
+#include "filters.h"
+#include "stream.h"
+#include "table.h"
+
+namespace
+{
+    /**
+    * @brief How many times a key was seen.
+    */
+    struct Tally
+    {
+        uint64_t count = 0;
+    };
+
+    /**
+    * @brief count as a pipeline stage.
+    */
+    class Count : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the options.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            if (!cash::get_options(args, "f:n:t:", options, inputs))
+            {
+                return false;
+            }
+            if (options.count('f') && !parse(options['f'], field, 1))
+            {
+                cash::report("count", "invalid field '" + options['f'] + "'");
+                return false;
+            }
+            if (options.count('n') && !parse(options['n'], top, 1))
+            {
+                cash::report("count", "invalid number '" + options['n'] + "'");
+                return false;
+            }
+            if (options.count('t'))
+            {
+                if (options['t'].size() != 1)
+                {
+                    cash::report("count", "the delimiter must be a single character");
+                    return false;
+                }
+                separator = options['t'][0];
+            }
+            return true;
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            splitter.split(data, size, [this](const char* begin, const char* end)
+            {
+                lines(begin, end);
+            });
+            return true;
+        }
+
+        void finish() override
+        {
+            splitter.finish([this](const char* begin, const char* end)
+            {
+                lines(begin, end);
+            });
+
+            // Most frequent first, ties in the order they were first seen
+            auto& entries = table.items();
+            auto more = [&](const uint32_t a, const uint32_t b)
+            {
+                return entries[a].value.count > entries[b].value.count
+                    || (entries[a].value.count == entries[b].value.count && a < b);
+            };
+            std::vector<uint32_t> order;
+            if (top != 0 && top < entries.size())
+            {
+                // A heap of the best so far, its root being the worst of them
+                std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(more)> best(more);
+                for (uint32_t e = 0; e < entries.size(); ++e)
+                {
+                    if (best.size() < top)
+                    {
+                        best.push(e);
+                    }
+                    else if (more(e, best.top()))
+                    {
+                        best.pop();
+                        best.push(e);
+                    }
+                }
+                for (; !best.empty(); best.pop())
+                {
+                    order.push_back(best.top());
+                }
+                std::reverse(order.begin(), order.end());
+            }
+            else
+            {
+                order.resize(entries.size());
+                for (uint32_t e = 0; e < entries.size(); ++e)
+                {
+                    order[e] = e;
+                }
+                std::sort(order.begin(), order.end(), more);
+            }
+
+            // Formatted like uniq -c
+            char number[32];
+            for (const uint32_t e : order)
+            {
+                const int length = std::snprintf(number, sizeof(number), "%7" PRIu64 " ", entries[e].value.count);
+                if (!emit(number, length) || !emit(entries[e].key, entries[e].length) || !emit("\n", 1))
+                {
+                    break;
+                }
+            }
+            end();
+        }
+
+    private:
+        static bool parse(const std::string& text, size_t& value, const size_t minimum)
+        {
+            if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+            {
+                return false;
+            }
+            value = std::stoul(text);
+            return value >= minimum;
+        }
+
+        void lines(const char* begin, const char* end)
+        {
+            cash::for_each_line(begin, end, [this](const char* line, const size_t length)
+            {
+                add(line, length);
+            });
+        }
+
+        void add(const char* line, const size_t length)
+        {
+            if (field == 0)
+            {
+                ++table(line, length).count;
+                return;
+            }
+            const char* begin = line;
+            const char* stop = cash::nth_field(begin, line + length, field, separator);
+            ++table(begin, stop - begin).count;
+        }
+
+        size_t field = 0; //!< Field counted, 0 for whole lines.
+        size_t top = 0; //!< How many keys are printed, 0 for all.
+        char separator = '\0'; //!< Field separator, or '\0' for runs of blanks.
+        cash::KeyTable<Tally> table;
+        cash::LineSplitter splitter;
+    };
+}
+
+std::unique_ptr<cash::Stage> cash::count_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Count> stage(new Count());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+int cash::count(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
@@ -0,0 +1,336 @@
+/**
+ * @file cut.cpp
+ * @brief the cut builtin, for fields
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Delimiters and newlines are found 64 bytes at a time with SSE2, as a bit
+ * mask walked with count-trailing-zeros, and the selected fields are
+ * appended to one output buffer reused for every chunk. Once a line is past
+ * its last selected field the rest of it is skipped with memchr. Bytes,
+ * characters and other options are left to the cut in PATH.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Options handled here, the others run the external cut
+    const std::string OPTIONS = "d:f:s";
+
+    // Highest field number a list may name, the selection being kept as one flag per field
+    const size_t MAX_FIELD = 1 << 20;
+
+    // Parses a field number, false if it is 0 or beyond MAX_FIELD
+    bool parse_field(const std::string& text, size_t& field)
+    {
+        if (text.empty() || text.size() > 9)
+        {
+            return false;
+        }
+        field = std::stoul(text);
+        return field != 0 && field <= MAX_FIELD;
+    }
+
+    // Bits of the delimiters and newlines among the first size (at most 64) bytes
+    inline uint64_t structure(const char* data, const size_t size, const char delimiter)
+    {
+        uint64_t mask = 0;
+        size_t i = 0;
+#ifdef __SSE2__
+        if (size == 64)
+        {
+            const __m128i newlines = _mm_set1_epi8('\n');
+            const __m128i delimiters = _mm_set1_epi8(delimiter);
+            for (; i < 64; i += 16)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                const __m128i found = _mm_or_si128(_mm_cmpeq_epi8(block, newlines), _mm_cmpeq_epi8(block, delimiters));
+                mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(found))) << i;
+            }
+            return mask;
+        }
+#endif
+        for (; i < size; ++i)
+        {
+            if (data[i] == '\n' || data[i] == delimiter)
+            {
+                mask |= uint64_t(1) << i;
+            }
+        }
+        return mask;
+    }
+
+    /**
+    * @brief Parses a list of fields like 1,3-5,7-.
+    *
+    * @param list the list.
+    * @param chosen set to whether each field up to last is selected, indexed from 1.
+    * @param open set to whether every field after those is selected too.
+    * @return false if the list is invalid.
+    */
+    bool parse_list(const std::string& list, std::vector<bool>& chosen, bool& open)
+    {
+        size_t open_from = 0;
+        std::vector<std::pair<size_t, size_t>> ranges;
+        size_t begin = 0;
+        while (begin <= list.size())
+        {
+            size_t end = list.find(',', begin);
+            if (end == std::string::npos)
+            {
+                end = list.size();
+            }
+            const std::string item = list.substr(begin, end - begin);
+            begin = end + 1;
+
+            const size_t dash = item.find('-');
+            const std::string low = item.substr(0, dash);
+            const std::string high = dash == std::string::npos ? low : item.substr(dash + 1);
+            if ((low.empty() && high.empty()) || item.find_first_not_of("0123456789-") != std::string::npos
+                || (dash != std::string::npos && item.find('-', dash + 1) != std::string::npos))
+            {
+                return false;
+            }
+            size_t first = 1;
+            if (!low.empty() && !parse_field(low, first))
+            {
+                return false;
+            }
+            if (high.empty())
+            {
+                open_from = open_from == 0 ? first : std::min(open_from, first);
+                continue;
+            }
+            size_t last = 0;
+            if (!parse_field(high, last) || last < first)
+            {
+                return false;
+            }
+            ranges.emplace_back(first, last);
+        }
+
+        size_t last = open_from;
+        for (const auto& range : ranges)
+        {
+            last = std::max(last, range.second);
+        }
+        chosen.assign(last + 1, false);
+        for (const auto& range : ranges)
+        {
+            std::fill(chosen.begin() + range.first, chosen.begin() + range.second + 1, true);
+        }
+        open = open_from != 0;
+        if (open)
+        {
+            std::fill(chosen.begin() + open_from, chosen.end(), true);
+        }
+        return true;
+    }
+
+    /**
+    * @brief cut -f as a pipeline stage.
+    */
+    class Cut : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the options.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            if (!cash::get_options(args, OPTIONS, options, inputs))
+            {
+                return false;
+            }
+            if (!options.count('f'))
+            {
+                cash::report("cut", "you must specify a list of fields");
+                return false;
+            }
+            if (!parse_list(options['f'], chosen, open))
+            {
+                cash::report("cut", "invalid field list '" + options['f'] + "'");
+                return false;
+            }
+            if (options.count('d'))
+            {
+                if (options['d'].size() != 1 || options['d'][0] == '\n')
+                {
+                    cash::report("cut", "the delimiter must be a single character");
+                    return false;
+                }
+                delimiter = options['d'][0];
+            }
+            only_delimited = options.count('s') != 0;
+            return true;
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            splitter.split(data, size, [this](const char* begin, const char* end)
+            {
+                lines(begin, end);
+            });
+            return pass();
+        }
+
+        void finish() override
+        {
+            // Like coreutils, a last line without a newline gets one
+            splitter.finish([this](const char* begin, const char* end)
+            {
+                lines(begin, end);
+            }, true);
+            pass();
+            end();
+        }
+
+    private:
+        bool selected(const size_t field) const
+        {
+            return field < chosen.size() ? chosen[field] : open;
+        }
+
+        /**
+        * @brief Cuts whole lines, the last one ending with a newline.
+        */
+        void lines(const char* data, const char* end)
+        {
+            line_begin = field_begin = data;
+            const char* position = data;
+            while (position < end)
+            {
+                const char* base = position;
+                const size_t size = std::min<size_t>(64, end - position);
+                uint64_t mask = structure(base, size, delimiter);
+                position += size;
+                while (mask != 0)
+                {
+                    const char* at = base + __builtin_ctzll(mask);
+                    mask &= mask - 1;
+                    if (*at == '\n')
+                    {
+                        end_line(at);
+                        continue;
+                    }
+                    if (end_field(at))
+                    {
+                        // No field of the rest of the line is selected
+                        const char* newline = static_cast<const char*>(std::memchr(at + 1, '\n', end - at - 1));
+                        end_line(newline);
+                        position = newline + 1;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // A field ends at a delimiter, returns whether the rest of the line can be skipped
+        bool end_field(const char* at)
+        {
+            delimited = true;
+            if (selected(field))
+            {
+                if (printed)
+                {
+                    buffer += delimiter;
+                }
+                buffer.append(field_begin, at - field_begin);
+                printed = true;
+            }
+            ++field;
+            field_begin = at + 1;
+            return !open && field >= chosen.size();
+        }
+
+        void end_line(const char* newline)
+        {
+            if (!delimited)
+            {
+                // Lines without delimiters are printed whole, unless -s
+                if (!only_delimited)
+                {
+                    buffer.append(line_begin, newline + 1 - line_begin);
+                }
+            }
+            else
+            {
+                if (selected(field))
+                {
+                    if (printed)
+                    {
+                        buffer += delimiter;
+                    }
+                    buffer.append(field_begin, newline - field_begin);
+                }
+                buffer += '\n';
+            }
+            line_begin = field_begin = newline + 1;
+            field = 1;
+            printed = delimited = false;
+        }
+
+        // Passes on the output of the chunk
+        bool pass()
+        {
+            const bool wanted = buffer.empty() || emit(buffer.data(), buffer.size());
+            buffer.clear();
+            return wanted;
+        }
+
+        std::vector<bool> chosen; //!< Whether each field is selected, indexed from 1.
+        bool open = false; //!< Whether the fields after those in chosen are selected.
+        char delimiter = '\t';
+        bool only_delimited = false; //!< Whether lines without delimiters are dropped, for -s.
+
+        const char* line_begin = nullptr;
+        const char* field_begin = nullptr;
+        size_t field = 1; //!< Number of the field being read.
+        bool printed = false; //!< Whether a field of the line has been printed.
+        bool delimited = false; //!< Whether the line has a delimiter so far.
+
+        cash::LineSplitter splitter;
+        std::string buffer; //!< Output of a chunk, kept for its capacity.
+    };
+}
+
+bool cash::cut_in_process(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    return get_options(args, OPTIONS, options, operands, true) && options.count('f');
+}
+
+std::unique_ptr<cash::Stage> cash::cut_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Cut> stage(new Cut());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+int cash::cut(const std::vector<std::string>& args)
+{
+    if (!cut_in_process(args))
+    {
+        return spawn(args);
+    }
+    return run_stages({args});
+}
@@ -0,0 +1,669 @@
+/**
+ * @file digest.cpp
+ * @brief checksums and cryptographic hashes of byte streams
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * XXH3 accumulates 64-byte stripes in SSE2 registers. CRC32C uses the
+ * SSE4.2 crc32 instruction and SHA-256 the SHA extensions when cpuid says
+ * they exist, with table-driven and plain versions otherwise. All three
+ * take large inputs straight from the caller's memory, only buffering the
+ * pieces that do not fill a block.
+ */
+
+#include <cpuid.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "digest.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CASH_X86 1
+#endif
+
+namespace
+{
+    inline uint32_t load32(const uint8_t* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t load64(const uint8_t* data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t load32_big(const uint8_t* data)
+    {
+        return __builtin_bswap32(load32(data));
+    }
+
+    inline uint32_t rotate_right(const uint32_t value, const int count)
+    {
+        return (value >> count) | (value << (32 - count));
+    }
+
+    inline uint64_t rotate_left(const uint64_t value, const int count)
+    {
+        return (value << count) | (value >> (64 - count));
+    }
+
+    std::string hex(const uint8_t* bytes, const size_t size)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string text(size * 2, '0');
+        for (size_t i = 0; i < size; ++i)
+        {
+            text[2 * i] = digits[bytes[i] >> 4];
+            text[2 * i + 1] = digits[bytes[i] & 15];
+        }
+        return text;
+    }
+
+    std::string hex(const uint64_t value, const size_t bytes)
+    {
+        uint8_t big[8];
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            big[i] = static_cast<uint8_t>(value >> (8 * (bytes - 1 - i)));
+        }
+        return hex(big, bytes);
+    }
+
+    /**
+    * @brief Processor features, from cpuid.
+    */
+    struct Features
+    {
+        bool sse42 = false;
+        bool sha = false;
+
+        Features()
+        {
+#ifdef CASH_X86
+            unsigned a, b, c, d;
+            if (__get_cpuid(1, &a, &b, &c, &d))
+            {
+                sse42 = (c & bit_SSE4_2) != 0;
+                const bool ssse3_sse41 = (c & bit_SSSE3) && (c & bit_SSE4_1);
+                if (ssse3_sse41 && __get_cpuid_count(7, 0, &a, &b, &c, &d))
+                {
+                    sha = (b & (1u << 29)) != 0;
+                }
+            }
+#endif
+        }
+    };
+
+    const Features& features()
+    {
+        static const Features detected;
+        return detected;
+    }
+
+    // ---- XXH3 ----
+
+    const size_t STRIPE = 64;
+    const size_t MIDSIZE_MAX = 240;
+    const size_t SECRET_SIZE = 192;
+    // Stripes between scrambles, each moving 8 bytes further into the secret
+    const size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE) / 8;
+
+    const uint32_t PRIME32_1 = 0x9E3779B1U;
+    const uint32_t PRIME32_2 = 0x85EBCA77U;
+    const uint32_t PRIME32_3 = 0xC2B2AE3DU;
+    const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+    const uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+    const uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+    // The default secret of XXH3
+    const uint8_t SECRET[SECRET_SIZE] = {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    inline uint64_t multiply_fold(const uint64_t left, const uint64_t right)
+    {
+        const unsigned __int128 product = static_cast<unsigned __int128>(left) * right;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+    }
+
+    inline uint64_t xxh64_avalanche(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= PRIME64_2;
+        hash ^= hash >> 29;
+        hash *= PRIME64_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    inline uint64_t avalanche(uint64_t hash)
+    {
+        hash ^= hash >> 37;
+        hash *= PRIME_MX1;
+        return hash ^ (hash >> 32);
+    }
+
+    inline uint64_t mix16(const uint8_t* input, const uint8_t* secret)
+    {
+        return multiply_fold(load64(input) ^ load64(secret), load64(input + 8) ^ load64(secret + 8));
+    }
+
+    // XXH3 of inputs up to MIDSIZE_MAX bytes, which skip the stripes
+    uint64_t xxh3_short(const uint8_t* input, const size_t length)
+    {
+        if (length == 0)
+        {
+            return xxh64_avalanche(load64(SECRET + 56) ^ load64(SECRET + 64));
+        }
+        if (length <= 3)
+        {
+            const uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[length >> 1]) << 24)
+                | input[length - 1] | (static_cast<uint32_t>(length) << 8);
+            return xxh64_avalanche(combined ^ static_cast<uint64_t>(load32(SECRET) ^ load32(SECRET + 4)));
+        }
+        if (length <= 8)
+        {
+            const uint64_t value = load32(input + length - 4) + (static_cast<uint64_t>(load32(input)) << 32);
+            uint64_t hash = value ^ (load64(SECRET + 8) ^ load64(SECRET + 16));
+            hash ^= rotate_left(hash, 49) ^ rotate_left(hash, 24);
+            hash *= PRIME_MX2;
+            hash ^= (hash >> 35) + length;
+            hash *= PRIME_MX2;
+            return hash ^ (hash >> 28);
+        }
+        if (length <= 16)
+        {
+            const uint64_t low = load64(input) ^ (load64(SECRET + 24) ^ load64(SECRET + 32));
+            const uint64_t high = load64(input + length - 8) ^ (load64(SECRET + 40) ^ load64(SECRET + 48));
+            return avalanche(length + __builtin_bswap64(low) + high + multiply_fold(low, high));
+        }
+        uint64_t hash = length * PRIME64_1;
+        if (length <= 128)
+        {
+            // Pairs of 16 bytes from both ends, meeting in the middle
+            for (size_t i = 0; i <= (length - 1) / 32; ++i)
+            {
+                hash += mix16(input + 16 * i, SECRET + 32 * i);
+                hash += mix16(input + length - 16 * (i + 1), SECRET + 32 * i + 16);
+            }
+            return avalanche(hash);
+        }
+        for (size_t i = 0; i < 8; ++i)
+        {
+            hash += mix16(input + 16 * i, SECRET + 16 * i);
+        }
+        uint64_t end = mix16(input + length - 16, SECRET + 136 - 17);
+        hash = avalanche(hash);
+        for (size_t i = 8; i < length / 16; ++i)
+        {
+            end += mix16(input + 16 * i, SECRET + 16 * (i - 8) + 3);
+        }
+        return avalanche(hash + end);
+    }
+
+    // Adds a stripe to the accumulators
+    inline void accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret)
+    {
+#ifdef __SSE2__
+        __m128i* lanes = reinterpret_cast<__m128i*>(acc);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+            const __m128i keyed = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+            // The low half of every keyed lane times its high half
+            const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            // Each lane also adds the input of its neighbour
+            const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            lanes[i] = _mm_add_epi64(product, _mm_add_epi64(lanes[i], swapped));
+        }
+#else
+        for (size_t i = 0; i < 8; ++i)
+        {
+            const uint64_t data = load64(input + 8 * i);
+            const uint64_t keyed = data ^ load64(secret + 8 * i);
+            acc[i ^ 1] += data;
+            acc[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+        }
+#endif
+    }
+
+    // Mixes the accumulators between blocks
+    inline void scramble(uint64_t* acc, const uint8_t* secret)
+    {
+#ifdef __SSE2__
+        __m128i* lanes = reinterpret_cast<__m128i*>(acc);
+        const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const __m128i shifted = _mm_xor_si128(lanes[i], _mm_srli_epi64(lanes[i], 47));
+            const __m128i keyed = _mm_xor_si128(shifted, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+            // 64 by 32 bit multiplications from two 32 by 32 bit ones
+            const __m128i low = _mm_mul_epu32(keyed, prime);
+            const __m128i high = _mm_mul_epu32(_mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+            lanes[i] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+        }
+#else
+        for (size_t i = 0; i < 8; ++i)
+        {
+            uint64_t value = acc[i] ^ (acc[i] >> 47);
+            value ^= load64(secret + 8 * i);
+            acc[i] = value * PRIME32_1;
+        }
+#endif
+    }
+
+    /**
+    * @brief XXH3, 64 bits, no seed.
+    *
+    * A stripe is accumulated as soon as a byte follows it, as the last one
+    * is hashed differently, so at most 64 bytes wait for more input.
+    */
+    class Xxh3 : public cash::Digest
+    {
+    public:
+        void update(const char* bytes, size_t size) override
+        {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes);
+            // The last 64 bytes make the final stripe
+            if (size >= STRIPE)
+            {
+                std::memcpy(last, data + size - STRIPE, STRIPE);
+            }
+            else
+            {
+                std::memmove(last, last + size, STRIPE - size);
+                std::memcpy(last + STRIPE - size, data, size);
+            }
+            total += size;
+            if (total <= MIDSIZE_MAX)
+            {
+                pending.append(bytes, size);
+                return;
+            }
+
+            if (!pending.empty())
+            {
+                const size_t fill = std::min(size, (STRIPE - pending.size() % STRIPE) % STRIPE);
+                pending.append(reinterpret_cast<const char*>(data), fill);
+                data += fill;
+                size -= fill;
+                const size_t stripes = size > 0 ? pending.size() / STRIPE : (pending.size() - 1) / STRIPE;
+                consume(reinterpret_cast<const uint8_t*>(pending.data()), stripes);
+                pending.erase(0, stripes * STRIPE);
+                if (size == 0)
+                {
+                    return;
+                }
+            }
+            const size_t stripes = (size - 1) / STRIPE;
+            consume(data, stripes);
+            pending.assign(reinterpret_cast<const char*>(data) + stripes * STRIPE, size - stripes * STRIPE);
+        }
+
+        std::string finish() override
+        {
+            if (total <= MIDSIZE_MAX)
+            {
+                return hex(xxh3_short(reinterpret_cast<const uint8_t*>(pending.data()), pending.size()), 8);
+            }
+            accumulate(acc, last, SECRET + SECRET_SIZE - STRIPE - 7);
+            uint64_t hash = total * PRIME64_1;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                hash += multiply_fold(acc[2 * i] ^ load64(SECRET + 11 + 16 * i), acc[2 * i + 1] ^ load64(SECRET + 11 + 16 * i + 8));
+            }
+            return hex(avalanche(hash), 8);
+        }
+
+    private:
+        void consume(const uint8_t* data, const size_t stripes)
+        {
+            for (size_t s = 0; s < stripes; ++s)
+            {
+                accumulate(acc, data + s * STRIPE, SECRET + 8 * stripe);
+                if (++stripe == STRIPES_PER_BLOCK)
+                {
+                    scramble(acc, SECRET + SECRET_SIZE - STRIPE);
+                    stripe = 0;
+                }
+            }
+        }
+
+        alignas(16) uint64_t acc[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+                                       PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+        size_t stripe = 0; //!< Stripes accumulated in the current block.
+        uint64_t total = 0;
+        std::string pending; //!< Bytes not accumulated yet, all of them for short inputs.
+        uint8_t last[STRIPE] = {}; //!< The last bytes seen.
+    };
+
+    // ---- CRC32C ----
+
+    // Tables for 8 bytes at a time, the polynomial reflected
+    struct CrcTables
+    {
+        uint32_t table[8][256];
+
+        CrcTables()
+        {
+            for (uint32_t byte = 0; byte < 256; ++byte)
+            {
+                uint32_t crc = byte;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc >> 1) ^ (0x82F63B78U & (0 - (crc & 1)));
+                }
+                table[0][byte] = crc;
+            }
+            for (uint32_t byte = 0; byte < 256; ++byte)
+            {
+                for (int k = 1; k < 8; ++k)
+                {
+                    table[k][byte] = (table[k - 1][byte] >> 8) ^ table[0][table[k - 1][byte] & 0xFF];
+                }
+            }
+        }
+    };
+
+    uint32_t crc32c_software(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        static const CrcTables tables;
+        const auto& t = tables.table;
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            const uint64_t word = load64(data) ^ crc;
+            crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF]
+                ^ t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^ t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+        }
+        for (; size > 0; ++data, --size)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+        }
+        return crc;
+    }
+
+#ifdef CASH_X86
+    __attribute__((target("sse4.2")))
+    uint32_t crc32c_hardware(uint32_t crc, const uint8_t* data, size_t size)
+    {
+#ifdef __x86_64__
+        uint64_t wide = crc;
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            wide = _mm_crc32_u64(wide, load64(data));
+        }
+        crc = static_cast<uint32_t>(wide);
+#endif
+        for (; size >= 4; data += 4, size -= 4)
+        {
+            crc = _mm_crc32_u32(crc, load32(data));
+        }
+        for (; size > 0; ++data, --size)
+        {
+            crc = _mm_crc32_u8(crc, *data);
+        }
+        return crc;
+    }
+#endif
+
+    /**
+    * @brief CRC32C, the Castagnoli polynomial of iSCSI and ext4.
+    */
+    class Crc32c : public cash::Digest
+    {
+    public:
+        Crc32c()
+        {
+#ifdef CASH_X86
+            if (features().sse42)
+            {
+                kernel = crc32c_hardware;
+            }
+#endif
+        }
+
+        void update(const char* data, const size_t size) override
+        {
+            crc = kernel(crc, reinterpret_cast<const uint8_t*>(data), size);
+        }
+
+        std::string finish() override
+        {
+            return hex(~crc, 4);
+        }
+
+    private:
+        uint32_t (*kernel)(uint32_t, const uint8_t*, size_t) = crc32c_software;
+        uint32_t crc = 0xFFFFFFFFU;
+    };
+
+    // ---- SHA-256 ----
+
+    alignas(16) const uint32_t ROUND_CONSTANTS[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    void sha256_software(uint32_t* state, const uint8_t* data, size_t blocks)
+    {
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i)
+            {
+                w[i] = load32_big(data + 4 * i);
+            }
+            for (int i = 16; i < 64; ++i)
+            {
+                const uint32_t s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                const uint32_t s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i)
+            {
+                const uint32_t t1 = h + (rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25))
+                    + ((e & f) ^ (~e & g)) + ROUND_CONSTANTS[i] + w[i];
+                const uint32_t t2 = (rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22))
+                    + ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+
+#ifdef CASH_X86
+    // The SHA extensions keep the state as ABEF and CDGH, and do two rounds per instruction
+    __attribute__((target("sha,sse4.1,ssse3")))
+    void sha256_hardware(uint32_t* state, const uint8_t* data, size_t blocks)
+    {
+        const __m128i big_endian = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        const __m128i* constants = reinterpret_cast<const __m128i*>(ROUND_CONSTANTS);
+
+        __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+        __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+        __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+        __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            const __m128i abef_saved = abef;
+            const __m128i cdgh_saved = cdgh;
+            __m128i message[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                message[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i), big_endian);
+            }
+            // Four rounds per group; the schedule runs ahead, message[g % 4] holding words 4g to 4g+3
+            for (int g = 0; g < 16; ++g)
+            {
+                __m128i& current = message[g % 4];
+                __m128i words = _mm_add_epi32(current, _mm_load_si128(constants + g));
+                cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+                if (g >= 3 && g < 15)
+                {
+                    __m128i& next = message[(g + 1) % 4];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(current, message[(g + 3) % 4], 4));
+                    next = _mm_sha256msg2_epu32(next, current);
+                }
+                words = _mm_shuffle_epi32(words, 0x0E);
+                abef = _mm_sha256rnds2_epu32(abef, cdgh, words);
+                if (g >= 1 && g < 13)
+                {
+                    __m128i& previous = message[(g + 3) % 4];
+                    previous = _mm_sha256msg1_epu32(previous, current);
+                }
+            }
+            abef = _mm_add_epi32(abef, abef_saved);
+            cdgh = _mm_add_epi32(cdgh, cdgh_saved);
+        }
+
+        const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+        const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+    }
+#endif
+
+    /**
+    * @brief SHA-256.
+    */
+    class Sha256 : public cash::Digest
+    {
+    public:
+        Sha256()
+        {
+#ifdef CASH_X86
+            if (features().sha)
+            {
+                compress = sha256_hardware;
+            }
+#endif
+        }
+
+        void update(const char* bytes, size_t size) override
+        {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes);
+            total += size;
+            if (used > 0)
+            {
+                const size_t fill = std::min(size, sizeof(block) - used);
+                std::memcpy(block + used, data, fill);
+                used += fill;
+                data += fill;
+                size -= fill;
+                if (used < sizeof(block))
+                {
+                    return;
+                }
+                compress(state, block, 1);
+                used = 0;
+            }
+            compress(state, data, size / 64);
+            used = size % 64;
+            std::memcpy(block, data + size - used, used);
+        }
+
+        std::string finish() override
+        {
+            // A one bit, zeros up to 8 bytes before a block boundary, and the length in bits
+            const uint64_t bits = total * 8;
+            block[used++] = 0x80;
+            if (used > 56)
+            {
+                std::memset(block + used, 0, sizeof(block) - used);
+                compress(state, block, 1);
+                used = 0;
+            }
+            std::memset(block + used, 0, 56 - used);
+            for (int i = 0; i < 8; ++i)
+            {
+                block[56 + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+            }
+            compress(state, block, 1);
+
+            uint8_t digest[32];
+            for (int i = 0; i < 8; ++i)
+            {
+                const uint32_t word = __builtin_bswap32(state[i]);
+                std::memcpy(digest + 4 * i, &word, sizeof(word));
+            }
+            return hex(digest, sizeof(digest));
+        }
+
+    private:
+        void (*compress)(uint32_t*, const uint8_t*, size_t) = sha256_software;
+        uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        uint8_t block[64];
+        size_t used = 0; //!< Bytes waiting in block.
+        uint64_t total = 0;
+    };
+}
+
+const std::vector<std::string>& cash::digest_names()
+{
+    static const std::vector<std::string> names = {"sha256", "xxh3", "crc32c"};
+    return names;
+}
+
+std::unique_ptr<cash::Digest> cash::make_digest(const std::string& algorithm)
+{
+    if (algorithm == "sha256")
+    {
+        return std::unique_ptr<Digest>(new Sha256());
+    }
+    if (algorithm == "xxh3")
+    {
+        return std::unique_ptr<Digest>(new Xxh3());
+    }
+    if (algorithm == "crc32c")
+    {
+        return std::unique_ptr<Digest>(new Crc32c());
+    }
+    return nullptr;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file digest.h
+ * @brief checksums and cryptographic hashes of byte streams
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the digests computed by hashsum: XXH3 (64 bits), CRC32C and
+ * SHA-256, each using the fastest instructions the processor has.
+ */
+
+
+#ifndef CASH_DIGEST_H
+#define CASH_DIGEST_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief A digest being computed over a stream, fed in pieces of any size.
+    */
+    class Digest
+    {
+    public:
+        virtual ~Digest() = default;
+
+        /**
+        * @brief Adds bytes to the stream.
+        *
+        * @param data the bytes.
+        * @param size number of bytes.
+        */
+        virtual void update(const char* data, size_t size) = 0;
+
+        /**
+        * @brief Ends the stream.
+        *
+        * @return the digest in hexadecimal, most significant byte first.
+        */
+        virtual std::string finish() = 0;
+    };
+
+    /**
+    * @brief Names of the algorithms make_digest knows.
+    */
+    const std::vector<std::string>& digest_names();
+
+    /**
+    * @brief Starts a digest.
+    *
+    * @param algorithm xxh3, crc32c or sha256.
+    * @return the digest, or nullptr for unknown algorithms.
+    */
+    std::unique_ptr<Digest> make_digest(const std::string& algorithm);
+}
+
+#endif //CASH_DIGEST_H
@@ -0,0 +1,288 @@
+/**
+ * @file fanin.cpp
+ * @brief fan-in of concurrent producers for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Each producer writes to a pipe of its own, and a relay process waits on
+ * all of them with epoll and passes on only whole lines, holding the start
+ * of a line until its newline comes. Being the only writer to the
+ * consumer, it never mixes lines, however the producers buffer their
+ * output. Producers, relay and consumer are stages of one pipeline group:
+ * a consumer that is done cancels the rest, while producers ending early
+ * do not cancel each other.
+ */
+
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cash.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "syntax.h"
+
+namespace
+{
+    // Bytes read from a producer at a time
+    const size_t CHUNK_SIZE = 64 * 1024;
+
+    // A line longer than this is passed on in pieces rather than held whole
+    const size_t MAX_LINE = 1 << 20;
+
+    // Events taken from epoll at a time
+    const int MAX_EVENTS = 64;
+
+    // Writes a whole buffer, false if the reader is gone
+    bool write_all(const int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t written = write(fd, data, size);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    /**
+    * @brief Passes the output of the producers to standard output, whole lines at a time.
+    *
+    * A last line without a newline gets one, so that the next line passed
+    * on does not continue it.
+    *
+    * @param sources read ends of the producers' pipes.
+    */
+    [[noreturn]] void relay(const std::vector<int>& sources)
+    {
+        const int events = epoll_create1(EPOLL_CLOEXEC);
+        if (events == -1)
+        {
+            std::cerr << "cash: epoll: " << strerror(errno) << std::endl;
+            cash::exit_child(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            epoll_ctl(events, EPOLL_CTL_ADD, sources[i], &event);
+        }
+
+        // The start of a line from each producer, waiting for its newline
+        std::vector<std::string> pending(sources.size());
+        std::vector<char> buffer(CHUNK_SIZE);
+        epoll_event ready[MAX_EVENTS];
+        size_t open = sources.size();
+        while (open > 0)
+        {
+            const int count = epoll_wait(events, ready, MAX_EVENTS, -1);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                cash::exit_child(EXIT_FAILURE);
+            }
+            for (int e = 0; e < count; ++e)
+            {
+                const size_t i = ready[e].data.u64;
+                std::string& line = pending[i];
+                const ssize_t got = read(sources[i], buffer.data(), buffer.size());
+                if (got < 0 && (errno == EINTR || errno == EAGAIN))
+                {
+                    continue;
+                }
+                if (got <= 0)
+                {
+                    if (!line.empty())
+                    {
+                        line += '\n';
+                        write_all(STDOUT_FILENO, line.data(), line.size());
+                        line.clear();
+                    }
+                    epoll_ctl(events, EPOLL_CTL_DEL, sources[i], nullptr);
+                    close(sources[i]);
+                    --open;
+                    continue;
+                }
+
+                const char* data = buffer.data();
+                const char* last = static_cast<const char*>(memrchr(data, '\n', static_cast<size_t>(got)));
+                if (last == nullptr)
+                {
+                    line.append(data, static_cast<size_t>(got));
+                    if (line.size() >= MAX_LINE)
+                    {
+                        write_all(STDOUT_FILENO, line.data(), line.size());
+                        line.clear();
+                    }
+                    continue;
+                }
+                // Everything up to the last newline goes out in one write, the rest waits
+                const size_t whole = static_cast<size_t>(last - data) + 1;
+                bool written;
+                if (line.empty())
+                {
+                    written = write_all(STDOUT_FILENO, data, whole);
+                }
+                else
+                {
+                    line.append(data, whole);
+                    written = write_all(STDOUT_FILENO, line.data(), line.size());
+                }
+                if (!written)
+                {
+                    cash::exit_child(EXIT_FAILURE);
+                }
+                line.assign(data + whole, static_cast<size_t>(got) - whole);
+            }
+        }
+        cash::exit_child(EXIT_SUCCESS);
+    }
+
+    // Runs a node in a child of the fan-in, its pipelines staying in the fan-in's process group
+    [[noreturn]] void run_in_child(cash::Node& node)
+    {
+        cash::PipelineGroup::inherit();
+        cash::exit_child(node.run());
+    }
+
+    void close_all(const std::vector<int>& fds)
+    {
+        for (const int fd : fds)
+        {
+            close(fd);
+        }
+    }
+}
+
+int cash::FanInNode::run()
+{
+    ProfileScope scope(line);
+    PipelineGroup processes(options.count("pipefail") > 0);
+    std::vector<int> sources;
+    bool started = true;
+
+    for (size_t p = 0; p < producers.size(); ++p)
+    {
+        int pipe_file[2];
+        if (pipe2(pipe_file, O_CLOEXEC) != 0)
+        {
+            std::cout << RED << "pipe: " << strerror(errno) << RESET << std::endl;
+            started = false;
+            break;
+        }
+        std::cout.flush();
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cout << RED << "fork: " << strerror(errno) << RESET << std::endl;
+            close(pipe_file[0]);
+            close(pipe_file[1]);
+            started = false;
+            break;
+        }
+        if (pid == 0)
+        {
+            processes.join();
+            // Producers read nothing, as the shell's own input may be the script
+            const int nothing = open("/dev/null", O_RDONLY);
+            if (nothing != -1)
+            {
+                dup2(nothing, STDIN_FILENO);
+                close(nothing);
+            }
+            dup2(pipe_file[1], STDOUT_FILENO);
+            close(pipe_file[0]);
+            close(pipe_file[1]);
+            // A builtin runs without exec, and must not keep the other producers' pipes open
+            close_all(sources);
+            run_in_child(*producers[p]);
+        }
+        processes.add(pid, p > 0);
+        close(pipe_file[1]);
+        sources.push_back(pipe_file[0]);
+    }
+
+    // The relay writes to the consumer, or to the shell's standard output without one
+    int consumer_pipe[2] = {-1, -1};
+    if (started && consumer && pipe2(consumer_pipe, O_CLOEXEC) != 0)
+    {
+        std::cout << RED << "pipe: " << strerror(errno) << RESET << std::endl;
+        started = false;
+    }
+    if (started)
+    {
+        std::cout.flush();
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cout << RED << "fork: " << strerror(errno) << RESET << std::endl;
+            started = false;
+        }
+        else if (pid == 0)
+        {
+            processes.join();
+            if (consumer)
+            {
+                dup2(consumer_pipe[1], STDOUT_FILENO);
+                close(consumer_pipe[0]);
+                close(consumer_pipe[1]);
+            }
+            relay(sources);
+        }
+        else
+        {
+            processes.add(pid);
+        }
+    }
+    // Closing the producers' pipes here leaves the relay their only reader
+    close_all(sources);
+    if (consumer_pipe[1] != -1)
+    {
+        close(consumer_pipe[1]);
+    }
+
+    if (started && consumer)
+    {
+        std::cout.flush();
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cout << RED << "fork: " << strerror(errno) << RESET << std::endl;
+            started = false;
+        }
+        else if (pid == 0)
+        {
+            processes.join();
+            dup2(consumer_pipe[0], STDIN_FILENO);
+            close(consumer_pipe[0]);
+            run_in_child(*consumer);
+        }
+        else
+        {
+            processes.add(pid);
+        }
+    }
+    if (consumer_pipe[0] != -1)
+    {
+        close(consumer_pipe[0]);
+    }
+
+    const int status = processes.wait();
+    return started ? status : 1;
+}
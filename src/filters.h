@@ -0,0 +1,399 @@
+/**
+ * @file filters.h
+ * @brief stream builtins for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of the builtins that read standard input or files
+ * and write standard output. They run inside the shell when they are the
+ * last stage of a pipeline, and in a forked child otherwise.
+ */
+
+
+#ifndef CASH_FILTERS_H
+#define CASH_FILTERS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cash
+{
+    class Stage;
+
+    /**
+    * @brief Concatenates files to standard output: cat [-u] [file...]
+    *
+    * The kernel copies the data with splice, copy_file_range or sendfile.
+    * Options that change the output run the cat found in PATH.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int cat(const std::vector<std::string>& args);
+
+    /**
+    * @brief Counts lines, words and bytes: wc [-lwc] [file...]
+    *
+    * Regular files are mapped and large ones are split across threads.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int wc(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints lines containing fixed strings: grep [-Fcvlnqs] [-e pattern]... [pattern] [file...]
+    *
+    * Regular expressions and other options run the grep found in PATH.
+    * Several files are searched in parallel and printed in order.
+    *
+    * @param args arguments.
+    * @return 0 if a line was selected, 1 if none was, 2 on errors.
+    */
+    int grep(const std::vector<std::string>& args);
+
+    /**
+    * @brief Whether grep searches for these arguments itself, rather than running the grep in PATH.
+    *
+    * @param args arguments.
+    * @return true for fixed strings and known options.
+    */
+    bool grep_in_process(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds grep as a stage that can be fused with adjacent builtins.
+    *
+    * @param args arguments, for which grep_in_process holds.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> grep_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Translates, deletes or squeezes characters: tr [-cds] set1 [set2]
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int tr(const std::vector<std::string>& args);
+
+    /**
+    * @brief Whether tr translates for these arguments itself, rather than running the tr in PATH.
+    *
+    * @param args arguments.
+    * @return true for known options.
+    */
+    bool tr_in_process(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds tr as a stage that can be fused with adjacent builtins.
+    *
+    * @param args arguments, for which tr_in_process holds.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> tr_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints the first lines or bytes: head [-n lines | -c bytes] [-qv] [file...]
+    *
+    * Stops reading as soon as it has them, so the producer before it gets SIGPIPE.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int head(const std::vector<std::string>& args);
+
+    /**
+    * @brief Whether head takes these arguments itself, rather than running the head in PATH.
+    *
+    * @param args arguments.
+    * @return true for plain counts and known options.
+    */
+    bool head_in_process(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds head as a stage that can be fused with adjacent builtins.
+    *
+    * @param args arguments, for which head_in_process holds.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> head_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints the last lines or bytes: tail [-n [+]lines | -c [+]bytes] [-fqv] [file...]
+    *
+    * Regular files are scanned backwards from the end, and -f follows them through inotify.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int tail(const std::vector<std::string>& args);
+
+    /**
+    * @brief Sorts lines: sort [-bnrsu] [-k key]... [-t sep] [-S size] [-T dir] [file...]
+    *
+    * Sorts one piece per core and merges them; input beyond the memory budget
+    * (-S, a quarter of physical memory by default) is spilled to sorted temporary files.
+    * Other options and key types run the sort in PATH.
+    *
+    * @param args arguments.
+    * @return 0, or 2 on errors.
+    */
+    int sort(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints selected fields of lines: cut -f list [-d delim] [-s] [file...]
+    *
+    * Bytes, characters and other options run the cut found in PATH.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int cut(const std::vector<std::string>& args);
+
+    /**
+    * @brief Whether cut selects fields for these arguments itself, rather than running the cut in PATH.
+    *
+    * @param args arguments.
+    * @return true for -f with known options.
+    */
+    bool cut_in_process(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds cut as a stage that can be fused with adjacent builtins.
+    *
+    * @param args arguments, for which cut_in_process holds.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> cut_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Counts distinct lines or fields, most frequent first: count [-f field] [-t sep] [-n top] [file...]
+    *
+    * Reads unsorted input once into a hash table; -n keeps only the most frequent keys.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int count(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds count as a stage that can be fused with adjacent builtins.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> count_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Joins two unsorted files on a field: hjoin [-1 field] [-2 field] [-t char] [-a 1|2] [-v 1|2] file1 file2
+    *
+    * The smaller file goes in a hash table and the other streams past it; lines are printed like join
+    * prints them. -a also prints the lines of a file that pair with none, a left join, and -v only those,
+    * an anti join.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int hjoin(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds hjoin as a stage reading the side that streams.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> hjoin_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Aggregates numeric fields per key: agg [-k field] [-t sep] [-c] [-s fields] [-m fields] [-M fields] [-a fields] [file...]
+    *
+    * Prints a line per key, in the order keys first appear: the key, the number of lines with -c (or when
+    * nothing else is asked), then the sums (-s), minimums (-m), maximums (-M) and averages (-a) of the listed
+    * fields. Values that are not numbers are left out; a field with none has - as its minimum, maximum and
+    * average. Without -k every line is in one group.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int agg(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds agg as a stage that can be fused with adjacent builtins.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> agg_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Runs a line filter on every core: map [-j jobs] [-b size] [--] command [arg...]
+    *
+    * Standard input is cut at line ends into blocks of about -b bytes (1M by default),
+    * each piped through its own instance of the command, -j at a time (one per core by
+    * default), and the outputs are written in the order of the blocks.
+    *
+    * @param args arguments.
+    * @return 0, the status of the first instance that failed, or 2 on invalid arguments.
+    */
+    int map(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints a sequence of integers: seq [-w] [-s sep] [first [step]] last
+    *
+    * Fractions and other options run the seq found in PATH.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int seq(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints a line until stopped: yes [word...]
+    *
+    * @param args arguments.
+    * @return 1, once the output fails or Ctrl+C is pressed.
+    */
+    int yes(const std::vector<std::string>& args);
+
+    /**
+    * @brief Prints or checks digests of files: hashsum [-a sha256|xxh3|crc32c] [-c] [file...]
+    *
+    * Several files are hashed in parallel; -c reads lines of digest and file name to verify.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int hashsum(const std::vector<std::string>& args);
+
+    /**
+    * @brief Reads CSV or TSV, keeping some columns: csv [-t] [-d delimiter] [-n] [-f columns] [-o separator] [file...]
+    *
+    * -f lists the columns to keep, by name or number, separated by commas; -n numbers them when there
+    * is no header. The columns go on as records, or as plain lines of fields joined by the -o separator.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int csv(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds csv as a stage of a record pipeline.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> csv_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Selects values from JSON or NDJSON with jq's paths: json [-r] [-t] [-w condition]... filter [file...]
+    *
+    * The filter is paths like .a.b[0] or .items[].name separated by commas; -w keeps the values whose
+    * value at a path compares as asked, like ".status >= 500". -r prints strings without quotes, -t
+    * puts the values selected from one input value on one line, separated by tabs.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int json(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds json as a pipeline stage.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> json_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Reads CSV into records: from-csv [-d delimiter] [file...]
+    *
+    * Parses CSV with a header once; fused stages after it get typed columns instead of text.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int from_csv(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds from-csv as a stage of a record pipeline.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> from_csv_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Keeps the records passing a test: where column op value
+    *
+    * op is ==, !=, <, <=, >, >= or contains (also eq, ne, lt, le, gt, ge); numbers compare by value.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int where(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds where as a stage of a record pipeline.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> where_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Keeps some columns of records: select column...
+    *
+    * Columns are named, or numbered from 1.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int select(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds select as a stage of a record pipeline.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> select_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Sorts records by columns: sort-by [-r] column...
+    *
+    * Numbers sort by value and before text; the sort is stable.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int sort_by(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds sort-by as a stage of a record pipeline.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> sort_by_stage(const std::vector<std::string>& args);
+
+    /**
+    * @brief Formats records as text: to-text [-d separator] [-H]
+    *
+    * Writes records as lines of values joined by a tab, after a line of column names unless -H.
+    *
+    * @param args arguments.
+    * @return an integer, exit status.
+    */
+    int to_text(const std::vector<std::string>& args);
+
+    /**
+    * @brief Builds to-text as a stage of a record pipeline.
+    *
+    * @param args arguments.
+    * @return the stage, or nullptr after reporting invalid arguments.
+    */
+    std::unique_ptr<Stage> to_text_stage(const std::vector<std::string>& args);
+}
+
+#endif //CASH_FILTERS_H
@@ -0,0 +1,302 @@
+/**
+ * @file glob_dfa.cpp
+ * @brief glob pattern matching with a lazily built DFA
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Subset construction over the combined NFA of all case arms.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "glob_dfa.h"
+
+namespace
+{
+    // Cached DFA states before the cache is thrown away and rebuilt
+    const size_t MAX_STATES = 4096;
+
+    // Adds a [:class:] to a bracket expression, returns false for unknown names
+    bool add_class(const std::string& name, std::bitset<256>& set)
+    {
+        int (*test)(int) = nullptr;
+        if (name == "alpha") test = isalpha;
+        else if (name == "digit") test = isdigit;
+        else if (name == "alnum") test = isalnum;
+        else if (name == "space") test = isspace;
+        else if (name == "upper") test = isupper;
+        else if (name == "lower") test = islower;
+        else if (name == "punct") test = ispunct;
+        else if (name == "xdigit") test = isxdigit;
+        else return false;
+
+        for (int ch = 0; ch < 256; ++ch)
+        {
+            if (test(ch))
+            {
+                set.set(ch);
+            }
+        }
+        return true;
+    }
+
+    // Parses a bracket expression starting at pattern[i] == '[', returns the index after it or 0
+    size_t parse_bracket(const std::string& pattern, size_t i, std::bitset<256>& set)
+    {
+        size_t j = i + 1;
+        bool negate = false;
+        if (j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^'))
+        {
+            negate = true;
+            ++j;
+        }
+
+        bool first = true;
+        while (j < pattern.size() && (first || pattern[j] != ']'))
+        {
+            first = false;
+            if (pattern.compare(j, 2, "[:") == 0)
+            {
+                const size_t close = pattern.find(":]", j + 2);
+                if (close != std::string::npos && add_class(pattern.substr(j + 2, close - j - 2), set))
+                {
+                    j = close + 2;
+                    continue;
+                }
+            }
+
+            unsigned char low = pattern[j];
+            if (low == '\\' && j + 1 < pattern.size())
+            {
+                low = pattern[++j];
+            }
+            if (j + 2 < pattern.size() && pattern[j + 1] == '-' && pattern[j + 2] != ']')
+            {
+                const unsigned char high = pattern[j + 2];
+                for (int ch = low; ch <= high; ++ch)
+                {
+                    set.set(ch);
+                }
+                j += 3;
+            }
+            else
+            {
+                set.set(low);
+                ++j;
+            }
+        }
+
+        // Unterminated bracket, the [ is literal
+        if (j >= pattern.size())
+        {
+            return 0;
+        }
+        if (negate)
+        {
+            set.flip();
+        }
+        return j + 1;
+    }
+}
+
+cash::GlobDfa::GlobDfa(const std::vector<std::vector<std::string>>& arms)
+{
+    for (size_t arm = 0; arm < arms.size(); ++arm)
+    {
+        for (const auto& pattern : arms[arm])
+        {
+            compile(pattern, static_cast<int>(arm));
+        }
+    }
+
+    // Bytes that every SET state treats alike share a class
+    std::map<std::vector<bool>, int> signatures;
+    for (int byte = 0; byte < 256; ++byte)
+    {
+        std::vector<bool> signature;
+        for (size_t s = 0; s < kinds.size(); ++s)
+        {
+            if (kinds[s] == SET)
+            {
+                signature.push_back(sets[s].test(byte));
+            }
+        }
+        const auto found = signatures.find(signature);
+        if (found == signatures.end())
+        {
+            const int id = static_cast<int>(signatures.size());
+            signatures[signature] = id;
+            classes[byte] = static_cast<unsigned char>(id);
+        }
+        else
+        {
+            classes[byte] = static_cast<unsigned char>(found->second);
+        }
+    }
+    class_count = static_cast<int>(signatures.size());
+
+    reset();
+}
+
+void cash::GlobDfa::compile(const std::string& pattern, const int arm)
+{
+    size_t i = 0;
+    while (i < pattern.size())
+    {
+        std::bitset<256> set;
+        // A bracket is parsed aside, an unterminated one leaving nothing behind
+        std::bitset<256> bracket;
+        size_t end = 0;
+        if (pattern[i] == '*')
+        {
+            // Consecutive stars are one star
+            if (kinds.empty() || kinds.back() != STAR || arms.back() != arm)
+            {
+                kinds.push_back(STAR);
+                sets.push_back(set);
+                arms.push_back(arm);
+            }
+            ++i;
+            continue;
+        }
+
+        if (pattern[i] == '?')
+        {
+            set.set();
+            ++i;
+        }
+        else if (pattern[i] == '[' && (end = parse_bracket(pattern, i, bracket)) != 0)
+        {
+            set = bracket;
+            i = end;
+        }
+        else
+        {
+            if (pattern[i] == '\\' && i + 1 < pattern.size())
+            {
+                ++i;
+            }
+            set.set(static_cast<unsigned char>(pattern[i]));
+            ++i;
+        }
+        kinds.push_back(SET);
+        sets.push_back(set);
+        arms.push_back(arm);
+    }
+
+    kinds.push_back(END);
+    sets.push_back(std::bitset<256>());
+    arms.push_back(arm);
+}
+
+void cash::GlobDfa::close(std::vector<int>& set) const
+{
+    // A star may match nothing, so it also stands at the next position
+    const size_t size = set.size();
+    for (size_t i = 0; i < size; ++i)
+    {
+        int s = set[i];
+        while (kinds[s] == STAR)
+        {
+            set.push_back(++s);
+        }
+    }
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+}
+
+int cash::GlobDfa::add(std::vector<int> set)
+{
+    close(set);
+    const auto found = ids.find(set);
+    if (found != ids.end())
+    {
+        return found->second;
+    }
+
+    int accept = -1;
+    for (const int s : set)
+    {
+        if (kinds[s] == END && (accept == -1 || arms[s] < accept))
+        {
+            accept = arms[s];
+        }
+    }
+
+    const int id = static_cast<int>(states.size());
+    ids[set] = id;
+    states.push_back(set);
+    accepts.push_back(accept);
+    transitions.resize(transitions.size() + class_count, -1);
+    return id;
+}
+
+int cash::GlobDfa::step(const int state, const unsigned char byte)
+{
+    const size_t slot = static_cast<size_t>(state) * class_count + classes[byte];
+    if (transitions[slot] != -1)
+    {
+        return transitions[slot];
+    }
+
+    std::vector<int> next;
+    for (const int s : states[state])
+    {
+        if (kinds[s] == STAR)
+        {
+            next.push_back(s);
+        }
+        else if (kinds[s] == SET && sets[s].test(byte))
+        {
+            next.push_back(s + 1);
+        }
+    }
+
+    if (states.size() >= MAX_STATES)
+    {
+        // Too many patterns interact, start over rather than grow without bound
+        reset();
+        return add(next);
+    }
+
+    const int id = add(next);
+    transitions[static_cast<size_t>(state) * class_count + classes[byte]] = id;
+    return id;
+}
+
+void cash::GlobDfa::reset()
+{
+    states.clear();
+    ids.clear();
+    transitions.clear();
+    accepts.clear();
+
+    // State 0 is the dead state, which loops on every byte
+    add(std::vector<int>());
+    std::fill(transitions.begin(), transitions.end(), 0);
+
+    std::vector<int> initial;
+    for (size_t s = 0; s < kinds.size(); ++s)
+    {
+        if (s == 0 || kinds[s - 1] == END)
+        {
+            initial.push_back(static_cast<int>(s));
+        }
+    }
+    start = add(initial);
+}
+
+int cash::GlobDfa::match(const std::string& text)
+{
+    int state = start;
+    for (const char ch : text)
+    {
+        state = step(state, static_cast<unsigned char>(ch));
+        if (state == 0)
+        {
+            return -1;
+        }
+    }
+    return accepts[state];
+}
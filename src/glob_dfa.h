@@ -0,0 +1,72 @@
+/**
+ * @file glob_dfa.h
+ * @brief glob pattern matching with a lazily built DFA
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the declaration of the DFA used to dispatch case statements.
+ */
+
+
+#ifndef CASH_GLOB_DFA_H
+#define CASH_GLOB_DFA_H
+
+#include <bitset>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief Matches a word against many glob patterns at once.
+    *
+    * The patterns of all arms are compiled into one NFA whose states are
+    * (pattern, position) pairs. DFA states are sets of NFA states, built on
+    * first use and cached, so a word is matched in one pass over its bytes
+    * however many arms there are. Bytes are grouped into equivalence classes
+    * to keep transition tables small.
+    */
+    class GlobDfa
+    {
+    public:
+        /**
+        * @brief Compiles the patterns.
+        *
+        * @param arms alternative patterns of each arm, supporting *, ?, [...] and \ escapes.
+        */
+        explicit GlobDfa(const std::vector<std::vector<std::string>>& arms);
+
+        /**
+        * @brief Finds the first arm matching the whole text.
+        *
+        * @param text the word to match.
+        * @return the arm index, or -1 if no arm matches.
+        */
+        int match(const std::string& text);
+
+    private:
+        enum Kind { END, SET, STAR };
+
+        std::vector<Kind> kinds; //!< Element kind of each NFA state.
+        std::vector<std::bitset<256>> sets; //!< Bytes accepted by SET states.
+        std::vector<int> arms; //!< Arm owning each NFA state.
+
+        unsigned char classes[256]; //!< Byte to equivalence class.
+        int class_count; //!< Number of equivalence classes.
+
+        std::vector<std::vector<int>> states; //!< NFA state set of each DFA state.
+        std::map<std::vector<int>, int> ids; //!< NFA state set to DFA state.
+        std::vector<int> transitions; //!< states x classes, -1 when not built yet.
+        std::vector<int> accepts; //!< Arm accepted in each DFA state, or -1.
+        int start; //!< Initial DFA state.
+
+        void compile(const std::string& pattern, int arm);
+        void close(std::vector<int>& set) const;
+        int add(std::vector<int> set);
+        int step(int state, unsigned char byte);
+        void reset();
+    };
+}
+
+#endif //CASH_GLOB_DFA_H
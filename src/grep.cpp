@@ -0,0 +1,716 @@
+/**
+ * @file grep.cpp
+ * @brief the grep builtin, for fixed strings
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Searches whole buffers for the patterns instead of going line by line:
+ * lines are only found around a match, so input without matches costs one
+ * pass of the searcher. A single pattern is found by comparing its first
+ * and last bytes 16 positions at a time with SSE2, several patterns by an
+ * Aho-Corasick automaton over byte classes. Regular expressions and options
+ * this builtin does not know are left to the grep in PATH. Within a pipeline
+ * a fixed-string grep runs as a stage, fused with the builtins around it.
+ */
+
+#include <fcntl.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Options handled here, the others run the external grep
+    const std::string OPTIONS = "FGcvlnqhHse:";
+
+    // The first bytes of the patterns are looked for with SIMD when there are at most this many
+    const size_t MAX_FIRST_BYTES = 8;
+
+    /**
+    * @brief Finds any of a set of fixed strings, none of them containing a newline.
+    */
+    class Searcher
+    {
+    public:
+        explicit Searcher(const std::vector<std::string>& patterns);
+
+        /**
+        * @brief Finds the first match.
+        *
+        * @param begin start of the text, searching starts afresh here.
+        * @param end end of the text.
+        * @return a pointer into the first match found, or nullptr.
+        */
+        const char* find(const char* begin, const char* end) const;
+
+    private:
+        enum Mode { ALL, BYTE, SINGLE, MULTIPLE };
+
+        const char* find_single(const char* begin, const char* end) const;
+        const char* find_multiple(const char* begin, const char* end) const;
+
+        Mode mode;
+        std::string pattern; //!< The pattern in BYTE and SINGLE modes.
+
+        uint8_t classes[256]; //!< Byte class of every byte, 0 for bytes in no pattern.
+        size_t class_count = 1;
+        std::vector<uint32_t> transitions; //!< Next state, indexed by state * class_count + class.
+        std::vector<uint8_t> accepting; //!< Whether a pattern ends in a state.
+        std::string first_bytes; //!< Bytes that leave the start state.
+    };
+
+    Searcher::Searcher(const std::vector<std::string>& patterns) : mode(MULTIPLE), classes()
+    {
+        for (const auto& text : patterns)
+        {
+            // The empty string matches every line
+            if (text.empty())
+            {
+                mode = ALL;
+                return;
+            }
+        }
+        if (patterns.size() == 1)
+        {
+            pattern = patterns[0];
+            mode = pattern.size() == 1 ? BYTE : SINGLE;
+            return;
+        }
+
+        for (const auto& text : patterns)
+        {
+            for (const char ch : text)
+            {
+                uint8_t& type = classes[static_cast<unsigned char>(ch)];
+                if (type == 0)
+                {
+                    type = static_cast<uint8_t>(class_count++);
+                }
+            }
+        }
+
+        // Builds the trie, 0 meaning no edge since the root has no parent
+        std::vector<uint32_t> trie(class_count, 0);
+        accepting.assign(1, 0);
+        for (const auto& text : patterns)
+        {
+            uint32_t state = 0;
+            for (const char ch : text)
+            {
+                uint32_t& next = trie[state * class_count + classes[static_cast<unsigned char>(ch)]];
+                if (next == 0)
+                {
+                    next = static_cast<uint32_t>(accepting.size());
+                    accepting.push_back(0);
+                    trie.resize(accepting.size() * class_count, 0);
+                }
+                state = trie[state * class_count + classes[static_cast<unsigned char>(ch)]];
+            }
+            accepting[state] = 1;
+        }
+
+        // Turns the trie into a DFA breadth first, missing edges follow the failure links
+        transitions.assign(trie.size(), 0);
+        std::vector<uint32_t> failure(accepting.size(), 0), queue;
+        for (size_t c = 1; c < class_count; ++c)
+        {
+            transitions[c] = trie[c];
+            if (trie[c] != 0)
+            {
+                queue.push_back(trie[c]);
+            }
+        }
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            const uint32_t state = queue[head];
+            accepting[state] |= accepting[failure[state]];
+            for (size_t c = 0; c < class_count; ++c)
+            {
+                const uint32_t child = trie[state * class_count + c];
+                const uint32_t fallback = transitions[failure[state] * class_count + c];
+                if (c != 0 && child != 0)
+                {
+                    failure[child] = fallback;
+                    transitions[state * class_count + c] = child;
+                    queue.push_back(child);
+                }
+                else
+                {
+                    transitions[state * class_count + c] = fallback;
+                }
+            }
+        }
+
+        for (const auto& text : patterns)
+        {
+            if (first_bytes.find(text[0]) == std::string::npos)
+            {
+                first_bytes += text[0];
+            }
+        }
+    }
+
+    const char* Searcher::find(const char* begin, const char* end) const
+    {
+        switch (mode)
+        {
+        case ALL:
+            return begin;
+        case BYTE:
+            return static_cast<const char*>(std::memchr(begin, pattern[0], end - begin));
+        case SINGLE:
+            return find_single(begin, end);
+        default:
+            return find_multiple(begin, end);
+        }
+    }
+
+    const char* Searcher::find_single(const char* begin, const char* end) const
+    {
+        const size_t length = pattern.size();
+        const char* position = begin;
+#ifdef __SSE2__
+        // Positions where both the first and the last byte agree are checked in full
+        const __m128i first = _mm_set1_epi8(pattern[0]);
+        const __m128i last = _mm_set1_epi8(pattern[length - 1]);
+        for (; end - position >= static_cast<ptrdiff_t>(length + 15); position += 16)
+        {
+            const __m128i heads = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+            const __m128i tails = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + length - 1));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(heads, first), _mm_cmpeq_epi8(tails, last))));
+            while (mask != 0)
+            {
+                const char* candidate = position + __builtin_ctz(mask);
+                if (std::memcmp(candidate + 1, pattern.data() + 1, length - 2) == 0)
+                {
+                    return candidate;
+                }
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; end - position >= static_cast<ptrdiff_t>(length); ++position)
+        {
+            if (*position == pattern[0] && std::memcmp(position, pattern.data(), length) == 0)
+            {
+                return position;
+            }
+        }
+        return nullptr;
+    }
+
+    const char* Searcher::find_multiple(const char* begin, const char* end) const
+    {
+        uint32_t state = 0;
+        const char* position = begin;
+        while (position < end)
+        {
+#ifdef __SSE2__
+            // In the start state, skip blocks without the first byte of any pattern
+            if (state == 0 && first_bytes.size() <= MAX_FIRST_BYTES)
+            {
+                while (end - position >= 16)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+                    __m128i hits = _mm_setzero_si128();
+                    for (const char ch : first_bytes)
+                    {
+                        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(ch)));
+                    }
+                    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+                    if (mask != 0)
+                    {
+                        position += __builtin_ctz(mask);
+                        break;
+                    }
+                    position += 16;
+                }
+                if (position == end)
+                {
+                    break;
+                }
+            }
+#endif
+            state = transitions[state * class_count + classes[static_cast<unsigned char>(*position)]];
+            if (accepting[state])
+            {
+                return position;
+            }
+            ++position;
+        }
+        return nullptr;
+    }
+
+    /**
+    * @brief Settings from the command line.
+    */
+    struct Settings
+    {
+        bool invert = false;
+        bool count = false;
+        bool list = false;
+        bool quiet = false;
+        bool numbers = false;
+        bool names = false;
+    };
+
+    /**
+    * @brief Where the output of one input goes: the shared writer, or a string kept for ordering.
+    */
+    struct Sink
+    {
+        cash::Output* output = nullptr;
+        std::string text;
+
+        void write(const char* data, const size_t size)
+        {
+            if (output != nullptr)
+            {
+                output->write(data, size);
+            }
+            else
+            {
+                text.append(data, size);
+            }
+        }
+
+        void write(const std::string& data)
+        {
+            write(data.data(), data.size());
+        }
+    };
+
+    /**
+    * @brief Searches one input, which may arrive in several buffers of whole lines.
+    */
+    struct Scan
+    {
+        const Searcher& searcher;
+        const Settings& settings;
+        const std::string name;
+        Sink& sink;
+        uint64_t line_number = 0; //!< Lines before the position counted up to.
+        uint64_t selected = 0;
+        bool done = false; //!< Whether the answer is known without reading further.
+        cash::LineSplitter splitter;
+
+        Scan(const Searcher& searcher, const Settings& settings, const std::string& name, Sink& sink)
+            : searcher(searcher), settings(settings), name(name), sink(sink)
+        {
+        }
+
+        // A selected line, end excluding the newline
+        void select(const char* begin, const char* end, const char*& counted)
+        {
+            ++selected;
+            if (settings.quiet || settings.list)
+            {
+                done = true;
+                return;
+            }
+            if (settings.count)
+            {
+                return;
+            }
+            if (settings.names)
+            {
+                sink.write(name + ":");
+            }
+            if (settings.numbers)
+            {
+                line_number += cash::count_lines(counted, begin - counted);
+                counted = begin;
+                sink.write(std::to_string(line_number + 1) + ":");
+            }
+            sink.write(begin, end - begin);
+            sink.write("\n", 1);
+        }
+
+        // Selects all lines of a range without matches, for -v
+        void select_all(const char* begin, const char* end, const char*& counted)
+        {
+            if (begin == end)
+            {
+                return;
+            }
+            if (settings.count)
+            {
+                selected += cash::count_lines(begin, end - begin) + (end[-1] != '\n');
+                return;
+            }
+            while (begin < end && !done)
+            {
+                const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+                const char* line_end = newline != nullptr ? newline : end;
+                select(begin, line_end, counted);
+                begin = line_end + 1;
+            }
+        }
+
+        /**
+        * @brief Searches whole lines, the last one may lack its newline.
+        */
+        void lines(const char* data, const size_t size)
+        {
+            const char* end = data + size;
+            const char* position = data;
+            const char* counted = data;
+            while (position < end && !done)
+            {
+                const char* hit = searcher.find(position, end);
+                if (hit == nullptr)
+                {
+                    if (settings.invert)
+                    {
+                        select_all(position, end, counted);
+                    }
+                    break;
+                }
+                // Patterns hold no newline, so the match lies within one line
+                const char* before = static_cast<const char*>(memrchr(position, '\n', hit - position));
+                const char* line_begin = before != nullptr ? before + 1 : position;
+                const char* newline = static_cast<const char*>(std::memchr(hit, '\n', end - hit));
+                const char* line_end = newline != nullptr ? newline : end;
+                if (settings.invert)
+                {
+                    select_all(position, line_begin, counted);
+                }
+                else
+                {
+                    select(line_begin, line_end, counted);
+                }
+                position = line_end + 1;
+            }
+            if (settings.numbers)
+            {
+                line_number += cash::count_lines(counted, end - counted);
+            }
+        }
+
+        /**
+        * @brief Searches the next chunk of the input.
+        *
+        * @return false once the answer is known without reading further.
+        */
+        bool chunk(const char* data, const size_t size)
+        {
+            splitter.split(data, size, [this](const char* begin, const char* end)
+            {
+                lines(begin, end - begin);
+            });
+            return !done;
+        }
+
+        /**
+        * @brief Searches the last line, if it lacks a newline.
+        */
+        void end()
+        {
+            splitter.finish([this](const char* begin, const char* end)
+            {
+                if (!done)
+                {
+                    lines(begin, end - begin);
+                }
+            });
+        }
+
+        /**
+        * @brief Reads and searches an open input.
+        */
+        void run(const int fd)
+        {
+            cash::read_chunks(fd, [&](const char* data, const size_t size)
+            {
+                return chunk(data, size);
+            });
+            end();
+        }
+
+        // What is printed at the end: the count or the name
+        void finish()
+        {
+            if (settings.quiet)
+            {
+                return;
+            }
+            if (settings.list)
+            {
+                if (selected > 0)
+                {
+                    sink.write(name + "\n");
+                }
+                return;
+            }
+            if (settings.count)
+            {
+                sink.write((settings.names ? name + ":" : "") + std::to_string(selected) + "\n");
+            }
+        }
+    };
+
+    /**
+    * @brief What the command line asks for.
+    */
+    struct Command
+    {
+        std::vector<std::string> patterns;
+        Settings settings;
+        bool silent = false;
+        std::vector<std::string> operands;
+    };
+
+    // Reads the command line, false if it is for the grep in PATH: a regular expression, an unknown option or a usage error
+    bool parse(const std::vector<std::string>& args, Command& command)
+    {
+        std::map<char, std::string> options;
+        if (!cash::get_options(args, OPTIONS, options, command.operands, true))
+        {
+            return false;
+        }
+        std::string patterns;
+        if (options.count('e'))
+        {
+            patterns = options['e'];
+        }
+        else if (!command.operands.empty())
+        {
+            patterns = command.operands[0];
+            command.operands.erase(command.operands.begin());
+        }
+        else
+        {
+            return false;
+        }
+        // Without -F the patterns are basic regular expressions, only plain strings are handled here
+        if (!options.count('F') && patterns.find_first_of("\\.[]*^$") != std::string::npos)
+        {
+            return false;
+        }
+
+        size_t begin = 0;
+        while (true)
+        {
+            const size_t end = patterns.find('\n', begin);
+            command.patterns.push_back(patterns.substr(begin, end - begin));
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            begin = end + 1;
+        }
+
+        Settings& settings = command.settings;
+        settings.invert = options.count('v') != 0;
+        settings.count = options.count('c') != 0;
+        settings.list = options.count('l') != 0;
+        settings.quiet = options.count('q') != 0;
+        settings.numbers = options.count('n') != 0;
+        settings.names = (command.operands.size() > 1 || options.count('H')) && !options.count('h');
+        command.silent = options.count('s') != 0;
+        return true;
+    }
+
+    /**
+    * @brief One operand and its results.
+    */
+    struct Input
+    {
+        std::string name;
+        Sink sink;
+        uint64_t selected = 0;
+        bool failed = false;
+        bool finished = false;
+    };
+
+    /**
+    * @brief grep as a pipeline stage, searching its inputs one after the other.
+    */
+    class Grep : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the command line.
+        *
+        * @return false after reporting arguments only the grep in PATH handles.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            if (!parse(args, command))
+            {
+                cash::report("grep", "only fixed strings can be searched within a pipeline");
+                return false;
+            }
+            inputs = command.operands;
+            searcher.reset(new Searcher(command.patterns));
+            return true;
+        }
+
+        void begin_input(const std::string& name) override
+        {
+            close_scan();
+            scan.reset(new Scan(*searcher, command.settings, name == "-" ? "(standard input)" : name, sink));
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            if (!scan)
+            {
+                begin_input("-");
+            }
+            // With -q one selected line anywhere settles it
+            if (command.settings.quiet && selected > 0)
+            {
+                return false;
+            }
+            const bool more = scan->chunk(data, size);
+            return pass() && more;
+        }
+
+        void finish() override
+        {
+            close_scan();
+            end();
+        }
+
+        int status() const override
+        {
+            return selected > 0 ? 0 : 1;
+        }
+
+    private:
+        void close_scan()
+        {
+            if (scan)
+            {
+                scan->end();
+                scan->finish();
+                selected += scan->selected;
+                scan.reset();
+                pass();
+            }
+        }
+
+        // Passes on what the scan has written
+        bool pass()
+        {
+            const bool wanted = sink.text.empty() || emit(sink.text.data(), sink.text.size());
+            sink.text.clear();
+            return wanted;
+        }
+
+        Command command;
+        std::unique_ptr<Searcher> searcher;
+        Sink sink; //!< Collects the output of the scan, passed on after every chunk.
+        std::unique_ptr<Scan> scan; //!< The input being searched.
+        uint64_t selected = 0; //!< Lines selected in the inputs done.
+    };
+}
+
+int cash::grep(const std::vector<std::string>& args)
+{
+    Command command;
+    if (!parse(args, command))
+    {
+        return spawn(args);
+    }
+    const Searcher searcher(command.patterns);
+    const Settings& settings = command.settings;
+    const bool silent = command.silent;
+    std::vector<std::string>& operands = command.operands;
+    if (operands.empty())
+    {
+        operands.push_back("-");
+    }
+
+    std::vector<Input> inputs(operands.size());
+    Output output;
+    std::atomic<bool> stop(false);
+    std::mutex lock;
+    size_t next = 0;
+
+    auto search = [&](const size_t i)
+    {
+        Input& input = inputs[i];
+        input.name = operands[i] == "-" ? "(standard input)" : operands[i];
+        if (!stop)
+        {
+            const int fd = silent && operands[i] != "-" ? open(operands[i].c_str(), O_RDONLY | O_CLOEXEC)
+                                                         : open_input("grep", operands[i]);
+            input.failed = fd == -1;
+            if (fd != -1)
+            {
+                Scan scan(searcher, settings, input.name, input.sink);
+                scan.run(fd);
+                scan.finish();
+                close_input(fd);
+                input.selected = scan.selected;
+                if (settings.quiet && scan.selected > 0)
+                {
+                    stop = true;
+                }
+            }
+        }
+
+        // Results go out in the order of the operands, as soon as the earlier ones are out
+        std::lock_guard<std::mutex> guard(lock);
+        input.finished = true;
+        while (next < inputs.size() && inputs[next].finished)
+        {
+            output.write(inputs[next].sink.text);
+            std::string().swap(inputs[next].sink.text);
+            ++next;
+        }
+    };
+
+    if (inputs.size() == 1)
+    {
+        // A single input is written as it is searched
+        inputs[0].sink.output = &output;
+        search(0);
+    }
+    else
+    {
+        parallel_for(inputs.size(), search);
+    }
+
+    bool selected = false, failed = false;
+    for (const auto& input : inputs)
+    {
+        selected = selected || input.selected > 0;
+        failed = failed || input.failed;
+    }
+    if (failed && !(settings.quiet && selected))
+    {
+        return 2;
+    }
+    return selected ? 0 : 1;
+}
+
+bool cash::grep_in_process(const std::vector<std::string>& args)
+{
+    Command command;
+    return parse(args, command);
+}
+
+std::unique_ptr<cash::Stage> cash::grep_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Grep> stage(new Grep());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
@@ -0,0 +1,246 @@
+/**
+ * @file hashsum.cpp
+ * @brief the hashsum builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Prints or checks digests of files in the format of sha256sum, with the
+ * algorithm chosen by -a. Regular files are hashed straight from a mapping
+ * and several files are hashed at once, the lines still coming out in the
+ * order of the operands.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include "digest.h"
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    /**
+    * @brief A file to hash, and what became of it.
+    */
+    struct Job
+    {
+        std::string name;
+        std::string algorithm;
+        std::string expected; //!< The digest it should have, when checking.
+        std::string line; //!< What to print.
+        std::string error; //!< Why it could not be read, reported in its turn.
+        bool failed = false;
+        bool finished = false;
+    };
+
+    // Hashes an operand, false with the reason if it could not be read; runs on any thread, so reports nothing
+    bool hash(const std::string& algorithm, const std::string& operand, std::string& digest, std::string& error)
+    {
+        const int fd = operand == "-" ? STDIN_FILENO : open(operand.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            error = operand + ": " + strerror(errno);
+            return false;
+        }
+        std::unique_ptr<cash::Digest> state = cash::make_digest(algorithm);
+        const bool read = cash::read_chunks(fd, [&](const char* data, const size_t size)
+        {
+            state->update(data, size);
+            return true;
+        });
+        const int code = errno;
+        cash::close_input(fd);
+        if (!read)
+        {
+            error = operand + ": " + strerror(code);
+            return false;
+        }
+        digest = state->finish();
+        return true;
+    }
+
+    // The algorithm whose digests have this many hexadecimal digits
+    std::string guess_algorithm(const size_t digits)
+    {
+        for (const auto& name : cash::digest_names())
+        {
+            if (cash::make_digest(name)->finish().size() == digits)
+            {
+                return name;
+            }
+        }
+        return "";
+    }
+
+    /**
+    * @brief Reads the lines of a check file into jobs.
+    *
+    * Lines are a digest, a space, a space or an asterisk, and the file name.
+    *
+    * @param algorithm the algorithm from -a, or empty to tell it by the digest length.
+    * @return the number of lines that are not in that format, or -1 if the file cannot be read.
+    */
+    long read_checks(const std::string& operand, const std::string& algorithm, std::vector<Job>& jobs)
+    {
+        const int fd = cash::open_input("hashsum", operand);
+        if (fd == -1)
+        {
+            return -1;
+        }
+        std::string text;
+        const bool read = cash::read_chunks(fd, [&](const char* data, const size_t size)
+        {
+            text.append(data, size);
+            return true;
+        });
+        const int error = errno;
+        cash::close_input(fd);
+        if (!read)
+        {
+            cash::report("hashsum", operand + ": " + strerror(error));
+            return -1;
+        }
+
+        long malformed = 0;
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos)
+            {
+                end = text.size();
+            }
+            const std::string line = text.substr(start, end - start);
+            start = end + 1;
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+            const size_t digits = line.find(' ');
+            Job job;
+            job.algorithm = algorithm.empty() && digits != std::string::npos ? guess_algorithm(digits) : algorithm;
+            if (digits == std::string::npos || digits == 0 || digits + 2 >= line.size()
+                || (line[digits + 1] != ' ' && line[digits + 1] != '*') || job.algorithm.empty()
+                || line.find_first_not_of("0123456789abcdefABCDEF") != digits)
+            {
+                ++malformed;
+                continue;
+            }
+            job.expected = line.substr(0, digits);
+            for (auto& ch : job.expected)
+            {
+                ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+            }
+            job.name = line.substr(digits + 2);
+            jobs.push_back(job);
+        }
+        return malformed;
+    }
+}
+
+int cash::hashsum(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    if (!get_options(args, "a:c", options, operands))
+    {
+        return 1;
+    }
+    const bool check = options.count('c') > 0;
+    std::string algorithm = options.count('a') ? options['a'] : check ? "" : "sha256";
+    if (!algorithm.empty() && make_digest(algorithm) == nullptr)
+    {
+        std::string known;
+        for (const auto& name : digest_names())
+        {
+            known += (known.empty() ? "" : ", ") + name;
+        }
+        report("hashsum", "unknown algorithm '" + algorithm + "', expected one of " + known);
+        return 1;
+    }
+    if (operands.empty())
+    {
+        operands.push_back("-");
+    }
+
+    std::vector<Job> jobs;
+    int status = 0;
+    long malformed = 0;
+    if (check)
+    {
+        for (const auto& operand : operands)
+        {
+            const long bad = read_checks(operand, algorithm, jobs);
+            if (bad < 0)
+            {
+                status = 1;
+                continue;
+            }
+            malformed += bad;
+        }
+    }
+    else
+    {
+        for (const auto& operand : operands)
+        {
+            Job job;
+            job.name = operand;
+            job.algorithm = algorithm;
+            jobs.push_back(job);
+        }
+    }
+
+    Output output;
+    std::mutex lock;
+    size_t next = 0;
+    parallel_for(jobs.size(), [&](const size_t i)
+    {
+        Job& job = jobs[i];
+        std::string digest;
+        job.failed = !hash(job.algorithm, job.name, digest, job.error);
+        if (check)
+        {
+            job.line = job.name + (job.failed ? ": FAILED open or read\n" : digest == job.expected ? ": OK\n" : ": FAILED\n");
+            job.failed = job.failed || digest != job.expected;
+        }
+        else if (!job.failed)
+        {
+            job.line = digest + "  " + job.name + "\n";
+        }
+
+        // Lines and errors go out in the order of the operands, as soon as the earlier ones are out
+        std::lock_guard<std::mutex> guard(lock);
+        job.finished = true;
+        while (next < jobs.size() && jobs[next].finished)
+        {
+            if (!jobs[next].error.empty())
+            {
+                output.flush();
+                report("hashsum", jobs[next].error);
+            }
+            output.write(jobs[next].line);
+            ++next;
+        }
+    });
+    output.flush();
+
+    size_t failed = 0;
+    for (const auto& job : jobs)
+    {
+        failed += job.failed ? 1 : 0;
+    }
+    if (malformed > 0)
+    {
+        report("hashsum", "WARNING: " + std::to_string(malformed) + " line(s) are improperly formatted");
+    }
+    if (check && failed > 0)
+    {
+        report("hashsum", "WARNING: " + std::to_string(failed) + " computed checksum(s) did NOT match");
+    }
+    return status != 0 || failed > 0 || (check && jobs.empty()) ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file head.cpp
+ * @brief the head builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * head is a stage that stops asking for input once it has its lines. The
+ * pipe from the stage before is then closed, so a producer like yes gets
+ * SIGPIPE on its next write instead of running on. Mapped files are only
+ * touched as far as the lines printed.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    /**
+    * @brief Parses a count of lines or bytes.
+    *
+    * @return false if the text is not a number, or too long for one.
+    */
+    bool parse_count(const std::string& text, uint64_t& count)
+    {
+        if (text.empty() || text.size() > 18 || text.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        count = std::stoull(text);
+        return true;
+    }
+
+    /**
+    * @brief head as a pipeline stage.
+    */
+    class Head : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the options.
+        *
+        * @param quiet whether to fail without reporting, when only checking the arguments.
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(std::vector<std::string> args, const bool quiet = false)
+        {
+            // head -5 is head -n 5
+            if (args.size() > 1 && args[1].size() > 1 && args[1][0] == '-'
+                && args[1].find_first_not_of("0123456789", 1) == std::string::npos)
+            {
+                args[1] = "-n" + args[1].substr(1);
+            }
+            std::map<char, std::string> options;
+            if (!cash::get_options(args, "n:c:qv", options, inputs, quiet))
+            {
+                return false;
+            }
+            bytes = options.count('c') != 0;
+            const std::string count = bytes ? options['c'] : options.count('n') ? options['n'] : "10";
+            if (!parse_count(count, limit))
+            {
+                if (quiet)
+                {
+                    return false;
+                }
+                cash::report("head", "invalid number of " + std::string(bytes ? "bytes" : "lines") + ": '" + count + "'");
+                return false;
+            }
+            headers = (inputs.size() > 1 || options.count('v')) && !options.count('q');
+            remaining = limit;
+            return true;
+        }
+
+        void begin_input(const std::string& name) override
+        {
+            remaining = limit;
+            if (headers)
+            {
+                const std::string header = (first ? "" : "\n") + std::string("==> ")
+                    + (name == "-" ? "standard input" : name) + " <==\n";
+                emit(header.data(), header.size());
+            }
+            first = false;
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            if (remaining == 0)
+            {
+                return false;
+            }
+            size_t taken = size;
+            if (bytes)
+            {
+                taken = static_cast<size_t>(std::min<uint64_t>(remaining, size));
+                remaining -= taken;
+            }
+            else
+            {
+                const char* position = data;
+                const char* end = data + size;
+                while (remaining > 0)
+                {
+                    const char* newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+                    if (newline == nullptr)
+                    {
+                        break;
+                    }
+                    position = newline + 1;
+                    --remaining;
+                }
+                if (remaining == 0)
+                {
+                    taken = position - data;
+                }
+            }
+            return emit(data, taken) && remaining > 0;
+        }
+
+    private:
+        bool bytes = false; //!< Whether the limit counts bytes rather than lines.
+        uint64_t limit = 10;
+        uint64_t remaining = 10; //!< Lines or bytes still to print from the current input.
+        bool headers = false; //!< Whether every input gets a ==> name <== header.
+        bool first = true;
+    };
+}
+
+std::unique_ptr<cash::Stage> cash::head_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Head> stage(new Head());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+bool cash::head_in_process(const std::vector<std::string>& args)
+{
+    Head head;
+    return head.compile(args, true);
+}
+
+int cash::head(const std::vector<std::string>& args)
+{
+    // Counts like -n -3 or -c 1K, and other options, run the head in PATH
+    if (!head_in_process(args))
+    {
+        return spawn(args);
+    }
+    return run_stages({args});
+}
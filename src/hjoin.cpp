@@ -0,0 +1,370 @@
+/**
+ * @file hjoin.cpp
+ * @brief the hjoin builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Joins the lines of two files on a field, like join, without sorting
+ * them first: the lines of the smaller file are put in a hash table by
+ * their key, and those of the larger one stream past it, each printed
+ * with the lines it matches as soon as it is read. Standard input is
+ * always the side that streams, so hjoin can follow other filters. The
+ * table side stays mapped and only its keys are copied.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include "filters.h"
+#include "stream.h"
+#include "table.h"
+
+namespace
+{
+    /**
+    * @brief Bytes of a line or a field.
+    */
+    struct Span
+    {
+        const char* data;
+        size_t size;
+    };
+
+    /**
+    * @brief The lines of the table side with a key, chained in the order they came.
+    */
+    struct Group
+    {
+        uint32_t first = 0; //!< Line index + 1 of the first line, 0 for none.
+        uint32_t last = 0; //!< Line index + 1 of the last line.
+    };
+
+    /**
+    * @brief hjoin as a pipeline stage, reading the side that streams.
+    */
+    class HashJoin : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the options and loads the smaller file into the table.
+        *
+        * @return false after reporting invalid arguments or a file that cannot be read.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            std::vector<std::string> operands;
+            if (!cash::get_options(args, "1:2:a:j:t:v:", options, operands))
+            {
+                return false;
+            }
+            if (operands.size() != 2)
+            {
+                cash::report("hjoin", "usage: hjoin [-1 field] [-2 field] [-t char] [-a 1|2] [-v 1|2] file1 file2");
+                return false;
+            }
+            if (operands[0] == "-" && operands[1] == "-")
+            {
+                cash::report("hjoin", "both files cannot be standard input");
+                return false;
+            }
+            if (options.count('j'))
+            {
+                options['1'] = options['2'] = options['j'];
+            }
+            for (int side = 0; side < 2; ++side)
+            {
+                const char option = "12"[side];
+                if (options.count(option) && !parse(options[option], fields[side]))
+                {
+                    cash::report("hjoin", "invalid field '" + options[option] + "'");
+                    return false;
+                }
+            }
+            if (options.count('t'))
+            {
+                if (options['t'].size() != 1 || options['t'][0] == '\n')
+                {
+                    cash::report("hjoin", "the delimiter must be a single character");
+                    return false;
+                }
+                separator = options['t'][0];
+            }
+            // -a prints the lines of a file that pair with none too, -v only those
+            for (const char option : {'a', 'v'})
+            {
+                if (options.count(option) == 0)
+                {
+                    continue;
+                }
+                const std::string& list = options[option];
+                for (size_t begin = 0; begin <= list.size();)
+                {
+                    const size_t newline = std::min(list.find('\n', begin), list.size());
+                    const std::string side = list.substr(begin, newline - begin);
+                    if (side != "1" && side != "2")
+                    {
+                        cash::report("hjoin", "invalid file number '" + side + "'");
+                        return false;
+                    }
+                    unpaired[side[0] - '1'] = true;
+                    begin = newline + 1;
+                }
+            }
+            paired = options.count('v') == 0;
+
+            // The smaller file goes in the table; standard input, and other files that are not regular, stream
+            struct stat info[2];
+            bool regular[2];
+            for (int side = 0; side < 2; ++side)
+            {
+                regular[side] = operands[side] != "-" && stat(operands[side].c_str(), &info[side]) == 0
+                                && S_ISREG(info[side].st_mode);
+            }
+            if (operands[1] == "-" || (regular[0] && !regular[1]))
+            {
+                built = 0;
+            }
+            else if (regular[0] && regular[1])
+            {
+                built = info[0].st_size <= info[1].st_size ? 0 : 1;
+            }
+            if (operands[1 - built] != "-")
+            {
+                inputs.push_back(operands[1 - built]);
+            }
+            return load(operands[built]);
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            splitter.split(data, size, [this](const char* begin, const char* end)
+            {
+                probe_lines(begin, end);
+            });
+            return pass();
+        }
+
+        void finish() override
+        {
+            splitter.finish([this](const char* begin, const char* end)
+            {
+                probe_lines(begin, end);
+            });
+            // Lines of the table no line matched, in their order
+            if (unpaired[built])
+            {
+                for (size_t l = 0; l < lines.size(); ++l)
+                {
+                    if (!matched[l])
+                    {
+                        alone(lines[l], built);
+                    }
+                    if (buffer.size() >= BUFFER_SIZE && !pass())
+                    {
+                        break;
+                    }
+                }
+            }
+            pass();
+            end();
+        }
+
+    private:
+        // The output is passed on about this often
+        static const size_t BUFFER_SIZE = 1 << 16;
+
+        static bool parse(const std::string& text, size_t& value)
+        {
+            if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+            {
+                return false;
+            }
+            value = std::stoul(text);
+            return value >= 1;
+        }
+
+        /**
+        * @brief Reads the file of the table and puts its lines in it.
+        *
+        * @return false after reporting an error.
+        */
+        bool load(const std::string& path)
+        {
+            const int fd = cash::open_input("hjoin", path);
+            if (fd == -1)
+            {
+                return false;
+            }
+            Span text{nullptr, 0};
+            if (mapped.map(fd))
+            {
+                text = Span{mapped.data(), mapped.size()};
+            }
+            else
+            {
+                const bool read = cash::read_chunks(fd, [&](const char* data, const size_t size)
+                {
+                    owned.append(data, size);
+                    return true;
+                });
+                if (!read)
+                {
+                    cash::report("hjoin", path + ": " + strerror(errno));
+                    cash::close_input(fd);
+                    return false;
+                }
+                text = Span{owned.data(), owned.size()};
+            }
+            cash::close_input(fd);
+
+            cash::for_each_line(text.data, text.data + text.size, [&](const char* data, const size_t size)
+            {
+                const Span line{data, size};
+                const Span found = key(line, fields[built]);
+                Group& group = table(found.data, found.size);
+                lines.push_back(line);
+                next.push_back(0);
+                const uint32_t index = static_cast<uint32_t>(lines.size());
+                if (group.last != 0)
+                {
+                    next[group.last - 1] = index;
+                }
+                else
+                {
+                    group.first = index;
+                }
+                group.last = index;
+            });
+            matched.assign(lines.size(), false);
+            return true;
+        }
+
+        // The join field of a line, empty if it has fewer fields
+        Span key(const Span& line, const size_t field) const
+        {
+            const char* begin = line.data;
+            const char* stop = cash::nth_field(begin, line.data + line.size, field, separator);
+            return Span{begin, static_cast<size_t>(stop - begin)};
+        }
+
+        // Appends the fields of a line but its join field, each after a separator
+        void append_rest(const Span& line, const size_t field)
+        {
+            const char* end = line.data + line.size;
+            const char* begin = line.data;
+            // Empty fields count with -t, as in join -t; blanks at the end make no field without
+            for (size_t f = 1;; ++f)
+            {
+                const char* stop = cash::field_end(begin, end, separator);
+                if (separator == '\0' && begin == end)
+                {
+                    return;
+                }
+                if (f != field)
+                {
+                    buffer += separator != '\0' ? separator : ' ';
+                    buffer.append(begin, stop - begin);
+                }
+                if (stop == end)
+                {
+                    return;
+                }
+                begin = cash::next_field(stop, end, separator);
+            }
+        }
+
+        // Appends a line of the first file joined with one of the second
+        void joined(const Span& key, const Span& first, const Span& second)
+        {
+            buffer.append(key.data, key.size);
+            append_rest(first, fields[0]);
+            append_rest(second, fields[1]);
+            buffer += '\n';
+        }
+
+        // Appends a line that paired with none, join field first
+        void alone(const Span& line, const int side)
+        {
+            const Span found = key(line, fields[side]);
+            buffer.append(found.data, found.size);
+            append_rest(line, fields[side]);
+            buffer += '\n';
+        }
+
+        // Joins a line of the streaming side with the lines of the table that have its key
+        void probe_lines(const char* begin, const char* end)
+        {
+            cash::for_each_line(begin, end, [this](const char* line, const size_t length)
+            {
+                probe(Span{line, length});
+            });
+        }
+
+        void probe(const Span& line)
+        {
+            const int side = 1 - built;
+            const Span found = key(line, fields[side]);
+            const Group* group = table.find(found.data, found.size);
+            if (group == nullptr)
+            {
+                if (unpaired[side])
+                {
+                    alone(line, side);
+                }
+                return;
+            }
+            for (uint32_t l = group->first; l != 0; l = next[l - 1])
+            {
+                matched[l - 1] = true;
+                if (paired)
+                {
+                    const Span& other = lines[l - 1];
+                    joined(found, built == 0 ? other : line, built == 0 ? line : other);
+                }
+            }
+        }
+
+        // Passes on the output so far
+        bool pass()
+        {
+            const bool wanted = buffer.empty() || emit(buffer.data(), buffer.size());
+            buffer.clear();
+            return wanted;
+        }
+
+        size_t fields[2] = {1, 1}; //!< The join field of each file, from 1.
+        char separator = '\0'; //!< Field separator, or '\0' for runs of blanks.
+        bool unpaired[2] = {false, false}; //!< Whether the lines of each file that pair with none are printed.
+        bool paired = true; //!< Whether joined lines are printed, all but -v.
+        int built = 1; //!< The file in the table, 0 or 1.
+
+        cash::MappedFile mapped; //!< The file of the table, if regular.
+        std::string owned; //!< The file of the table otherwise.
+        std::vector<Span> lines; //!< The lines of the table side.
+        std::vector<uint32_t> next; //!< The next line with the same key, index + 1, for each line.
+        std::vector<bool> matched; //!< Whether each line of the table paired with one.
+        cash::KeyTable<Group> table;
+
+        cash::LineSplitter splitter;
+        std::string buffer; //!< Output of a chunk, kept for its capacity.
+    };
+}
+
+std::unique_ptr<cash::Stage> cash::hjoin_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<HashJoin> stage(new HashJoin());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+int cash::hjoin(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
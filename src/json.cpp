@@ -0,0 +1,1267 @@
+/**
+ * @file json.cpp
+ * @brief the json builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Selects values from JSON and NDJSON with jq's paths, as in
+ * json -r -w ".status >= 500" .request.path,.status log.ndjson. The input is
+ * never made into a tree: a first pass finds the quotes outside escapes and
+ * the brackets, colons and commas outside strings 64 bytes at a time with
+ * SSE2, like simdjson, and paths are followed over those positions, stepping
+ * over the values they do not go into by matching brackets. Only selected
+ * values are decoded, and values stepped over are only checked that far.
+ * Large inputs are cut at newlines into pieces parsed in parallel, which is
+ * right when there is a value per line; a piece ending inside a value shows
+ * otherwise, and the rest of the input is then parsed in order.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Values are first indexed this many bytes at a time, more for larger ones
+    const size_t WINDOW = 1 << 16;
+
+    // Inputs are cut into pieces of about this size to be parsed in parallel
+    const size_t PIECE_SIZE = 1 << 22;
+
+    // Bits of the quotes, backslashes and structural characters of 64 bytes
+    inline void classify(const char* block, uint64_t& quotes, uint64_t& backslashes, uint64_t& structurals)
+    {
+        quotes = backslashes = structurals = 0;
+#ifdef __SSE2__
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lower = _mm_set1_epi8(0x20);
+        const __m128i open = _mm_set1_epi8('{');
+        const __m128i close = _mm_set1_epi8('}');
+        const __m128i colon = _mm_set1_epi8(':');
+        const __m128i comma = _mm_set1_epi8(',');
+        for (int shift = 0; shift < 64; shift += 16)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + shift));
+            // [ and ] are { and } with a bit cleared
+            const __m128i folded = _mm_or_si128(bytes, lower);
+            const __m128i structural = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma)));
+            quotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << shift;
+            backslashes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash)))) << shift;
+            structurals |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(structural))) << shift;
+        }
+#else
+        for (int i = 0; i < 64; ++i)
+        {
+            const char c = block[i];
+            const uint64_t bit = uint64_t(1) << i;
+            quotes |= c == '"' ? bit : 0;
+            backslashes |= c == '\\' ? bit : 0;
+            structurals |= c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',' ? bit : 0;
+        }
+#endif
+    }
+
+    // The characters after a run of backslashes of odd length, which escape them
+    inline uint64_t escaped(const uint64_t backslashes, uint64_t& odd_carry)
+    {
+        const uint64_t even_bits = 0x5555555555555555ULL;
+        const uint64_t starts = backslashes & ~(backslashes << 1);
+        // A run going on from the block before starts at an odd place if it was odd there
+        const uint64_t even_start_mask = even_bits ^ odd_carry;
+        const uint64_t even_starts = starts & even_start_mask;
+        const uint64_t odd_starts = starts & ~even_start_mask;
+        const uint64_t even_carries = backslashes + even_starts;
+        uint64_t odd_carries;
+        const bool overflow = __builtin_add_overflow(backslashes, odd_starts, &odd_carries);
+        odd_carries |= odd_carry;
+        odd_carry = overflow ? 1 : 0;
+        // Adding a run's start carries out at its end, whose place tells the parity of its length
+        const uint64_t even_ends = even_carries & ~backslashes;
+        const uint64_t odd_ends = odd_carries & ~backslashes;
+        return (even_ends & ~even_bits) | (odd_ends & even_bits);
+    }
+
+    inline bool is_space(const char c)
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+    }
+
+    inline const char* skip_space(const char* at, const char* end)
+    {
+        while (at < end && is_space(*at))
+        {
+            ++at;
+        }
+        return at;
+    }
+
+    inline bool is_digit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // Whether text is a number as JSON writes them
+    bool is_number(const char* at, const char* end)
+    {
+        if (at < end && *at == '-')
+        {
+            ++at;
+        }
+        if (at == end || !is_digit(*at))
+        {
+            return false;
+        }
+        if (*at++ != '0')
+        {
+            while (at < end && is_digit(*at))
+            {
+                ++at;
+            }
+        }
+        for (const char* marks : {".", "eE"})
+        {
+            if (at == end || !std::strchr(marks, *at))
+            {
+                continue;
+            }
+            ++at;
+            if (*marks == 'e' && at < end && (*at == '+' || *at == '-'))
+            {
+                ++at;
+            }
+            if (at == end || !is_digit(*at))
+            {
+                return false;
+            }
+            while (at < end && is_digit(*at))
+            {
+                ++at;
+            }
+        }
+        return at == end;
+    }
+
+    // The value of a number, which is_number accepted
+    double number(const char* at, const char* end)
+    {
+        const std::string text(at, end);
+        return std::strtod(text.c_str(), nullptr);
+    }
+
+    inline int hex(const char c)
+    {
+        if (is_digit(c))
+        {
+            return c - '0';
+        }
+        if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        {
+            return (c | 0x20) - 'a' + 10;
+        }
+        return -1;
+    }
+
+    // Reads the 4 hex digits of a \u escape, or returns -1
+    long code_unit(const char* at, const char* end)
+    {
+        if (end - at < 4)
+        {
+            return -1;
+        }
+        long unit = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const int digit = hex(at[i]);
+            if (digit < 0)
+            {
+                return -1;
+            }
+            unit = unit << 4 | digit;
+        }
+        return unit;
+    }
+
+    void append_utf8(const unsigned long code, std::string& out)
+    {
+        if (code < 0x80)
+        {
+            out += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xc0 | code >> 6);
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xe0 | code >> 12);
+            out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else
+        {
+            out += static_cast<char>(0xf0 | code >> 18);
+            out += static_cast<char>(0x80 | (code >> 12 & 0x3f));
+            out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    /**
+    * @brief Appends the text of a string, between its quotes, with the escapes undone.
+    *
+    * Invalid escapes are kept as they are.
+    */
+    void unescape(const char* at, const char* end, std::string& out)
+    {
+        while (at < end)
+        {
+            const char* backslash = static_cast<const char*>(std::memchr(at, '\\', end - at));
+            if (backslash == nullptr || backslash + 1 == end)
+            {
+                out.append(at, end - at);
+                return;
+            }
+            out.append(at, backslash - at);
+            at = backslash + 2;
+            static const char* const codes = "\"\"\\\\//b\bf\fn\nr\rt\t";
+            const char* code = std::strchr(codes, backslash[1]);
+            if (code != nullptr && (code - codes) % 2 == 0)
+            {
+                out += code[1];
+                continue;
+            }
+            long unit = backslash[1] == 'u' ? code_unit(at, end) : -1;
+            if (unit < 0)
+            {
+                out.append(backslash, 2);
+                continue;
+            }
+            at += 4;
+            // Characters past the first plane take two units, a surrogate pair
+            if (unit >= 0xd800 && unit < 0xdc00 && end - at >= 6 && at[0] == '\\' && at[1] == 'u')
+            {
+                const long low = code_unit(at + 2, end);
+                if (low >= 0xdc00 && low < 0xe000)
+                {
+                    unit = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+                    at += 6;
+                }
+            }
+            append_utf8(static_cast<unsigned long>(unit), out);
+        }
+    }
+
+    /**
+    * @brief One step of a path: a key of objects, an index of arrays, or every element of either.
+    */
+    struct Step
+    {
+        enum Kind
+        {
+            KEY,
+            INDEX,
+            EACH
+        };
+
+        Kind kind;
+        std::string key;
+        size_t index;
+    };
+
+    typedef std::vector<Step> Path;
+
+    /**
+    * @brief Reads a path like .items[0].name, ."odd key" or .[], up to a comma or a space.
+    *
+    * @param at where the path starts, set to where it ends.
+    * @return false if it is not a path.
+    */
+    bool parse_path(const std::string& text, size_t& at, Path& path)
+    {
+        if (at >= text.size() || text[at] != '.')
+        {
+            return false;
+        }
+        // A lone dot is the whole value
+        if (at + 1 == text.size() || text[at + 1] == ',' || is_space(text[at + 1]))
+        {
+            ++at;
+            return true;
+        }
+        while (at < text.size() && (text[at] == '.' || text[at] == '['))
+        {
+            if (text[at] == '.')
+            {
+                ++at;
+                if (at < text.size() && text[at] == '[')
+                {
+                    continue;
+                }
+                Step step{Step::KEY, std::string(), 0};
+                if (at < text.size() && text[at] == '"')
+                {
+                    const size_t close = text.find('"', at + 1);
+                    if (close == std::string::npos)
+                    {
+                        return false;
+                    }
+                    step.key = text.substr(at + 1, close - at - 1);
+                    at = close + 1;
+                }
+                else
+                {
+                    const size_t begin = at;
+                    while (at < text.size() && (std::isalnum(static_cast<unsigned char>(text[at])) || text[at] == '_'))
+                    {
+                        ++at;
+                    }
+                    if (at == begin || is_digit(text[begin]))
+                    {
+                        return false;
+                    }
+                    step.key = text.substr(begin, at - begin);
+                }
+                path.push_back(step);
+                continue;
+            }
+            const size_t close = text.find(']', at);
+            if (close == std::string::npos)
+            {
+                return false;
+            }
+            const std::string inside = text.substr(at + 1, close - at - 1);
+            if (inside.empty())
+            {
+                path.push_back(Step{Step::EACH, std::string(), 0});
+            }
+            else if (inside.find_first_not_of("0123456789") == std::string::npos && inside.size() < 19)
+            {
+                path.push_back(Step{Step::INDEX, std::string(), std::stoul(inside)});
+            }
+            else
+            {
+                return false;
+            }
+            at = close + 1;
+        }
+        return true;
+    }
+
+    /**
+    * @brief A value to compare, as -w conditions and literals see it.
+    */
+    struct Operand
+    {
+        enum Kind
+        {
+            NUMBER,
+            STRING,
+            OTHER //!< true, false, null, objects and arrays, compared as written.
+        };
+
+        Kind kind = OTHER;
+        double value = 0;
+        std::string text; //!< Strings unescaped, others as written.
+    };
+
+    /**
+    * @brief A condition of -w: the value at a path compared with a literal.
+    */
+    struct Condition
+    {
+        enum Operator
+        {
+            EQUAL,
+            NOT_EQUAL,
+            LESS,
+            LESS_EQUAL,
+            GREATER,
+            GREATER_EQUAL,
+            CONTAINS
+        };
+
+        Path path;
+        Operator test = EQUAL;
+        Operand literal;
+
+        /**
+        * @brief Reads a condition: path, operator and a value, a JSON literal or a bare word.
+        *
+        * @return false if it is not one.
+        */
+        bool parse(const std::string& text)
+        {
+            static const std::map<std::string, Operator> operators = {
+                {"==", EQUAL}, {"=", EQUAL}, {"eq", EQUAL}, {"!=", NOT_EQUAL}, {"ne", NOT_EQUAL},
+                {"<", LESS}, {"lt", LESS}, {"<=", LESS_EQUAL}, {"le", LESS_EQUAL},
+                {">", GREATER}, {"gt", GREATER}, {">=", GREATER_EQUAL}, {"ge", GREATER_EQUAL},
+                {"contains", CONTAINS},
+            };
+            size_t at = text.find_first_not_of(" \t");
+            if (at == std::string::npos || !parse_path(text, at, path) || at == text.size() || !is_space(text[at]))
+            {
+                return false;
+            }
+            for (const Step& step : path)
+            {
+                // A condition tests one value
+                if (step.kind == Step::EACH)
+                {
+                    return false;
+                }
+            }
+            const size_t begin = text.find_first_not_of(" \t", at);
+            const size_t end = text.find_first_of(" \t", begin);
+            if (begin == std::string::npos || end == std::string::npos || operators.count(text.substr(begin, end - begin)) == 0)
+            {
+                return false;
+            }
+            test = operators.at(text.substr(begin, end - begin));
+            const size_t first = text.find_first_not_of(" \t", end);
+            if (first == std::string::npos)
+            {
+                return false;
+            }
+            const std::string value = text.substr(first, text.find_last_not_of(" \t") + 1 - first);
+            const char* data = value.data();
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            {
+                literal.kind = Operand::STRING;
+                unescape(data + 1, data + value.size() - 1, literal.text);
+            }
+            else if (is_number(data, data + value.size()))
+            {
+                literal.kind = Operand::NUMBER;
+                literal.value = number(data, data + value.size());
+            }
+            else
+            {
+                literal.kind = value == "true" || value == "false" || value == "null" ? Operand::OTHER : Operand::STRING;
+                literal.text = value;
+            }
+            return true;
+        }
+
+        // Whether a value passes
+        bool holds(const Operand& operand) const
+        {
+            if (test == CONTAINS)
+            {
+                return operand.kind == Operand::STRING && literal.kind == Operand::STRING
+                       && operand.text.find(literal.text) != std::string::npos;
+            }
+            if (operand.kind != literal.kind)
+            {
+                // Values of different types are only ever unequal
+                return test == NOT_EQUAL;
+            }
+            int order;
+            if (operand.kind == Operand::NUMBER)
+            {
+                order = operand.value < literal.value ? -1 : operand.value > literal.value ? 1 : 0;
+            }
+            else
+            {
+                order = operand.text.compare(literal.text);
+                if (operand.kind == Operand::OTHER && test != EQUAL && test != NOT_EQUAL)
+                {
+                    return false;
+                }
+            }
+            switch (test)
+            {
+            case EQUAL:
+                return order == 0;
+            case NOT_EQUAL:
+                return order != 0;
+            case LESS:
+                return order < 0;
+            case LESS_EQUAL:
+                return order <= 0;
+            case GREATER:
+                return order > 0;
+            default:
+                return order >= 0;
+            }
+        }
+    };
+
+    /**
+    * @brief What json does with every value of the input.
+    */
+    struct Query
+    {
+        std::vector<Path> paths; //!< Values to print.
+        std::vector<Condition> conditions; //!< Tests for values to pass, all of them.
+        bool raw = false; //!< Whether strings are printed without quotes or escapes, for -r.
+        bool tabs = false; //!< Whether the values of a record go on one line, separated by tabs, for -t.
+    };
+
+    /**
+    * @brief Runs a query over a range of the input, one instance per piece parsed in parallel.
+    */
+    class Scanner
+    {
+    public:
+        explicit Scanner(const Query& query)
+            : query(&query)
+        {
+        }
+
+        /**
+        * @brief Runs the query over the values of a range that starts outside any value.
+        *
+        * @param last whether the range ends the input, so a value cut at its end is an error.
+        * @param out where the output is appended.
+        * @return the start of a value the range ends inside, or end; nullptr on invalid JSON.
+        */
+        const char* run(const char* begin, const char* end, const bool last, std::string& out)
+        {
+            this->end = end;
+            this->last = last;
+            problem.clear();
+            size_t window = WINDOW;
+            start(begin, window);
+            size_t i = 0;
+            const char* next = begin;
+            while (true)
+            {
+                const char* value = skip_space(next, end);
+                if (value == end)
+                {
+                    return end;
+                }
+                const size_t first = i;
+                const char* after;
+                const Result result = skip(value, i, after);
+                if (result == BAD)
+                {
+                    return nullptr;
+                }
+                if (result == SHORT)
+                {
+                    if (indexed == end)
+                    {
+                        return last ? invalid(value, "the input ends inside a value") : value;
+                    }
+                    if (value == base)
+                    {
+                        // Larger than the window, which grows
+                        window *= 2;
+                        if (window > UINT32_MAX)
+                        {
+                            return invalid(value, "a value is larger than 4 GB");
+                        }
+                        extend(end - base > static_cast<ptrdiff_t>(window) ? base + window : end);
+                    }
+                    else
+                    {
+                        start(value, window);
+                    }
+                    i = 0;
+                    next = value;
+                    continue;
+                }
+                if (!select(value, first, out))
+                {
+                    return nullptr;
+                }
+                next = after;
+            }
+        }
+
+        std::string problem; //!< Why the JSON is invalid.
+        const char* error = nullptr; //!< Where the JSON is invalid.
+
+    private:
+        enum Result
+        {
+            DONE,
+            SHORT, //!< The value goes on past what is indexed.
+            BAD
+        };
+
+        /**
+        * @brief A value found at the end of a path.
+        */
+        struct Match
+        {
+            const char* value;
+            size_t entry; //!< The first position at or after it.
+        };
+
+        const char* invalid(const char* at, const std::string& why)
+        {
+            error = at;
+            problem = why;
+            return nullptr;
+        }
+
+        const char* at(const size_t entry) const
+        {
+            return base + positions[entry];
+        }
+
+        // Starts a window of positions at a value
+        void start(const char* value, const size_t window)
+        {
+            base = indexed = value;
+            count = 0;
+            inside = odd_backslash = 0;
+            extend(end - value > static_cast<ptrdiff_t>(window) ? value + window : end);
+        }
+
+        // Indexes the window up to a multiple of 64 bytes from its start, or the end
+        void extend(const char* to)
+        {
+            char padded[64];
+            while (indexed < to)
+            {
+                const char* block = indexed;
+                const size_t size = std::min<size_t>(64, to - indexed);
+                if (size < 64)
+                {
+                    std::memset(padded, 0, sizeof(padded));
+                    std::memcpy(padded, indexed, size);
+                    block = padded;
+                }
+                uint64_t quotes, backslashes, structurals;
+                classify(block, quotes, backslashes, structurals);
+                quotes &= ~escaped(backslashes, odd_backslash);
+                const uint64_t strings = cash::prefix_xor(quotes) ^ inside;
+                inside = static_cast<uint64_t>(static_cast<int64_t>(strings) >> 63);
+                uint64_t bits = (structurals & ~strings) | quotes;
+
+                if (positions.size() < count + 64)
+                {
+                    positions.resize(std::max<size_t>(positions.size() * 2, count + 64));
+                }
+                const uint32_t offset = static_cast<uint32_t>(indexed - base);
+                while (bits != 0)
+                {
+                    positions[count++] = offset + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                }
+                indexed += size;
+            }
+        }
+
+        /**
+        * @brief Finds where a value ends.
+        *
+        * @param value its first character.
+        * @param entry the first position at or after it, moved past the value.
+        * @param after set to the end of the value.
+        */
+        Result skip(const char* value, size_t& entry, const char*& after)
+        {
+            if (*value == '"' || *value == '{' || *value == '[')
+            {
+                if (entry >= count)
+                {
+                    return SHORT;
+                }
+                if (at(entry) != value)
+                {
+                    invalid(value, "invalid value");
+                    return BAD;
+                }
+                if (*value == '"')
+                {
+                    if (entry + 1 >= count)
+                    {
+                        return SHORT;
+                    }
+                    after = at(entry + 1) + 1;
+                    entry += 2;
+                    return DONE;
+                }
+                size_t depth = 0;
+                for (; entry < count; ++entry)
+                {
+                    const char c = *at(entry);
+                    if (c == '"')
+                    {
+                        // The closing quote
+                        ++entry;
+                    }
+                    else if (c == '{' || c == '[')
+                    {
+                        ++depth;
+                    }
+                    else if ((c == '}' || c == ']') && --depth == 0)
+                    {
+                        after = at(entry) + 1;
+                        ++entry;
+                        if (c != *value + 2)
+                        {
+                            invalid(after - 1, std::string("unexpected '") + c + "'");
+                            return BAD;
+                        }
+                        return DONE;
+                    }
+                }
+                return SHORT;
+            }
+            const char* stop = value;
+            while (stop < end && !is_space(*stop) && !std::strchr(",:]}[{\"", *stop))
+            {
+                ++stop;
+            }
+            if (stop == end && !last)
+            {
+                return SHORT;
+            }
+            if (!is_number(value, stop) && !equals(value, stop, "true") && !equals(value, stop, "false")
+                && !equals(value, stop, "null"))
+            {
+                invalid(value, stop == value ? std::string("unexpected '") + *value + "'" : "invalid literal");
+                return BAD;
+            }
+            after = stop;
+            return DONE;
+        }
+
+        static bool equals(const char* begin, const char* end, const char* word)
+        {
+            const size_t size = std::strlen(word);
+            return static_cast<size_t>(end - begin) == size && std::memcmp(begin, word, size) == 0;
+        }
+
+        // Whether the key between quotes at begin and end is the one of a step
+        bool key_is(const char* begin, const char* end, const std::string& key)
+        {
+            if (std::memchr(begin, '\\', end - begin) == nullptr)
+            {
+                return static_cast<size_t>(end - begin) == key.size() && std::memcmp(begin, key.data(), key.size()) == 0;
+            }
+            scratch.clear();
+            unescape(begin, end, scratch);
+            return scratch == key;
+        }
+
+        /**
+        * @brief Follows a path from a value, collecting the values it leads to.
+        *
+        * @return false if the value is invalid on the way.
+        */
+        bool find(const Path& path, const size_t step, const char* value, size_t entry, std::vector<Match>& found)
+        {
+            if (step == path.size())
+            {
+                found.push_back(Match{value, entry});
+                return true;
+            }
+            const Step& wanted = path[step];
+            const bool object = *value == '{' && wanted.kind != Step::INDEX;
+            if (!object && (*value != '[' || wanted.kind == Step::KEY))
+            {
+                // Nothing there
+                return true;
+            }
+            const char close = object ? '}' : ']';
+            ++entry;
+            const char* element = skip_space(value + 1, end);
+            if (*element == close)
+            {
+                return true;
+            }
+            for (size_t index = 0;; ++index)
+            {
+                bool chosen = wanted.kind == Step::EACH || index == wanted.index;
+                if (object)
+                {
+                    // A key, between two quotes, and a colon
+                    if (*element != '"' || entry + 2 >= count || at(entry) != element || *at(entry + 2) != ':')
+                    {
+                        invalid(element, "invalid object");
+                        return false;
+                    }
+                    chosen = wanted.kind == Step::EACH || key_is(element + 1, at(entry + 1), wanted.key);
+                    element = skip_space(at(entry + 2) + 1, end);
+                    entry += 3;
+                }
+                if (chosen && !find(path, step + 1, element, entry, found))
+                {
+                    return false;
+                }
+                if (chosen && wanted.kind != Step::EACH)
+                {
+                    return true;
+                }
+                const char* after;
+                if (skip(element, entry, after) != DONE || entry >= count)
+                {
+                    invalid(element, "invalid value");
+                    return false;
+                }
+                const char separator = *at(entry);
+                if (separator == close)
+                {
+                    return true;
+                }
+                if (separator != ',' || skip_space(after, end) != at(entry))
+                {
+                    invalid(at(entry), std::string("unexpected '") + separator + "'");
+                    return false;
+                }
+                element = skip_space(at(entry) + 1, end);
+                ++entry;
+            }
+        }
+
+        // The end of a value known to be valid
+        const char* end_of(const Match& match)
+        {
+            size_t entry = match.entry;
+            const char* after = match.value;
+            skip(match.value, entry, after);
+            return after;
+        }
+
+        // Appends a value as printed
+        void write(const Match& match, std::string& out)
+        {
+            const char* after = end_of(match);
+            if (*match.value == '"' && query->raw)
+            {
+                if (!query->tabs)
+                {
+                    unescape(match.value + 1, after - 1, out);
+                    return;
+                }
+                // Like jq's @tsv, tabs and line breaks are escaped to keep the columns
+                scratch.clear();
+                unescape(match.value + 1, after - 1, scratch);
+                for (const char c : scratch)
+                {
+                    const char* code = std::strchr("\t\n\r\\", c);
+                    if (c != '\0' && code != nullptr)
+                    {
+                        out += '\\';
+                        out += "tnr\\"[code - "\t\n\r\\"];
+                    }
+                    else
+                    {
+                        out += c;
+                    }
+                }
+                return;
+            }
+            if ((*match.value != '{' && *match.value != '[') || std::memchr(match.value, '\n', after - match.value) == nullptr)
+            {
+                out.append(match.value, after - match.value);
+                return;
+            }
+            // Objects and arrays written over several lines are put on one, without the spaces outside strings
+            bool quoted = false;
+            for (const char* c = match.value; c < after; ++c)
+            {
+                if (quoted)
+                {
+                    out += *c;
+                    if (*c == '\\')
+                    {
+                        out += *++c;
+                    }
+                    else if (*c == '"')
+                    {
+                        quoted = false;
+                    }
+                }
+                else if (!is_space(*c))
+                {
+                    out += *c;
+                    quoted = *c == '"';
+                }
+            }
+        }
+
+        // The value at the end of a path, to compare
+        void operand(const std::vector<Match>& found, Operand& result)
+        {
+            result.text.clear();
+            if (found.empty())
+            {
+                result.kind = Operand::OTHER;
+                result.text = "null";
+                return;
+            }
+            const char* value = found.front().value;
+            const char* after = end_of(found.front());
+            if (*value == '"')
+            {
+                result.kind = Operand::STRING;
+                unescape(value + 1, after - 1, result.text);
+            }
+            else if (is_number(value, after))
+            {
+                result.kind = Operand::NUMBER;
+                result.value = number(value, after);
+            }
+            else
+            {
+                result.kind = Operand::OTHER;
+                result.text.assign(value, after);
+            }
+        }
+
+        /**
+        * @brief Tests a complete value and prints what the paths select from it.
+        *
+        * @return false if it turns out invalid.
+        */
+        bool select(const char* value, const size_t entry, std::string& out)
+        {
+            for (const Condition& condition : query->conditions)
+            {
+                found.clear();
+                if (!find(condition.path, 0, value, entry, found))
+                {
+                    return false;
+                }
+                operand(found, compared);
+                if (!condition.holds(compared))
+                {
+                    return true;
+                }
+            }
+            bool first = true;
+            for (const Path& path : query->paths)
+            {
+                found.clear();
+                if (!find(path, 0, value, entry, found))
+                {
+                    return false;
+                }
+                // A missing key or index is null, as in jq, and [] over nothing is nothing
+                const bool each = std::any_of(path.begin(), path.end(), [](const Step& step)
+                {
+                    return step.kind == Step::EACH;
+                });
+                if (found.empty() && !each)
+                {
+                    found.push_back(Match{nullptr, 0});
+                }
+                for (const Match& match : found)
+                {
+                    if (query->tabs && !first)
+                    {
+                        out += '\t';
+                    }
+                    first = false;
+                    if (match.value == nullptr)
+                    {
+                        out += "null";
+                    }
+                    else
+                    {
+                        write(match, out);
+                    }
+                    if (!query->tabs)
+                    {
+                        out += '\n';
+                    }
+                }
+            }
+            if (query->tabs)
+            {
+                out += '\n';
+            }
+            return true;
+        }
+
+        const Query* query;
+        const char* end = nullptr; //!< The end of the range.
+        bool last = false; //!< Whether the range ends the input.
+
+        const char* base = nullptr; //!< Where the window starts, which positions are relative to.
+        const char* indexed = nullptr; //!< Where indexing the window is up to.
+        uint64_t inside = 0; //!< All ones if indexing is inside a string.
+        uint64_t odd_backslash = 0; //!< 1 if indexing is after an odd run of backslashes.
+        std::vector<uint32_t> positions; //!< Quotes and structural characters outside strings.
+        size_t count = 0; //!< Number of positions of the window.
+
+        std::vector<Match> found; //!< The values a path leads to.
+        Operand compared; //!< A value tested by a condition.
+        std::string scratch; //!< Room for unescaping.
+    };
+
+    /**
+    * @brief json as a pipeline stage.
+    */
+    class Json : public cash::Stage
+    {
+    public:
+        /**
+        * @brief Reads the options and the filter.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            std::vector<std::string> operands;
+            if (!cash::get_options(args, "rtw:", options, operands))
+            {
+                return false;
+            }
+            if (operands.empty())
+            {
+                cash::report("json", "usage: json [-r] [-t] [-w condition]... path[,path...] [file...]");
+                return false;
+            }
+            const std::string& filter = operands[0];
+            size_t at = 0;
+            while (true)
+            {
+                query.paths.emplace_back();
+                at = filter.find_first_not_of(" \t", at);
+                if (at == std::string::npos || !parse_path(filter, at, query.paths.back()))
+                {
+                    cash::report("json", "invalid filter '" + filter + "'");
+                    return false;
+                }
+                at = std::min(filter.find_first_not_of(" \t", at), filter.size());
+                if (at == filter.size())
+                {
+                    break;
+                }
+                if (filter[at] != ',')
+                {
+                    cash::report("json", "invalid filter '" + filter + "'");
+                    return false;
+                }
+                ++at;
+            }
+            if (options.count('w'))
+            {
+                const std::string& all = options['w'];
+                for (size_t begin = 0; begin <= all.size();)
+                {
+                    const size_t newline = std::min(all.find('\n', begin), all.size());
+                    query.conditions.emplace_back();
+                    if (!query.conditions.back().parse(all.substr(begin, newline - begin)))
+                    {
+                        cash::report("json", "invalid condition '" + all.substr(begin, newline - begin) + "'");
+                        return false;
+                    }
+                    begin = newline + 1;
+                }
+            }
+            query.raw = options.count('r') != 0;
+            query.tabs = options.count('t') != 0;
+            inputs.assign(operands.begin() + 1, operands.end());
+            return true;
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            if (failed)
+            {
+                return false;
+            }
+            const char* start = data;
+            const char* stop = data + size;
+            if (!carry.empty())
+            {
+                // The value cut at the end of the last chunk usually ends on its line
+                const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+                start = newline == nullptr ? stop : newline + 1;
+                carry.append(data, start - data);
+                if (carry.size() < retry)
+                {
+                    carry.append(start, stop - start);
+                    fed += size;
+                    return true;
+                }
+                const char* tail;
+                if (!parse(carry.data(), carry.data() + carry.size(), carry_offset, false, tail))
+                {
+                    return false;
+                }
+                if (tail != carry.data() + carry.size())
+                {
+                    // Values over many lines are tried again only once the carry has doubled
+                    carry_offset += tail - carry.data();
+                    carry.erase(0, tail - carry.data());
+                    retry = carry.size() * 2;
+                    carry.append(start, stop - start);
+                    fed += size;
+                    return true;
+                }
+                carry.clear();
+            }
+            const char* tail;
+            if (!parse(start, stop, fed + (start - data), false, tail))
+            {
+                return false;
+            }
+            carry.assign(tail, stop - tail);
+            carry_offset = fed + (tail - data);
+            retry = 0;
+            fed += size;
+            return true;
+        }
+
+        void begin_input(const std::string& name) override
+        {
+            end_input();
+            input = name;
+            fed = 0;
+            ordered = false;
+        }
+
+        void finish() override
+        {
+            end_input();
+            end();
+        }
+
+        int status() const override
+        {
+            return failed ? 1 : 0;
+        }
+
+    private:
+        // Parses what is left of an input, which has to be complete values
+        void end_input()
+        {
+            if (!failed && !carry.empty())
+            {
+                const char* tail;
+                parse(carry.data(), carry.data() + carry.size(), carry_offset, true, tail);
+            }
+            carry.clear();
+            retry = 0;
+        }
+
+        /**
+        * @brief Runs the query over a range of the input that starts outside any value.
+        *
+        * @param offset where the range is in the input, for errors.
+        * @param last whether the range ends the input.
+        * @param tail set to the start of a value the range ends inside, or to end.
+        * @return false on invalid JSON or when no more output is wanted.
+        */
+        bool parse(const char* begin, const char* end, const uint64_t offset, const bool last, const char*& tail)
+        {
+            const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+            while (scanners.size() < cores)
+            {
+                scanners.emplace_back(query);
+                outputs.emplace_back();
+            }
+            tails.resize(cores);
+            size_t size = PIECE_SIZE;
+            const char* at = begin;
+            while (true)
+            {
+                const size_t pieces = ordered ? 1 : cores;
+                // Pieces end at newlines, so with a value per line each one starts at a value
+                cuts.assign(1, at);
+                while (cuts.size() <= pieces && cuts.back() < end)
+                {
+                    const char* cut = end - cuts.back() > static_cast<ptrdiff_t>(size) ? cuts.back() + size : end;
+                    const char* newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+                    cuts.push_back(newline == nullptr ? end : newline + 1);
+                }
+                const size_t count = cuts.size() - 1;
+                if (count == 0)
+                {
+                    tail = end;
+                    return true;
+                }
+                cash::parallel_for(count, [&](const size_t p)
+                {
+                    outputs[p].clear();
+                    tails[p] = scanners[p].run(cuts[p], cuts[p + 1], last && cuts[p + 1] == end, outputs[p]);
+                });
+
+                // After a piece that ends inside a value, the others started inside it and are parsed again
+                size_t good = 0;
+                while (good + 1 < count && tails[good] == cuts[good + 1])
+                {
+                    ++good;
+                }
+                for (size_t p = 0; p <= good; ++p)
+                {
+                    if (!outputs[p].empty() && !emit(outputs[p].data(), outputs[p].size()))
+                    {
+                        return false;
+                    }
+                }
+                if (tails[good] == nullptr)
+                {
+                    const Scanner& scanner = scanners[good];
+                    const std::string where = input.empty() || input == "-" ? "" : input + ": ";
+                    cash::report("json", where + scanner.problem + " at byte "
+                                         + std::to_string(offset + (scanner.error - begin)));
+                    failed = true;
+                    return false;
+                }
+                if (good + 1 < count)
+                {
+                    ordered = true;
+                }
+                if (cuts[good + 1] == end)
+                {
+                    tail = tails[good];
+                    return true;
+                }
+                if (tails[good] == at)
+                {
+                    // A value larger than a piece
+                    size *= 2;
+                }
+                at = tails[good];
+            }
+        }
+
+        Query query;
+        std::vector<Scanner> scanners; //!< One per piece parsed at once.
+        std::vector<std::string> outputs; //!< The output of each piece.
+        std::vector<const char*> tails; //!< Where each piece stopped.
+        std::vector<const char*> cuts; //!< Where the pieces start, and the last ends.
+        bool ordered = false; //!< Whether the input has values over several lines, parsed in order.
+
+        std::string carry; //!< The values an earlier chunk ended inside.
+        uint64_t carry_offset = 0; //!< Where the carry is in the input.
+        size_t retry = 0; //!< The carry size at which it is parsed again.
+        uint64_t fed = 0; //!< Bytes of the input so far.
+        std::string input; //!< The name of the input.
+        bool failed = false;
+    };
+}
+
+std::unique_ptr<cash::Stage> cash::json_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Json> stage(new Json());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+int cash::json(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
@@ -0,0 +1,537 @@
+/**
+ * @file map.cpp
+ * @brief the map builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Runs a line filter such as sed or awk on every core: standard input is
+ * cut at line ends into blocks, each block is piped through an instance of
+ * the command, up to one per core at a time, and their outputs are written
+ * in the order of the blocks. Outputs that are ahead of the oldest block
+ * wait in a window of bounded size; past it, their commands are left to
+ * block on a full pipe and no new block starts, so memory stays bounded
+ * however slow the oldest block is.
+ */
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    // Blocks started but not yet written out, per job
+    const size_t WINDOW_SHARE = 2;
+
+    // Bytes read from the commands and from pipe input at once
+    const size_t READ_SIZE = 1 << 16;
+
+    /**
+    * @brief Parses -b: a number of bytes with an optional K, M or G suffix.
+    */
+    bool parse_size(const std::string& text, size_t& size)
+    {
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+        if (end == text.c_str() || value == 0 || text[0] == '-')
+        {
+            return false;
+        }
+        const std::string suffix(end);
+        const char* units = "bKMG";
+        const char* unit = suffix.empty() ? units : suffix.size() == 1 ? std::strchr(units, suffix[0]) : nullptr;
+        if (unit == nullptr || *unit == '\0')
+        {
+            return false;
+        }
+        size = value << (10 * (unit - units));
+        return true;
+    }
+
+    // Whether a command is a builtin or an executable file in PATH
+    bool runnable(const std::string& name)
+    {
+        if (cash::find_builtin(name, false) != nullptr || cash::find_builtin(name, true) != nullptr)
+        {
+            return true;
+        }
+        if (name.find('/') != std::string::npos)
+        {
+            return access(name.c_str(), X_OK) == 0;
+        }
+        const char* path = std::getenv("PATH");
+        const std::string directories = path != nullptr ? path : "/usr/bin:/bin";
+        for (size_t begin = 0; begin <= directories.size();)
+        {
+            const size_t colon = std::min(directories.find(':', begin), directories.size());
+            const std::string directory = colon > begin ? directories.substr(begin, colon - begin) : ".";
+            const std::string file = directory + "/" + name;
+            struct stat info;
+            if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode) && access(file.c_str(), X_OK) == 0)
+            {
+                return true;
+            }
+            begin = colon + 1;
+        }
+        return false;
+    }
+
+    // Writes all the bytes to a blocking file descriptor
+    bool write_all(const int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t written = write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    /**
+    * @brief A block of input and the command instance it is piped through.
+    */
+    struct Job
+    {
+        std::string owned; //!< The block, unless it points into the mapped input.
+        const char* data = nullptr;
+        size_t size = 0;
+        size_t written = 0; //!< Bytes of the block written to the command so far.
+        pid_t pid = -1;
+        int in = -1; //!< The command's standard input, -1 once the block is written.
+        int out = -1; //!< The command's standard output, -1 once it has ended.
+        std::string output; //!< Output read but not yet written out.
+        int status = 0;
+    };
+
+    /**
+    * @brief Cuts the input into blocks ending at line ends.
+    */
+    class Blocks
+    {
+    public:
+        explicit Blocks(const size_t size)
+            : block_size(size)
+        {
+            // Regular files are mapped, from where standard input is at
+            if (mapped.map(STDIN_FILENO))
+            {
+                const off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+                position = offset > 0 ? std::min(static_cast<size_t>(offset), mapped.size()) : 0;
+                is_mapped = true;
+                ended = true;
+            }
+        }
+
+        /**
+        * @brief Whether the input needs reading before another block can be taken.
+        */
+        bool wants_input() const
+        {
+            return !ended && cut() == 0;
+        }
+
+        /**
+        * @brief Reads what standard input has, once poll says there is something.
+        *
+        * @return false on read errors.
+        */
+        bool read_input()
+        {
+            const size_t used = pending.size();
+            pending.resize(used + READ_SIZE);
+            const ssize_t got = read(STDIN_FILENO, &pending[used], READ_SIZE);
+            pending.resize(used + static_cast<size_t>(std::max<ssize_t>(got, 0)));
+            if (got < 0 && errno != EINTR)
+            {
+                ended = true;
+                return false;
+            }
+            ended = got == 0;
+            return true;
+        }
+
+        /**
+        * @brief Takes the next block, if one is ready.
+        */
+        bool take(Job& job)
+        {
+            if (is_mapped)
+            {
+                if (position == mapped.size())
+                {
+                    return false;
+                }
+                const size_t size = cut();
+                job.data = mapped.data() + position;
+                job.size = size;
+                position += size;
+                return true;
+            }
+            const size_t size = cut();
+            if (size == 0)
+            {
+                return false;
+            }
+            job.owned.assign(pending, 0, size);
+            pending.erase(0, size);
+            job.data = job.owned.data();
+            job.size = size;
+            return true;
+        }
+
+        /**
+        * @brief Whether every block has been taken.
+        */
+        bool done() const
+        {
+            return is_mapped ? position == mapped.size() : ended && pending.empty();
+        }
+
+    private:
+        // Size of the next block, 0 if it is not all there yet
+        size_t cut() const
+        {
+            const char* data = is_mapped ? mapped.data() + position : pending.data();
+            const size_t size = is_mapped ? mapped.size() - position : pending.size();
+            if (size <= block_size)
+            {
+                return ended ? size : 0;
+            }
+            // At the last line end within the block size, or after the first line if it is longer
+            const void* newline = memrchr(data, '\n', block_size);
+            if (newline == nullptr)
+            {
+                newline = std::memchr(data + block_size, '\n', size - block_size);
+            }
+            if (newline == nullptr)
+            {
+                return ended ? size : 0;
+            }
+            return static_cast<const char*>(newline) - data + 1;
+        }
+
+        size_t block_size;
+        cash::MappedFile mapped;
+        bool is_mapped = false;
+        size_t position = 0; //!< Start of the next block in the mapping.
+        std::string pending; //!< Input read from a pipe but not yet in a block.
+        bool ended = false; //!< Whether all the input has been read.
+    };
+
+    /**
+    * @brief Starts an instance of the command on a block.
+    *
+    * @return false after reporting an error.
+    */
+    bool start(Job& job, const std::vector<std::string>& command, const std::deque<std::unique_ptr<Job>>& window)
+    {
+        int input[2], output[2];
+        if (pipe2(input, O_CLOEXEC) != 0)
+        {
+            cash::report("map", std::string("pipe: ") + strerror(errno));
+            return false;
+        }
+        if (pipe2(output, O_CLOEXEC) != 0)
+        {
+            cash::report("map", std::string("pipe: ") + strerror(errno));
+            close(input[0]);
+            close(input[1]);
+            return false;
+        }
+        std::cout.flush();
+        job.pid = fork();
+        if (job.pid == -1)
+        {
+            cash::report("map", std::string("fork: ") + strerror(errno));
+            close(input[0]);
+            close(input[1]);
+            close(output[0]);
+            close(output[1]);
+            return false;
+        }
+        if (job.pid == 0)
+        {
+            signal(SIGPIPE, SIG_DFL);
+            dup2(input[0], STDIN_FILENO);
+            dup2(output[1], STDOUT_FILENO);
+            // A builtin runs in this child without exec, so the pipes of the other blocks are closed by hand
+            for (const auto& other : window)
+            {
+                if (other->in != -1)
+                {
+                    close(other->in);
+                }
+                if (other->out != -1)
+                {
+                    close(other->out);
+                }
+            }
+            close(input[0]);
+            close(input[1]);
+            close(output[0]);
+            close(output[1]);
+            cash::run_stage(command, command);
+        }
+        close(input[0]);
+        close(output[1]);
+        job.in = input[1];
+        job.out = output[0];
+        fcntl(job.in, F_SETFL, O_NONBLOCK);
+        fcntl(job.out, F_SETFL, O_NONBLOCK);
+        if (job.size == 0)
+        {
+            close(job.in);
+            job.in = -1;
+        }
+        return true;
+    }
+
+    // Writes as much of the block to the command as its pipe takes
+    void write_block(Job& job)
+    {
+        const ssize_t written = write(job.in, job.data + job.written, job.size - job.written);
+        if (written < 0 && (errno == EAGAIN || errno == EINTR))
+        {
+            return;
+        }
+        // A command that exits without reading everything, like head, just gets less
+        job.written = written < 0 ? job.size : job.written + static_cast<size_t>(written);
+        if (job.written == job.size)
+        {
+            close(job.in);
+            job.in = -1;
+            std::string().swap(job.owned);
+        }
+    }
+
+    // Reads what the command has written, and its status once it has ended
+    void read_output(Job& job)
+    {
+        const size_t used = job.output.size();
+        job.output.resize(used + READ_SIZE);
+        const ssize_t got = read(job.out, &job.output[used], READ_SIZE);
+        job.output.resize(used + static_cast<size_t>(std::max<ssize_t>(got, 0)));
+        if (got < 0 && (errno == EAGAIN || errno == EINTR))
+        {
+            return;
+        }
+        if (got <= 0)
+        {
+            close(job.out);
+            job.out = -1;
+            if (job.in != -1)
+            {
+                close(job.in);
+                job.in = -1;
+            }
+            int status = 0;
+            while (waitpid(job.pid, &status, 0) == -1 && errno == EINTR)
+            {
+            }
+            job.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        }
+    }
+
+    // Stops the commands still running, after the output failed
+    void abandon(std::deque<std::unique_ptr<Job>>& window)
+    {
+        for (const auto& job : window)
+        {
+            if (job->in != -1)
+            {
+                close(job->in);
+            }
+            if (job->out != -1)
+            {
+                close(job->out);
+                kill(job->pid, SIGTERM);
+                waitpid(job->pid, nullptr, 0);
+            }
+        }
+        window.clear();
+    }
+}
+
+int cash::map(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> command;
+    if (!get_options(args, "b:j:", options, command))
+    {
+        return 2;
+    }
+    if (command.empty())
+    {
+        report("map", "usage: map [-j jobs] [-b size] [--] command [arg...]");
+        return 2;
+    }
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    if (options.count('j'))
+    {
+        const std::string& text = options['j'];
+        if (text.empty() || text.size() > 4 || text.find_first_not_of("0123456789") != std::string::npos
+            || std::stoul(text) == 0)
+        {
+            report("map", "invalid number of jobs '" + text + "'");
+            return 2;
+        }
+        jobs = std::stoul(text);
+    }
+    size_t block_size = CHUNK_SIZE;
+    if (options.count('b') && !parse_size(options['b'], block_size))
+    {
+        report("map", "invalid block size '" + options['b'] + "'");
+        return 2;
+    }
+    if (!runnable(command[0]))
+    {
+        report("map", command[0] + ": command not found");
+        return 127;
+    }
+
+    // Commands that stop reading early make writes to them fail instead of killing the shell
+    struct sigaction action = {}, saved = {};
+    action.sa_handler = SIG_IGN;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPIPE, &action, &saved);
+
+    Blocks blocks(block_size);
+    std::deque<std::unique_ptr<Job>> window;
+    const size_t window_size = WINDOW_SHARE * jobs;
+    size_t running = 0;
+    int status = 0;
+    bool failed = false;
+    std::vector<pollfd> polled;
+    std::vector<Job*> polled_jobs;
+    while (true)
+    {
+        while (running < jobs && window.size() < window_size)
+        {
+            std::unique_ptr<Job> job(new Job());
+            if (!blocks.take(*job))
+            {
+                break;
+            }
+            if (!start(*job, command, window))
+            {
+                failed = true;
+                break;
+            }
+            window.push_back(std::move(job));
+            ++running;
+        }
+        if (failed || (window.empty() && blocks.done()))
+        {
+            break;
+        }
+
+        // The oldest block's output is always read; later ones only while they fit in the window
+        polled.clear();
+        polled_jobs.clear();
+        if (blocks.wants_input())
+        {
+            polled.push_back(pollfd{STDIN_FILENO, POLLIN, 0});
+            polled_jobs.push_back(nullptr);
+        }
+        for (size_t j = 0; j < window.size(); ++j)
+        {
+            Job& job = *window[j];
+            const bool reading = job.out != -1 && (j == 0 || job.output.size() < block_size);
+            if (job.in != -1 || reading)
+            {
+                polled.push_back(pollfd{job.in != -1 ? job.in : -1, POLLOUT, 0});
+                polled_jobs.push_back(&job);
+                polled.push_back(pollfd{reading ? job.out : -1, POLLIN, 0});
+                polled_jobs.push_back(&job);
+            }
+        }
+        if (poll(polled.data(), polled.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            report("map", std::string("poll: ") + strerror(errno));
+            failed = true;
+            break;
+        }
+        for (size_t p = 0; p < polled.size(); ++p)
+        {
+            if (polled[p].revents == 0)
+            {
+                continue;
+            }
+            Job* job = polled_jobs[p];
+            if (job == nullptr)
+            {
+                if (!blocks.read_input())
+                {
+                    report("map", std::string("read: ") + strerror(errno));
+                    status = 1;
+                }
+            }
+            else if (polled[p].fd == job->in)
+            {
+                write_block(*job);
+            }
+            else if (polled[p].fd == job->out)
+            {
+                read_output(*job);
+                running -= job->out == -1 ? 1 : 0;
+            }
+        }
+
+        // Output is written in the order of the blocks
+        while (!window.empty())
+        {
+            Job& oldest = *window.front();
+            if (!write_all(STDOUT_FILENO, oldest.output.data(), oldest.output.size()))
+            {
+                failed = true;
+                break;
+            }
+            oldest.output.clear();
+            if (oldest.out != -1)
+            {
+                break;
+            }
+            status = status != 0 ? status : oldest.status;
+            window.pop_front();
+        }
+        if (failed)
+        {
+            break;
+        }
+    }
+    if (failed)
+    {
+        abandon(window);
+        status = 1;
+    }
+    sigaction(SIGPIPE, &saved, nullptr);
+    return status;
+}
@@ -0,0 +1,364 @@
+/**
+ * @file pipeline.cpp
+ * @brief process groups of pipelines for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * The children of a pipeline are watched through pidfds, so the watcher
+ * sleeps in poll until one exits or a deadline passes, and reacts at once:
+ * a consumer that is done no longer leaves its producers running until
+ * their next write, or forever if they ignore SIGPIPE or wait on input.
+ * A new process group is only made when it can have the terminal, or
+ * when there is no terminal at all; otherwise Ctrl+C would miss it.
+ */
+
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include "pipeline.h"
+
+namespace
+{
+    // Whether this process is a child of the shell running commands of its own
+    bool inherited = false;
+
+    // Stages before one that exited get this long to end on their own
+    const std::chrono::milliseconds GRACE(50);
+
+    // Cancelled stages get this long to handle SIGTERM before SIGKILL
+    const std::chrono::milliseconds KILL_DELAY(1000);
+
+    // How often children are checked, in milliseconds, when pidfds are not supported
+    const int CHECK_INTERVAL = 10;
+
+    int open_pidfd(const pid_t pid)
+    {
+#ifdef SYS_pidfd_open
+        return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+        return -1;
+#endif
+    }
+
+    // Shortens a poll timeout, -1 for none, to end at a deadline
+    int until(const int timeout, const std::chrono::steady_clock::time_point deadline,
+              const std::chrono::steady_clock::time_point now)
+    {
+        const long long left = std::max(0LL, static_cast<long long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1));
+        return timeout == -1 ? static_cast<int>(left) : std::min(timeout, static_cast<int>(left));
+    }
+
+    // Whether the shell can hand the terminal to a process group
+    bool owns_terminal()
+    {
+        return isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+    }
+
+    // Whether the shell has no controlling terminal, so no Ctrl+C to miss
+    bool detached()
+    {
+        const int terminal = open("/dev/tty", O_RDONLY | O_CLOEXEC);
+        if (terminal == -1)
+        {
+            return true;
+        }
+        close(terminal);
+        return false;
+    }
+}
+
+cash::PipelineGroup::PipelineGroup(const bool pipefail)
+    : pipefail(pipefail)
+{
+    foreground = !inherited && owns_terminal();
+    grouped = !inherited && (foreground || detached());
+}
+
+cash::PipelineGroup::~PipelineGroup()
+{
+    if (!waited)
+    {
+        wait();
+    }
+}
+
+void cash::PipelineGroup::join() const
+{
+    if (grouped)
+    {
+        setpgid(0, group);
+    }
+}
+
+void cash::PipelineGroup::inherit()
+{
+    inherited = true;
+}
+
+size_t cash::PipelineGroup::next_position(const bool beside) const
+{
+    if (stages.empty())
+    {
+        return 0;
+    }
+    return stages.back().position + (beside ? 0 : 1);
+}
+
+void cash::PipelineGroup::add(const pid_t pid, const bool beside)
+{
+    if (grouped)
+    {
+        // Done in the child too, whichever runs first
+        setpgid(pid, group == 0 ? pid : group);
+        if (group == 0)
+        {
+            group = pid;
+            // Ctrl+C and reads from the terminal go to the pipeline while it runs
+            foreground = foreground && tcsetpgrp(STDIN_FILENO, group) == 0;
+        }
+    }
+    Stage stage;
+    stage.pid = pid;
+    stage.position = next_position(beside);
+    stage.pidfd = open_pidfd(pid);
+    stages.push_back(stage);
+}
+
+void cash::PipelineGroup::watch_in_background()
+{
+    if (stages.empty())
+    {
+        return;
+    }
+    wakeup = eventfd(0, EFD_CLOEXEC);
+    watcher = std::thread(&PipelineGroup::watch, this);
+}
+
+void cash::PipelineGroup::add_finished(const int status)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Stage stage;
+    stage.running = false;
+    stage.status = status;
+    stage.position = next_position(false);
+    stages.push_back(stage);
+    exited(stages.size() - 1);
+    if (wakeup != -1)
+    {
+        const uint64_t one = 1;
+        write(wakeup, &one, sizeof(one));
+    }
+}
+
+int cash::PipelineGroup::wait()
+{
+    waited = true;
+    if (watcher.joinable())
+    {
+        watcher.join();
+    }
+    else
+    {
+        watch();
+    }
+    if (wakeup != -1)
+    {
+        close(wakeup);
+        wakeup = -1;
+    }
+    if (grouped && foreground && group != 0)
+    {
+        // Taking the terminal back from the background needs SIGTTOU ignored
+        struct sigaction ignore = {}, saved = {};
+        ignore.sa_handler = SIG_IGN;
+        sigemptyset(&ignore.sa_mask);
+        sigaction(SIGTTOU, &ignore, &saved);
+        tcsetpgrp(STDIN_FILENO, getpgrp());
+        sigaction(SIGTTOU, &saved, nullptr);
+    }
+
+    // Stages the pipeline stopped itself did not fail
+    int result = 0;
+    for (const auto& stage : stages)
+    {
+        if (!pipefail)
+        {
+            result = stage.status;
+        }
+        else if (stage.status != 0 && !stage.cancelled)
+        {
+            result = stage.status;
+        }
+    }
+    return result;
+}
+
+void cash::PipelineGroup::watch()
+{
+    std::vector<pollfd> polled;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        bool running = false;
+        bool pollable = true;
+        polled.clear();
+        for (const auto& stage : stages)
+        {
+            if (stage.running)
+            {
+                running = true;
+                pollable = pollable && stage.pidfd != -1;
+                polled.push_back(pollfd{stage.pidfd, POLLIN, 0});
+            }
+        }
+        if (!running)
+        {
+            break;
+        }
+        if (wakeup != -1)
+        {
+            polled.push_back(pollfd{wakeup, POLLIN, 0});
+        }
+
+        // Sleeps until a child exits, the shell's stage returns or a deadline passes
+        const Clock::time_point now = Clock::now();
+        int timeout = pollable ? -1 : CHECK_INTERVAL;
+        if (upstream_end > 0)
+        {
+            timeout = until(timeout, upstream_deadline, now);
+        }
+        if (killing)
+        {
+            timeout = until(timeout, kill_deadline, now);
+        }
+        guard.unlock();
+        poll(polled.data(), polled.size(), timeout);
+        guard.lock();
+
+        if (wakeup != -1 && (polled.back().revents & POLLIN))
+        {
+            uint64_t value = 0;
+            read(wakeup, &value, sizeof(value));
+        }
+        // Later stages first, so that a consumer is known to be done before its producer's SIGPIPE is looked at
+        for (size_t s = stages.size(); s-- > 0;)
+        {
+            Stage& stage = stages[s];
+            if (!stage.running || stage.pid == -1)
+            {
+                continue;
+            }
+            int status = 0;
+            const pid_t done = waitpid(stage.pid, &status, WNOHANG);
+            if (done == 0 || (done == -1 && errno == EINTR))
+            {
+                continue;
+            }
+            stage.running = false;
+            stage.status = done == stage.pid && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            // Writing to a consumer that is gone is being stopped by the pipeline, not failing
+            bool consumed = false;
+            for (const auto& later : stages)
+            {
+                consumed = consumed || (later.position > stage.position && !later.running);
+            }
+            if (done == stage.pid && WIFSIGNALED(status) && WTERMSIG(status) == SIGPIPE && consumed)
+            {
+                stage.cancelled = true;
+            }
+            if (stage.pidfd != -1)
+            {
+                close(stage.pidfd);
+                stage.pidfd = -1;
+            }
+            exited(s);
+        }
+
+        const Clock::time_point later = Clock::now();
+        if (upstream_end > 0 && later >= upstream_deadline)
+        {
+            cancel(upstream_end);
+            upstream_end = 0;
+        }
+        if (killing && later >= kill_deadline)
+        {
+            for (const auto& stage : stages)
+            {
+                if (stage.running && stage.cancelled && stage.pid != -1)
+                {
+                    kill(stage.pid, SIGKILL);
+                }
+            }
+            if (group_cancelled)
+            {
+                kill(-group, SIGKILL);
+            }
+            killing = false;
+        }
+    }
+}
+
+void cash::PipelineGroup::exited(const size_t stage)
+{
+    // With pipefail, a failed stage makes the work of the others pointless
+    if (pipefail && stages[stage].status != 0 && !stages[stage].cancelled)
+    {
+        cancel(stages.back().position + 1);
+        return;
+    }
+    // The stages before it write to no one now
+    const size_t position = stages[stage].position;
+    if (position > upstream_end)
+    {
+        if (upstream_end == 0)
+        {
+            upstream_deadline = Clock::now() + GRACE;
+        }
+        upstream_end = position;
+    }
+}
+
+void cash::PipelineGroup::cancel(const size_t end)
+{
+    // With only cancelled stages left, the group is signaled, reaching what they started too
+    bool everything = grouped && group != 0;
+    for (const auto& stage : stages)
+    {
+        everything = everything && !(stage.position >= end && stage.running && stage.pid != -1);
+    }
+    bool any = false;
+    for (auto& stage : stages)
+    {
+        if (stage.position < end && stage.running && stage.pid != -1 && !stage.cancelled)
+        {
+            stage.cancelled = true;
+            any = true;
+            if (!everything)
+            {
+                kill(stage.pid, SIGTERM);
+            }
+        }
+    }
+    if (!any)
+    {
+        return;
+    }
+    if (everything)
+    {
+        kill(-group, SIGTERM);
+        group_cancelled = true;
+    }
+    if (!killing)
+    {
+        killing = true;
+        kill_deadline = Clock::now() + KILL_DELAY;
+    }
+}
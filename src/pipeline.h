@@ -0,0 +1,128 @@
+/**
+ * @file pipeline.h
+ * @brief process groups of pipelines for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the declaration of PipelineGroup, which waits for the children
+ * of a pipeline and stops those whose work is no longer wanted.
+ */
+
+
+#ifndef CASH_PIPELINE_H
+#define CASH_PIPELINE_H
+
+#include <sys/types.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief The stages of a pipeline, its children in one process group.
+    *
+    * When a stage exits, the stages before it are writing to no one: after
+    * a short grace they get SIGTERM, and SIGKILL if they outlive it. With
+    * pipefail, a failing stage cancels all the others at once. The group
+    * is given the terminal while it runs, so Ctrl+C stops the pipeline and
+    * not the shell.
+    */
+    class PipelineGroup
+    {
+    public:
+        /**
+        * @param pipefail whether a failing stage fails the pipeline and cancels it.
+        */
+        explicit PipelineGroup(bool pipefail);
+        PipelineGroup(const PipelineGroup&) = delete;
+        PipelineGroup& operator=(const PipelineGroup&) = delete;
+
+        /**
+        * @brief Waits for the children left, if wait was not called.
+        */
+        ~PipelineGroup();
+
+        /**
+        * @brief The process group for the next child to join with setpgid, 0 before the first.
+        */
+        pid_t id() const { return group; }
+
+        /**
+        * @brief Puts the calling child in the group, right after fork.
+        */
+        void join() const;
+
+        /**
+        * @brief Adds a forked child as the next stage.
+        *
+        * @param pid the child.
+        * @param beside whether it runs beside the previous stage, both feeding the next, rather than after it.
+        */
+        void add(pid_t pid, bool beside = false);
+
+        /**
+        * @brief Starts watching the children from a thread, before the last stage runs in the shell.
+        */
+        void watch_in_background();
+
+        /**
+        * @brief Adds the last stage, which ran in the shell, once it has returned.
+        *
+        * @param status its exit status.
+        */
+        void add_finished(int status);
+
+        /**
+        * @brief Keeps the pipelines this process runs in its process group, for a child running commands of its own.
+        */
+        static void inherit();
+
+        /**
+        * @brief Waits for the children.
+        *
+        * @return the status of the last stage, or with pipefail of the last stage that failed.
+        */
+        int wait();
+
+    private:
+        /**
+        * @brief A stage, -1 as pid for one that ran in the shell.
+        */
+        struct Stage
+        {
+            pid_t pid = -1;
+            size_t position = 0; //!< How far down the pipeline it is; stages beside each other share one.
+            int pidfd = -1; //!< Readable once the child exits, -1 if pidfds are not supported.
+            bool running = true;
+            bool cancelled = false; //!< Whether it was stopped by the pipeline, its status then not counting.
+            int status = 0;
+        };
+
+        typedef std::chrono::steady_clock Clock;
+
+        void watch();
+        void exited(size_t stage);
+        void cancel(size_t end);
+        size_t next_position(bool beside) const;
+
+        bool pipefail;
+        bool grouped; //!< Whether the children get a process group of their own.
+        pid_t group = 0;
+        bool foreground; //!< Whether the group has the terminal, or is to get it.
+        bool group_cancelled = false; //!< Whether the whole group was sent SIGTERM.
+        std::vector<Stage> stages;
+        std::mutex lock; //!< Guards stages while the watcher thread runs.
+        std::thread watcher;
+        int wakeup = -1; //!< eventfd telling the watcher the stage in the shell returned.
+        bool waited = false;
+
+        size_t upstream_end = 0; //!< Stages at positions before this one are to be cancelled when upstream_deadline passes.
+        Clock::time_point upstream_deadline;
+        bool killing = false; //!< Whether cancelled stages get SIGKILL when kill_deadline passes.
+        Clock::time_point kill_deadline;
+    };
+}
+
+#endif //CASH_PIPELINE_H
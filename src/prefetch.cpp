@@ -0,0 +1,407 @@
+/**
+ * @file prefetch.cpp
+ * @brief background readahead of frequently executed binaries
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * After the page cache has been dropped, the first run of a big tool spends
+ * most of its time reading the binary and its libraries. The shell knows
+ * which tools are used most, so it reads them in while the prompt is idle.
+ */
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "prefetch.h"
+
+namespace
+{
+    // How many of the most executed binaries are prefetched
+    const size_t HOT_COUNT = 16;
+
+    // ioprio_set(2) constants, not exported by glibc
+    const int IOPRIO_WHO_PROCESS = 1;
+    const int IOPRIO_CLASS_IDLE = 3;
+    const int IOPRIO_CLASS_SHIFT = 13;
+
+    std::map<std::string, unsigned long> exec_counts;
+    pid_t owner = 0;
+
+    std::string counts_path()
+    {
+        const char* home = std::getenv("HOME");
+        return std::string(home != nullptr ? home : ".") + "/.cash_exec_counts";
+    }
+
+    void save_exec_counts()
+    {
+        // Forked children exit through here too, only the shell itself saves
+        if (getpid() != owner)
+        {
+            return;
+        }
+        const std::string path = counts_path();
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary);
+            if (!file)
+            {
+                return;
+            }
+            for (const auto& entry : exec_counts)
+            {
+                file << entry.second << ' ' << entry.first << '\n';
+            }
+        }
+        std::rename(temporary.c_str(), path.c_str());
+    }
+
+    // Finds an executable the way execvp does
+    std::string find_in_path(const std::string& name)
+    {
+        if (name.find('/') != std::string::npos)
+        {
+            return name;
+        }
+        const char* path = std::getenv("PATH");
+        std::string dirs = path != nullptr ? path : "/usr/local/bin:/usr/bin:/bin";
+        size_t begin = 0;
+        while (begin <= dirs.size())
+        {
+            size_t end = dirs.find(':', begin);
+            if (end == std::string::npos)
+            {
+                end = dirs.size();
+            }
+            const std::string dir = end == begin ? "." : dirs.substr(begin, end - begin);
+            const std::string candidate = dir + "/" + name;
+            if (access(candidate.c_str(), X_OK) == 0)
+            {
+                return candidate;
+            }
+            begin = end + 1;
+        }
+        return "";
+    }
+
+    void split_dirs(const std::string& list, const std::string& origin, std::vector<std::string>& dirs)
+    {
+        size_t begin = 0;
+        while (begin < list.size())
+        {
+            size_t end = list.find(':', begin);
+            if (end == std::string::npos)
+            {
+                end = list.size();
+            }
+            std::string dir = list.substr(begin, end - begin);
+            const size_t found = dir.find("$ORIGIN");
+            if (found != std::string::npos)
+            {
+                dir.replace(found, 7, origin);
+            }
+            if (!dir.empty())
+            {
+                dirs.push_back(dir);
+            }
+            begin = end + 1;
+        }
+    }
+
+    // Library directories of the dynamic loader, from ld.so.conf and the defaults
+    std::vector<std::string> system_library_dirs()
+    {
+        std::vector<std::string> dirs;
+        glob_t confs;
+        if (glob("/etc/ld.so.conf.d/*.conf", 0, nullptr, &confs) == 0)
+        {
+            for (size_t i = 0; i < confs.gl_pathc; ++i)
+            {
+                std::ifstream file(confs.gl_pathv[i]);
+                std::string line;
+                while (std::getline(file, line))
+                {
+                    if (!line.empty() && line[0] == '/')
+                    {
+                        dirs.push_back(line);
+                    }
+                }
+            }
+        }
+        globfree(&confs);
+        for (const char* dir : {"/lib64", "/usr/lib64", "/lib", "/usr/lib"})
+        {
+            dirs.push_back(dir);
+        }
+        return dirs;
+    }
+
+    /**
+    * @brief What the dynamic loader needs besides the file itself.
+    */
+    struct Dependencies
+    {
+        std::string interpreter; //!< PT_INTERP, the dynamic loader.
+        std::vector<std::string> needed; //!< DT_NEEDED library names.
+        std::string runpath; //!< DT_RUNPATH, or DT_RPATH when there is none.
+    };
+
+    template <typename Ehdr, typename Phdr, typename Dyn>
+    void read_dependencies(const unsigned char* data, const size_t size, Dependencies& result)
+    {
+        const Ehdr* header = reinterpret_cast<const Ehdr*>(data);
+        if (sizeof(Ehdr) > size || header->e_phentsize != sizeof(Phdr)
+            || header->e_phoff + static_cast<size_t>(header->e_phnum) * sizeof(Phdr) > size)
+        {
+            return;
+        }
+        const Phdr* segments = reinterpret_cast<const Phdr*>(data + header->e_phoff);
+
+        // Converts a virtual address to a file offset through the loadable segments
+        auto offset_of = [&](const size_t address) -> size_t
+        {
+            for (size_t i = 0; i < header->e_phnum; ++i)
+            {
+                const Phdr& segment = segments[i];
+                if (segment.p_type == PT_LOAD && address >= segment.p_vaddr
+                    && address < segment.p_vaddr + segment.p_filesz)
+                {
+                    return address - segment.p_vaddr + segment.p_offset;
+                }
+            }
+            return size;
+        };
+        auto string_at = [&](const size_t offset) -> std::string
+        {
+            if (offset >= size)
+            {
+                return "";
+            }
+            const char* text = reinterpret_cast<const char*>(data + offset);
+            return std::string(text, strnlen(text, size - offset));
+        };
+
+        const Dyn* dynamic = nullptr;
+        size_t dynamic_count = 0;
+        for (size_t i = 0; i < header->e_phnum; ++i)
+        {
+            const Phdr& segment = segments[i];
+            if (segment.p_offset + segment.p_filesz > size)
+            {
+                continue;
+            }
+            if (segment.p_type == PT_INTERP)
+            {
+                result.interpreter = string_at(segment.p_offset);
+            }
+            else if (segment.p_type == PT_DYNAMIC)
+            {
+                dynamic = reinterpret_cast<const Dyn*>(data + segment.p_offset);
+                dynamic_count = segment.p_filesz / sizeof(Dyn);
+            }
+        }
+        if (dynamic == nullptr)
+        {
+            return;
+        }
+
+        size_t strtab = 0;
+        std::vector<size_t> needed;
+        size_t runpath = 0, rpath = 0;
+        bool has_runpath = false, has_rpath = false;
+        for (size_t i = 0; i < dynamic_count && dynamic[i].d_tag != DT_NULL; ++i)
+        {
+            switch (dynamic[i].d_tag)
+            {
+            case DT_STRTAB: strtab = dynamic[i].d_un.d_ptr; break;
+            case DT_NEEDED: needed.push_back(dynamic[i].d_un.d_val); break;
+            case DT_RUNPATH: runpath = dynamic[i].d_un.d_val; has_runpath = true; break;
+            case DT_RPATH: rpath = dynamic[i].d_un.d_val; has_rpath = true; break;
+            default: break;
+            }
+        }
+
+        const size_t strings = offset_of(strtab);
+        if (strings >= size)
+        {
+            return;
+        }
+        for (const size_t name : needed)
+        {
+            result.needed.push_back(string_at(strings + name));
+        }
+        if (has_runpath || has_rpath)
+        {
+            result.runpath = string_at(strings + (has_runpath ? runpath : rpath));
+        }
+    }
+
+    /**
+    * @brief Reads files and their libraries into the page cache, each file once.
+    */
+    struct Prefetcher
+    {
+        std::vector<std::string> library_dirs;
+        std::set<std::string> visited;
+
+        void prefetch(const std::string& path)
+        {
+            if (path.empty() || !visited.insert(path).second)
+            {
+                return;
+            }
+            const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+            {
+                return;
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+            {
+                close(fd);
+                return;
+            }
+            const size_t size = static_cast<size_t>(info.st_size);
+            if (readahead(fd, 0, size) != 0)
+            {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            }
+
+            Dependencies dependencies;
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapped == MAP_FAILED)
+            {
+                return;
+            }
+            const unsigned char* data = static_cast<const unsigned char*>(mapped);
+            if (size > EI_CLASS && std::memcmp(data, ELFMAG, SELFMAG) == 0)
+            {
+                if (data[EI_CLASS] == ELFCLASS64)
+                {
+                    read_dependencies<Elf64_Ehdr, Elf64_Phdr, Elf64_Dyn>(data, size, dependencies);
+                }
+                else if (data[EI_CLASS] == ELFCLASS32)
+                {
+                    read_dependencies<Elf32_Ehdr, Elf32_Phdr, Elf32_Dyn>(data, size, dependencies);
+                }
+            }
+            munmap(mapped, size);
+
+            prefetch(dependencies.interpreter);
+            const std::string origin = path.substr(0, path.rfind('/'));
+            for (const auto& name : dependencies.needed)
+            {
+                prefetch(find_library(name, dependencies.runpath, origin));
+            }
+        }
+
+        // Searches for a library like the dynamic loader: runpath, LD_LIBRARY_PATH, then system directories
+        std::string find_library(const std::string& name, const std::string& runpath, const std::string& origin)
+        {
+            if (name.find('/') != std::string::npos)
+            {
+                return name;
+            }
+            std::vector<std::string> dirs;
+            split_dirs(runpath, origin, dirs);
+            const char* library_path = std::getenv("LD_LIBRARY_PATH");
+            if (library_path != nullptr)
+            {
+                split_dirs(library_path, origin, dirs);
+            }
+            dirs.insert(dirs.end(), library_dirs.begin(), library_dirs.end());
+            for (const auto& dir : dirs)
+            {
+                const std::string candidate = dir + "/" + name;
+                if (access(candidate.c_str(), R_OK) == 0)
+                {
+                    return candidate;
+                }
+            }
+            return "";
+        }
+    };
+
+    void prefetch_thread(const std::vector<std::string> paths)
+    {
+        // Stay out of the way of the operator: lowest CPU priority and idle I/O class
+        const long thread = syscall(SYS_gettid);
+        setpriority(PRIO_PROCESS, static_cast<id_t>(thread), 19);
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+
+        Prefetcher prefetcher;
+        prefetcher.library_dirs = system_library_dirs();
+        for (const auto& path : paths)
+        {
+            prefetcher.prefetch(path);
+        }
+    }
+}
+
+void cash::load_exec_counts()
+{
+    owner = getpid();
+    std::ifstream file(counts_path());
+    unsigned long count;
+    std::string name;
+    while (file >> count >> name)
+    {
+        exec_counts[name] += count;
+    }
+    std::atexit(save_exec_counts);
+}
+
+void cash::record_execution(const std::string& name)
+{
+    // The counts file is whitespace separated
+    if (name.find_first_of(" \t\n") == std::string::npos)
+    {
+        ++exec_counts[name];
+    }
+}
+
+void cash::start_prefetch()
+{
+    std::vector<std::pair<unsigned long, std::string>> ranked;
+    for (const auto& entry : exec_counts)
+    {
+        ranked.emplace_back(entry.second, entry.first);
+    }
+    const size_t count = std::min(HOT_COUNT, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const std::pair<unsigned long, std::string>& a, const std::pair<unsigned long, std::string>& b)
+                      {
+                          return a.first > b.first;
+                      });
+
+    // Commands are resolved before the thread starts, it only reads files
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const std::string path = find_in_path(ranked[i].second);
+        if (!path.empty())
+        {
+            paths.push_back(path);
+        }
+    }
+    if (paths.empty())
+    {
+        return;
+    }
+    std::thread(prefetch_thread, paths).detach();
+}
@@ -0,0 +1,38 @@
+/**
+ * @file prefetch.h
+ * @brief background readahead of frequently executed binaries
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of the execution counter and the prefetch thread.
+ */
+
+
+#ifndef CASH_PREFETCH_H
+#define CASH_PREFETCH_H
+
+#include <string>
+
+namespace cash
+{
+    /**
+    * @brief Loads execution counts from ~/.cash_exec_counts and saves them again when the shell exits.
+    */
+    void load_exec_counts();
+
+    /**
+    * @brief Counts one execution of an external command.
+    *
+    * @param name the command name, as typed.
+    */
+    void record_execution(const std::string& name);
+
+    /**
+    * @brief Starts a low priority thread reading the hottest binaries and their shared libraries into the page cache.
+    *
+    * Libraries are found by following the DT_NEEDED entries of ELF files.
+    */
+    void start_prefetch();
+}
+
+#endif //CASH_PREFETCH_H
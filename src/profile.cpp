@@ -0,0 +1,242 @@
+/**
+ * @file profile.cpp
+ * @brief per-line profiler for cash scripts
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Forks are counted by a pthread_atfork handler and execs right before
+ * execvp, both in a page shared with every descendant of the shell, so a
+ * line is charged for the processes its pipelines, fan-ins and batches
+ * start however deep they are. Each line keeps its own share, what the
+ * lines nested in it did subtracted; total time counts a line once even
+ * when it runs inside itself, as a one-line loop does.
+ */
+
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+#include "profile.h"
+#include "stream.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+    * @brief Counters shared with the children.
+    */
+    struct Counters
+    {
+        std::atomic<unsigned long> forks;
+        std::atomic<unsigned long> execs;
+    };
+
+    /**
+    * @brief What a line did, over all its runs.
+    */
+    struct LineStats
+    {
+        unsigned long runs = 0;
+        double total = 0; //!< Seconds, nested lines included.
+        double self = 0; //!< Seconds, nested lines excluded.
+        unsigned long forks = 0;
+        unsigned long execs = 0;
+    };
+
+    /**
+    * @brief A line running, with what it started from and what its nested lines took.
+    */
+    struct Frame
+    {
+        size_t line;
+        bool outermost; //!< Whether the line is not running already further out.
+        Clock::time_point start;
+        unsigned long forks;
+        unsigned long execs;
+        double nested_time = 0;
+        unsigned long nested_forks = 0;
+        unsigned long nested_execs = 0;
+    };
+
+    // Frames longer than this are cut in the folded stacks
+    const size_t FRAME_WIDTH = 40;
+
+    Counters* counters = nullptr;
+    pid_t owner = 0;
+    std::string folded_path;
+    std::map<size_t, std::string> texts;
+    std::map<size_t, LineStats> stats;
+    std::vector<Frame> frames;
+    std::map<std::string, double> folded; //!< Self seconds by stack of frames.
+    Clock::time_point started;
+
+    void count_fork()
+    {
+        if (counters != nullptr)
+        {
+            ++counters->forks;
+        }
+    }
+
+    // A frame of the folded stacks, where ; separates frames and the last space the value
+    std::string frame_name(const size_t line)
+    {
+        std::string text = texts.count(line) ? texts[line] : "";
+        const size_t start = text.find_first_not_of(" \t");
+        text = start == std::string::npos ? "" : text.substr(start);
+        if (text.size() > FRAME_WIDTH)
+        {
+            text = text.substr(0, FRAME_WIDTH - 3) + "...";
+        }
+        std::replace(text.begin(), text.end(), ';', ',');
+        std::replace(text.begin(), text.end(), '\t', ' ');
+        return std::to_string(line) + ": " + text;
+    }
+
+    void write_report()
+    {
+        // Children exit through here too, only the shell itself reports
+        if (getpid() != owner)
+        {
+            return;
+        }
+        const double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+
+        std::ofstream file(folded_path);
+        for (const auto& entry : folded)
+        {
+            const long long microseconds = static_cast<long long>(entry.second * 1e6);
+            if (microseconds > 0)
+            {
+                file << entry.first << ' ' << microseconds << '\n';
+            }
+        }
+        if (!file)
+        {
+            cash::report("cash", "cannot write the profile to " + folded_path);
+        }
+
+        // Lines taking the most time of their own first
+        std::vector<std::pair<size_t, LineStats>> ranked(stats.begin(), stats.end());
+        std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<size_t, LineStats>& a,
+                                                          const std::pair<size_t, LineStats>& b)
+        {
+            return a.second.self > b.second.self;
+        });
+        std::fprintf(stderr, "cash profile: %.3f s, %lu forks, %lu execs, folded stacks in %s\n",
+                     elapsed, counters->forks.load(), counters->execs.load(), folded_path.c_str());
+        std::fprintf(stderr, "%6s %10s %12s %12s %8s %8s  %s\n",
+                     "line", "runs", "total ms", "self ms", "forks", "execs", "command");
+        for (const auto& entry : ranked)
+        {
+            const LineStats& line = entry.second;
+            std::fprintf(stderr, "%6zu %10lu %12.3f %12.3f %8lu %8lu  %s\n", entry.first, line.runs,
+                         line.total * 1e3, line.self * 1e3, line.forks, line.execs,
+                         texts.count(entry.first) ? texts[entry.first].c_str() : "");
+        }
+    }
+}
+
+void cash::start_profile(const std::string& path)
+{
+    void* shared = mmap(nullptr, sizeof(Counters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        report("cash", "cannot profile: no shared memory for the counters");
+        return;
+    }
+    counters = new (shared) Counters();
+    owner = getpid();
+    folded_path = path;
+    started = Clock::now();
+    pthread_atfork(nullptr, nullptr, count_fork);
+    std::atexit(write_report);
+}
+
+void cash::profile_line(const size_t number, const std::string& text)
+{
+    if (counters != nullptr)
+    {
+        texts[number] = text;
+    }
+}
+
+void cash::profile_exec()
+{
+    if (counters != nullptr)
+    {
+        ++counters->execs;
+    }
+}
+
+cash::ProfileScope::ProfileScope(const size_t line)
+    : active(counters != nullptr && line != 0 && getpid() == owner)
+{
+    if (!active)
+    {
+        return;
+    }
+    Frame frame;
+    frame.line = line;
+    frame.outermost = std::none_of(frames.begin(), frames.end(), [line](const Frame& f)
+    {
+        return f.line == line;
+    });
+    frame.forks = counters->forks.load();
+    frame.execs = counters->execs.load();
+    frame.start = Clock::now();
+    frames.push_back(frame);
+}
+
+cash::ProfileScope::~ProfileScope()
+{
+    if (!active)
+    {
+        return;
+    }
+    const Frame frame = frames.back();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - frame.start).count();
+    const unsigned long forks = counters->forks.load() - frame.forks;
+    const unsigned long execs = counters->execs.load() - frame.execs;
+    const double self = std::max(0.0, elapsed - frame.nested_time);
+
+    LineStats& line = stats[frame.line];
+    if (frame.outermost)
+    {
+        ++line.runs;
+        line.total += elapsed;
+    }
+    line.self += self;
+    line.forks += forks - frame.nested_forks;
+    line.execs += execs - frame.nested_execs;
+
+    // A line running inside itself is one frame
+    std::string stack;
+    for (size_t f = 0; f < frames.size(); ++f)
+    {
+        if (f == 0 || frames[f].line != frames[f - 1].line)
+        {
+            stack += stack.empty() ? "" : ";";
+            stack += frame_name(frames[f].line);
+        }
+    }
+    folded[stack] += self;
+
+    frames.pop_back();
+    if (!frames.empty())
+    {
+        frames.back().nested_time += elapsed;
+        frames.back().nested_forks += forks;
+        frames.back().nested_execs += execs;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * @file profile.h
+ * @brief per-line profiler for cash scripts
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of cash --profile, which counts for each line of
+ * input how often it ran, how long it took and how many processes it
+ * forked and executed.
+ */
+
+
+#ifndef CASH_PROFILE_H
+#define CASH_PROFILE_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace cash
+{
+    /**
+    * @brief Starts profiling; the report is printed to standard error when the shell exits.
+    *
+    * @param folded_path file the folded stacks are written to, for flamegraph.pl and similar tools.
+    */
+    void start_profile(const std::string& folded_path);
+
+    /**
+    * @brief Keeps the text of an input line for the report.
+    *
+    * @param number the line number, from 1.
+    * @param text the line.
+    */
+    void profile_line(size_t number, const std::string& text);
+
+    /**
+    * @brief Counts an exec, called in the child right before it.
+    */
+    void profile_exec();
+
+    /**
+    * @brief Attributes what happens while it lives to a line, nested in the lines already running.
+    *
+    * Does nothing unless profiling, or in children of the shell.
+    */
+    class ProfileScope
+    {
+    public:
+        /**
+        * @param line the line, 0 when not known.
+        */
+        explicit ProfileScope(size_t line);
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+        ~ProfileScope();
+
+    private:
+        bool active;
+    };
+}
+
+#endif //CASH_PROFILE_H
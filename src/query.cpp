@@ -0,0 +1,616 @@
+/**
+ * @file query.cpp
+ * @brief the from-csv, where, select, sort-by and to-text builtins
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Stages of record pipelines. Fused together they hand each other batches
+ * of typed columns, so a value is parsed once, by from-csv, and formatted
+ * once, where the records leave for a stage or command reading text; fed
+ * text themselves, they read it as CSV with a header.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include "filters.h"
+#include "records.h"
+
+namespace
+{
+    // Rows in the batches sort-by hands on
+    const size_t OUTPUT_ROWS = 1 << 16;
+
+    /**
+    * @brief A value of a sort key, read from its column once instead of at every comparison.
+    */
+    struct SortKey
+    {
+        cash::Column::Type type; //!< Of this value alone.
+        int64_t integer;
+        double real; //!< Set for integers too.
+        cash::Field text;
+    };
+
+    // Compares in the order of cash::compare
+    inline int compare_keys(const SortKey& a, const SortKey& b)
+    {
+        if (a.type == cash::Column::INTEGER && b.type == cash::Column::INTEGER)
+        {
+            return (a.integer > b.integer) - (a.integer < b.integer);
+        }
+        const bool a_number = a.type != cash::Column::TEXT;
+        const bool b_number = b.type != cash::Column::TEXT;
+        if (a_number && b_number)
+        {
+            return (a.real > b.real) - (a.real < b.real);
+        }
+        if (a_number != b_number)
+        {
+            return a_number ? -1 : 1;
+        }
+        const int order = std::memcmp(a.text.data, b.text.data, std::min(a.text.size, b.text.size));
+        return order != 0 ? order : (a.text.size > b.text.size) - (a.text.size < b.text.size);
+    }
+
+    /**
+    * @brief from-csv as a pipeline stage, passing its input on as records.
+    */
+    class FromCsv : public cash::RecordStage
+    {
+    public:
+        FromCsv()
+            : RecordStage("from-csv")
+        {
+        }
+
+        /**
+        * @brief Reads the options.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            if (!cash::get_options(args, "d:", options, inputs))
+            {
+                return false;
+            }
+            if (options.count('d'))
+            {
+                const std::string& delimiter = options['d'];
+                if (delimiter != "\\t" && delimiter.size() != 1)
+                {
+                    cash::report("from-csv", "the delimiter must be a single character");
+                    return false;
+                }
+                cash::CsvFormat format;
+                format.delimiter = delimiter == "\\t" ? '\t' : delimiter[0];
+                reader.configure(format);
+            }
+            return true;
+        }
+
+        bool feed_records(const cash::RecordBatch& batch) override
+        {
+            return pass(batch);
+        }
+    };
+
+    /**
+    * @brief where as a pipeline stage, keeping the rows whose value in a column passes a test.
+    */
+    class Where : public cash::RecordStage
+    {
+    public:
+        Where()
+            : RecordStage("where")
+        {
+        }
+
+        /**
+        * @brief Reads the condition: column, operator, value.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            static const std::map<std::string, Operator> operators = {
+                {"==", EQUAL}, {"=", EQUAL}, {"eq", EQUAL}, {"!=", NOT_EQUAL}, {"ne", NOT_EQUAL},
+                {"<", LESS}, {"lt", LESS}, {"<=", LESS_EQUAL}, {"le", LESS_EQUAL},
+                {">", GREATER}, {"gt", GREATER}, {">=", GREATER_EQUAL}, {"ge", GREATER_EQUAL},
+                {"contains", CONTAINS},
+            };
+            if (args.size() != 4 || operators.count(args[2]) == 0)
+            {
+                cash::report("where", "usage: where column ==|!=|<|<=|>|>=|contains value");
+                return false;
+            }
+            column = args[1];
+            test = operators.at(args[2]);
+            value = args[3];
+            literal.text.push_back(cash::Field{value.data(), value.size()});
+            literal.infer();
+            return true;
+        }
+
+        bool feed_records(const cash::RecordBatch& batch) override
+        {
+            if (batch.names != schema)
+            {
+                schema = batch.names;
+                index = batch.find(column);
+            }
+            if (index < 0)
+            {
+                return fail("no column '" + column + "'");
+            }
+
+            const cash::Column& values = *batch.columns[index];
+            selected.clear();
+            if (test == CONTAINS)
+            {
+                for (size_t row = 0; row < batch.rows; ++row)
+                {
+                    const cash::Field& field = values.text[row];
+                    if (memmem(field.data, field.size, value.data(), value.size()) != nullptr)
+                    {
+                        selected.push_back(row);
+                    }
+                }
+            }
+            else if (values.type == cash::Column::INTEGER && literal.type == cash::Column::INTEGER)
+            {
+                // Both sides parsed already, the usual case for numeric columns
+                const int64_t bound = literal.integers[0];
+                for (size_t row = 0; row < batch.rows; ++row)
+                {
+                    const int64_t number = values.integers[row];
+                    if (holds((number > bound) - (number < bound)))
+                    {
+                        selected.push_back(row);
+                    }
+                }
+            }
+            else
+            {
+                // Only numbers are ordered against a number, so empty values never pass > 0
+                const bool numeric = literal.type != cash::Column::TEXT && test != EQUAL && test != NOT_EQUAL;
+                double number;
+                for (size_t row = 0; row < batch.rows; ++row)
+                {
+                    if (numeric && !values.number(row, number))
+                    {
+                        continue;
+                    }
+                    if (holds(cash::compare(values, row, literal, 0)))
+                    {
+                        selected.push_back(row);
+                    }
+                }
+            }
+
+            if (selected.size() == batch.rows)
+            {
+                return pass(batch);
+            }
+            cash::RecordBatch kept;
+            kept.names = batch.names;
+            kept.rows = selected.size();
+            for (const auto& source : batch.columns)
+            {
+                std::shared_ptr<cash::Column> gathered = std::make_shared<cash::Column>();
+                for (const size_t row : selected)
+                {
+                    gathered->append(*source, row);
+                }
+                kept.columns.push_back(gathered);
+            }
+            return pass(kept);
+        }
+
+    private:
+        enum Operator
+        {
+            EQUAL,
+            NOT_EQUAL,
+            LESS,
+            LESS_EQUAL,
+            GREATER,
+            GREATER_EQUAL,
+            CONTAINS
+        };
+
+        // Whether a value comparing so to the literal passes
+        bool holds(const int order) const
+        {
+            switch (test)
+            {
+            case EQUAL:
+                return order == 0;
+            case NOT_EQUAL:
+                return order != 0;
+            case LESS:
+                return order < 0;
+            case LESS_EQUAL:
+                return order <= 0;
+            case GREATER:
+                return order > 0;
+            default:
+                return order >= 0;
+            }
+        }
+
+        std::string column; //!< The column tested, by name or number.
+        Operator test = EQUAL;
+        std::string value; //!< The value compared to.
+        cash::Column literal; //!< The value as a column of one row.
+        std::shared_ptr<const std::vector<std::string>> schema; //!< The names index was found in.
+        long index = -1; //!< The column tested.
+        std::vector<size_t> selected; //!< Rows of the current batch that pass.
+    };
+
+    /**
+    * @brief select as a pipeline stage, keeping some columns in a given order.
+    */
+    class Select : public cash::RecordStage
+    {
+    public:
+        Select()
+            : RecordStage("select")
+        {
+        }
+
+        /**
+        * @brief Reads the columns.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            chosen.assign(args.begin() + 1, args.end());
+            if (chosen.empty())
+            {
+                cash::report("select", "usage: select column...");
+                return false;
+            }
+            return true;
+        }
+
+        bool feed_records(const cash::RecordBatch& batch) override
+        {
+            if (batch.names != schema)
+            {
+                schema = batch.names;
+                indexes.clear();
+                for (const auto& name : chosen)
+                {
+                    const long index = batch.find(name);
+                    if (index < 0)
+                    {
+                        schema.reset();
+                        return fail("no column '" + name + "'");
+                    }
+                    indexes.push_back(static_cast<size_t>(index));
+                }
+                std::shared_ptr<std::vector<std::string>> picked = std::make_shared<std::vector<std::string>>();
+                for (const size_t index : indexes)
+                {
+                    picked->push_back((*batch.names)[index]);
+                }
+                names = picked;
+            }
+
+            // The columns are shared, not copied
+            cash::RecordBatch projected;
+            projected.names = names;
+            projected.rows = batch.rows;
+            for (const size_t index : indexes)
+            {
+                projected.columns.push_back(batch.columns[index]);
+            }
+            return pass(projected);
+        }
+
+    private:
+        std::vector<std::string> chosen; //!< The columns, by name or number.
+        std::shared_ptr<const std::vector<std::string>> schema; //!< The names indexes were found in.
+        std::vector<size_t> indexes; //!< The columns in the current batches.
+        std::shared_ptr<const std::vector<std::string>> names; //!< The names of the columns kept.
+    };
+
+    /**
+    * @brief sort-by as a pipeline stage, holding every record until the input ends.
+    */
+    class SortBy : public cash::RecordStage
+    {
+    public:
+        SortBy()
+            : RecordStage("sort-by")
+        {
+        }
+
+        /**
+        * @brief Reads the options and the key columns.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            if (!cash::get_options(args, "r", options, keys))
+            {
+                return false;
+            }
+            if (keys.empty())
+            {
+                cash::report("sort-by", "usage: sort-by [-r] column...");
+                return false;
+            }
+            reverse = options.count('r') > 0;
+            return true;
+        }
+
+        bool feed_records(const cash::RecordBatch& batch) override
+        {
+            if (!schema)
+            {
+                schema = batch.names;
+                for (const auto& key : keys)
+                {
+                    const long index = batch.find(key);
+                    if (index < 0)
+                    {
+                        return fail("no column '" + key + "'");
+                    }
+                    indexes.push_back(static_cast<size_t>(index));
+                }
+            }
+            if (indexes.size() != keys.size() || batch.columns.size() != schema->size())
+            {
+                return fail("the inputs have different columns");
+            }
+
+            // Batches are gone after the call, so the text is copied
+            std::vector<std::shared_ptr<const cash::Column>> kept;
+            for (const auto& source : batch.columns)
+            {
+                std::shared_ptr<cash::Column> copy = std::make_shared<cash::Column>(*source);
+                for (auto& field : copy->text)
+                {
+                    field.data = strings.store(field.data, field.size);
+                }
+                kept.push_back(copy);
+            }
+            stored.push_back(kept);
+            rows += batch.rows;
+            return true;
+        }
+
+    protected:
+        void complete() override
+        {
+            // Where each record is, and its keys, numbers parsed once even in columns of text
+            const size_t width = indexes.size();
+            std::vector<std::pair<uint32_t, uint32_t>> places;
+            std::vector<SortKey> values;
+            places.reserve(rows);
+            values.reserve(rows * width);
+            for (size_t b = 0; b < stored.size(); ++b)
+            {
+                for (size_t row = 0; row < stored[b][0]->size(); ++row)
+                {
+                    places.emplace_back(b, row);
+                    for (const size_t key : indexes)
+                    {
+                        const cash::Column& column = *stored[b][key];
+                        SortKey value = {cash::Column::TEXT, 0, 0, column.text[row]};
+                        if (column.type == cash::Column::INTEGER)
+                        {
+                            value.type = cash::Column::INTEGER;
+                            value.integer = column.integers[row];
+                            value.real = static_cast<double>(value.integer);
+                        }
+                        else if (column.number(row, value.real))
+                        {
+                            value.type = cash::Column::REAL;
+                        }
+                        values.push_back(value);
+                    }
+                }
+            }
+
+            std::vector<uint32_t> order(places.size());
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = static_cast<uint32_t>(i);
+            }
+            // Stable, so that -r keeps equal keys in their order of arrival
+            std::stable_sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b)
+            {
+                for (size_t k = 0; k < width; ++k)
+                {
+                    const int sign = compare_keys(values[a * width + k], values[b * width + k]);
+                    if (sign != 0)
+                    {
+                        return reverse ? sign > 0 : sign < 0;
+                    }
+                }
+                return false;
+            });
+            std::vector<SortKey>().swap(values);
+
+            for (size_t start = 0; start < order.size(); start += OUTPUT_ROWS)
+            {
+                const size_t stop = std::min(order.size(), start + OUTPUT_ROWS);
+                cash::RecordBatch sorted;
+                sorted.names = schema;
+                sorted.rows = stop - start;
+                for (size_t c = 0; c < schema->size(); ++c)
+                {
+                    std::shared_ptr<cash::Column> column = std::make_shared<cash::Column>();
+                    for (size_t i = start; i < stop; ++i)
+                    {
+                        const std::pair<uint32_t, uint32_t>& place = places[order[i]];
+                        column->append(*stored[place.first][c], place.second);
+                    }
+                    sorted.columns.push_back(column);
+                }
+                if (!pass(sorted))
+                {
+                    break;
+                }
+            }
+            if (order.empty() && schema)
+            {
+                cash::RecordBatch empty;
+                empty.names = schema;
+                empty.columns.assign(schema->size(), std::make_shared<cash::Column>());
+                pass(empty);
+            }
+        }
+
+    private:
+        std::vector<std::string> keys; //!< The key columns, by name or number.
+        bool reverse = false;
+        std::shared_ptr<const std::vector<std::string>> schema; //!< The names of the first batch.
+        std::vector<size_t> indexes; //!< The key columns.
+        std::vector<std::vector<std::shared_ptr<const cash::Column>>> stored; //!< The batches received.
+        cash::Arena strings; //!< Their text.
+        size_t rows = 0;
+    };
+
+    /**
+    * @brief to-text as a pipeline stage, writing records as lines of separated values.
+    */
+    class ToText : public cash::RecordStage
+    {
+    public:
+        ToText()
+            : RecordStage("to-text")
+        {
+        }
+
+        /**
+        * @brief Reads the options.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            std::vector<std::string> operands;
+            if (!cash::get_options(args, "d:H", options, operands))
+            {
+                return false;
+            }
+            if (!operands.empty())
+            {
+                cash::report("to-text", "usage: to-text [-d separator] [-H]");
+                return false;
+            }
+            if (options.count('d'))
+            {
+                separator = options['d'] == "\\t" ? "\t" : options['d'];
+            }
+            header = options.count('H') == 0;
+            return true;
+        }
+
+        bool feed_records(const cash::RecordBatch& batch) override
+        {
+            text.clear();
+            if (header)
+            {
+                for (size_t c = 0; c < batch.names->size(); ++c)
+                {
+                    text += (c > 0 ? separator : "") + (*batch.names)[c];
+                }
+                text += '\n';
+                header = false;
+            }
+            for (size_t row = 0; row < batch.rows; ++row)
+            {
+                for (size_t c = 0; c < batch.columns.size(); ++c)
+                {
+                    if (c > 0)
+                    {
+                        text += separator;
+                    }
+                    const cash::Field& field = batch.columns[c]->text[row];
+                    text.append(field.data, field.size);
+                }
+                text += '\n';
+            }
+            return emit(text.data(), text.size());
+        }
+
+    private:
+        std::string separator = "\t";
+        bool header = true; //!< Whether the column names are still to be written.
+        std::string text; //!< The current batch, formatted.
+    };
+
+    // Builds a stage, or returns nullptr after its compile has reported why not
+    template <typename Kind>
+    std::unique_ptr<cash::Stage> build(const std::vector<std::string>& args)
+    {
+        std::unique_ptr<Kind> stage(new Kind());
+        if (!stage->compile(args))
+        {
+            return nullptr;
+        }
+        return std::unique_ptr<cash::Stage>(stage.release());
+    }
+}
+
+std::unique_ptr<cash::Stage> cash::from_csv_stage(const std::vector<std::string>& args)
+{
+    return build<FromCsv>(args);
+}
+
+int cash::from_csv(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
+
+std::unique_ptr<cash::Stage> cash::where_stage(const std::vector<std::string>& args)
+{
+    return build<Where>(args);
+}
+
+int cash::where(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
+
+std::unique_ptr<cash::Stage> cash::select_stage(const std::vector<std::string>& args)
+{
+    return build<Select>(args);
+}
+
+int cash::select(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
+
+std::unique_ptr<cash::Stage> cash::sort_by_stage(const std::vector<std::string>& args)
+{
+    return build<SortBy>(args);
+}
+
+int cash::sort_by(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
+
+std::unique_ptr<cash::Stage> cash::to_text_stage(const std::vector<std::string>& args)
+{
+    return build<ToText>(args);
+}
+
+int cash::to_text(const std::vector<std::string>& args)
+{
+    return run_stages({args});
+}
@@ -0,0 +1,669 @@
+/**
+ * @file records.cpp
+ * @brief typed record batches passed between pipeline stages
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the typing of columns, the comparison of values, and the CSV
+ * reader and writer at the edges of record pipelines.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "records.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Bytes indexed at a time, little enough for the positions to stay in cache
+    const size_t WINDOW = 1 << 16;
+
+    // Most rows in the batches made from text
+    const size_t BATCH_ROWS = 1 << 14;
+
+    // Longest text taken for a real number
+    const size_t MAX_REAL = 63;
+
+    // Reads an integer of up to 18 digits, which cannot overflow
+    bool parse_integer(const cash::Field& field, int64_t& value)
+    {
+        const char* p = field.data;
+        const char* end = p + field.size;
+        const bool negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            ++p;
+        }
+        if (p == end || end - p > 18)
+        {
+            return false;
+        }
+        int64_t magnitude = 0;
+        for (; p < end; ++p)
+        {
+            if (*p < '0' || *p > '9')
+            {
+                return false;
+            }
+            magnitude = magnitude * 10 + (*p - '0');
+        }
+        value = negative ? -magnitude : magnitude;
+        return true;
+    }
+
+    // Reads a decimal number, leaving out what strtod would also take, like inf or hexadecimal
+    bool parse_real(const cash::Field& field, double& value)
+    {
+        if (field.size == 0 || field.size > MAX_REAL)
+        {
+            return false;
+        }
+        char copy[MAX_REAL + 1];
+        bool digits = false;
+        for (size_t i = 0; i < field.size; ++i)
+        {
+            const char ch = field.data[i];
+            digits = digits || (ch >= '0' && ch <= '9');
+            if (!((ch >= '0' && ch <= '9') || ch == '.' || ch == '-' || ch == '+' || ch == 'e' || ch == 'E'))
+            {
+                return false;
+            }
+            copy[i] = ch;
+        }
+        copy[field.size] = '\0';
+        char* end;
+        value = std::strtod(copy, &end);
+        return digits && end == copy + field.size;
+    }
+
+    // Appends a value, quoted if it holds a delimiter, a quote or a line break
+    void append_csv(const cash::Field& field, std::string& text)
+    {
+        bool quote = false;
+        for (size_t i = 0; i < field.size && !quote; ++i)
+        {
+            const char ch = field.data[i];
+            quote = ch == ',' || ch == '"' || ch == '\n' || ch == '\r';
+        }
+        if (!quote)
+        {
+            text.append(field.data, field.size);
+            return;
+        }
+        text += '"';
+        for (size_t i = 0; i < field.size; ++i)
+        {
+            if (field.data[i] == '"')
+            {
+                text += '"';
+            }
+            text += field.data[i];
+        }
+        text += '"';
+    }
+
+    // Finds a column by name, or by its number from 1 if no column has that name
+    long find_column(const std::vector<std::string>& names, const std::string& name)
+    {
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (names[i] == name)
+            {
+                return static_cast<long>(i);
+            }
+        }
+        if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos && name.size() < 10)
+        {
+            const long number = std::atol(name.c_str());
+            if (number >= 1 && static_cast<size_t>(number) <= names.size())
+            {
+                return number - 1;
+            }
+        }
+        return -1;
+    }
+
+    /**
+    * @brief Marks the quotes, delimiters and line breaks of 64 bytes, one bit per byte.
+    */
+    inline void classify(const char* block, const char delimiter, uint64_t& quotes, uint64_t& delimiters,
+                         uint64_t& newlines)
+    {
+#ifdef __SSE2__
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i separator = _mm_set1_epi8(delimiter);
+        const __m128i newline = _mm_set1_epi8('\n');
+        quotes = delimiters = newlines = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block) + i);
+            const int shift = 16 * i;
+            quotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << shift;
+            delimiters |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, separator)))) << shift;
+            newlines |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)))) << shift;
+        }
+#else
+        quotes = delimiters = newlines = 0;
+        for (int i = 0; i < 64; ++i)
+        {
+            quotes |= static_cast<uint64_t>(block[i] == '"') << i;
+            delimiters |= static_cast<uint64_t>(block[i] == delimiter) << i;
+            newlines |= static_cast<uint64_t>(block[i] == '\n') << i;
+        }
+#endif
+    }
+
+}
+
+void cash::Column::infer()
+{
+    const size_t rows = text.size();
+    integers.clear();
+    reals.clear();
+    type = INTEGER;
+    integers.resize(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (!parse_integer(text[i], integers[i]))
+        {
+            type = REAL;
+            break;
+        }
+    }
+    if (type == REAL)
+    {
+        integers.clear();
+        reals.resize(rows);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            if (!parse_real(text[i], reals[i]))
+            {
+                type = TEXT;
+                reals.clear();
+                break;
+            }
+        }
+    }
+}
+
+void cash::Column::append(const Column& from, const size_t row)
+{
+    if (text.empty())
+    {
+        type = from.type;
+    }
+    else if (type != from.type && type != TEXT)
+    {
+        if (from.type == TEXT)
+        {
+            type = TEXT;
+            integers.clear();
+            reals.clear();
+        }
+        else if (type == INTEGER)
+        {
+            // Integers and reals together make reals
+            reals.assign(integers.begin(), integers.end());
+            integers.clear();
+            type = REAL;
+        }
+    }
+    text.push_back(from.text[row]);
+    if (type == INTEGER)
+    {
+        integers.push_back(from.integers[row]);
+    }
+    else if (type == REAL)
+    {
+        reals.push_back(from.type == INTEGER ? static_cast<double>(from.integers[row]) : from.reals[row]);
+    }
+}
+
+bool cash::Column::number(const size_t row, double& value) const
+{
+    switch (type)
+    {
+    case INTEGER:
+        value = static_cast<double>(integers[row]);
+        return true;
+    case REAL:
+        value = reals[row];
+        return true;
+    default:
+        return parse_real(text[row], value);
+    }
+}
+
+int cash::compare(const Column& left, const size_t i, const Column& right, const size_t j)
+{
+    if (left.type == Column::INTEGER && right.type == Column::INTEGER)
+    {
+        return (left.integers[i] > right.integers[j]) - (left.integers[i] < right.integers[j]);
+    }
+    double a, b;
+    const bool left_number = left.number(i, a);
+    const bool right_number = right.number(j, b);
+    if (left_number && right_number)
+    {
+        return (a > b) - (a < b);
+    }
+    if (left_number != right_number)
+    {
+        return left_number ? -1 : 1;
+    }
+    const Field& x = left.text[i];
+    const Field& y = right.text[j];
+    const int order = std::memcmp(x.data, y.data, std::min(x.size, y.size));
+    if (order != 0)
+    {
+        return order;
+    }
+    return (x.size > y.size) - (x.size < y.size);
+}
+
+long cash::RecordBatch::find(const std::string& name) const
+{
+    return find_column(*names, name);
+}
+
+void cash::write_csv(const RecordBatch& batch, const bool header, std::string& text)
+{
+    const size_t columns = batch.columns.size();
+    if (header)
+    {
+        for (size_t c = 0; c < columns; ++c)
+        {
+            if (c > 0)
+            {
+                text += ',';
+            }
+            const std::string& name = (*batch.names)[c];
+            append_csv(Field{name.data(), name.size()}, text);
+        }
+        text += '\n';
+    }
+    for (size_t row = 0; row < batch.rows; ++row)
+    {
+        for (size_t c = 0; c < columns; ++c)
+        {
+            if (c > 0)
+            {
+                text += ',';
+            }
+            append_csv(batch.columns[c]->text[row], text);
+        }
+        text += '\n';
+    }
+}
+
+cash::CsvReader::CsvReader(const CsvFormat& format)
+    : format(format), positions(WINDOW)
+{
+}
+
+void cash::CsvReader::configure(const CsvFormat& format)
+{
+    this->format = format;
+}
+
+const std::string& cash::CsvReader::error() const
+{
+    return problem;
+}
+
+size_t cash::CsvReader::index(const char* const begin, const char* const end, uint64_t& inside)
+{
+    uint32_t* out = positions.data();
+    char padded[64];
+    for (const char* block = begin; block < end; block += 64)
+    {
+        const char* bytes = block;
+        if (end - block < 64)
+        {
+            // The last bytes, padded with bytes that mark nothing
+            std::memset(padded, 0, sizeof(padded));
+            std::memcpy(padded, block, end - block);
+            bytes = padded;
+        }
+        uint64_t quotes, delimiters, newlines;
+        classify(bytes, format.delimiter, quotes, delimiters, newlines);
+        const uint64_t quoted = format.quoted ? cash::prefix_xor(quotes) ^ inside : 0;
+        // All ones if the block ends inside quotes
+        inside = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+        uint64_t structural = (delimiters | newlines) & ~quoted;
+        const uint32_t base = static_cast<uint32_t>(block - begin);
+        while (structural != 0)
+        {
+            *out++ = base + static_cast<uint32_t>(__builtin_ctzll(structural));
+            structural &= structural - 1;
+        }
+    }
+    return out - positions.data();
+}
+
+cash::Field cash::CsvReader::value(const char* const begin, const char* const end)
+{
+    if (!format.quoted || begin == end || *begin != '"')
+    {
+        return Field{begin, static_cast<size_t>(end - begin)};
+    }
+    // The closing quote is the last one; what follows it, like the \r of a CRLF, is dropped
+    const char* open = begin + 1;
+    const char* close = end;
+    while (close > open && close[-1] != '"')
+    {
+        --close;
+    }
+    close = close > open ? close - 1 : end;
+    const size_t size = close > open ? close - open : 0;
+    if (std::memchr(open, '"', size) == nullptr)
+    {
+        return Field{open, size};
+    }
+    scratch.clear();
+    for (const char* c = open; c < close; ++c)
+    {
+        scratch += *c;
+        c += *c == '"';
+    }
+    return Field{unquoted.store(scratch.data(), scratch.size()), scratch.size()};
+}
+
+bool cash::CsvReader::start(const std::vector<Field>& first)
+{
+    std::vector<std::string> all;
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        all.push_back(format.header ? std::string(first[i].data, first[i].size) : std::to_string(i + 1));
+    }
+    names = std::make_shared<std::vector<std::string>>();
+    slots.assign(all.size(), -1);
+    if (format.columns.empty())
+    {
+        *names = all;
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            slots[i] = static_cast<long>(i);
+        }
+        return true;
+    }
+    for (const auto& column : format.columns)
+    {
+        const long found = find_column(all, column);
+        if (found < 0 || slots[found] >= 0)
+        {
+            problem = found < 0 ? "no column '" + column + "'" : "column '" + column + "' is kept twice";
+            names.reset();
+            return false;
+        }
+        slots[found] = static_cast<long>(names->size());
+        names->push_back(all[found]);
+    }
+    return true;
+}
+
+const char* cash::CsvReader::parse(const char* const begin, const char* const end, const bool last,
+                                   const BatchConsumer& consumer, bool& more)
+{
+    std::vector<Column> columns(names ? names->size() : 0);
+    size_t rows = 0;
+    more = true;
+    // Hands on the rows read so far; the quoted fields they pointed to are gone after
+    auto send = [&]()
+    {
+        RecordBatch batch;
+        batch.names = names;
+        batch.rows = rows;
+        for (auto& column : columns)
+        {
+            // Fields of a record that is not complete yet stay behind
+            column.text.resize(rows);
+            column.infer();
+            batch.columns.push_back(std::make_shared<Column>(std::move(column)));
+        }
+        more = consumer(batch);
+        columns.assign(names->size(), Column());
+        for (auto& column : columns)
+        {
+            column.text.reserve(BATCH_ROWS);
+        }
+        rows = 0;
+        unquoted.clear();
+    };
+
+    std::vector<Field> first; // The fields of the first record, until it names the columns
+    const char* record = begin;
+    const char* field = begin;
+    size_t number = 0; // Of the field in its record
+    auto take = [&](const char* stop)
+    {
+        if (!names)
+        {
+            first.push_back(value(field, stop));
+        }
+        else if (number < slots.size() && slots[number] >= 0)
+        {
+            columns[slots[number]].text.push_back(value(field, stop));
+        }
+    };
+    // Ends a record at a line break or at the end of the input
+    auto close = [&](const char* stop)
+    {
+        if (stop > field && stop[-1] == '\r' && !(format.quoted && *field == '"'))
+        {
+            --stop;
+        }
+        if (number == 0 && stop == field)
+        {
+            // Blank lines hold no record
+            return;
+        }
+        take(stop);
+        if (!names)
+        {
+            if (!start(first))
+            {
+                more = false;
+                return;
+            }
+            columns.resize(names->size());
+            if (format.header)
+            {
+                first.clear();
+                return;
+            }
+            // Without a header the first record is data too
+            for (size_t i = 0; i < first.size(); ++i)
+            {
+                if (slots[i] >= 0)
+                {
+                    columns[slots[i]].text.push_back(first[i]);
+                }
+            }
+            first.clear();
+        }
+        // Missing values are empty, extra ones were dropped
+        ++rows;
+        for (auto& column : columns)
+        {
+            if (column.text.size() < rows)
+            {
+                column.text.push_back(Field{"", 0});
+            }
+        }
+        // A mapped file comes in one piece, which still goes out in batches that stay in cache
+        if (rows == BATCH_ROWS)
+        {
+            send();
+        }
+    };
+
+    uint64_t inside = 0;
+    for (const char* window = begin; window < end && more; window += WINDOW)
+    {
+        const char* const stop = window + std::min<size_t>(WINDOW, end - window);
+        const size_t count = index(window, stop, inside);
+        for (size_t i = 0; i < count && more; ++i)
+        {
+            const char* const p = window + positions[i];
+            if (*p == format.delimiter)
+            {
+                take(p);
+                ++number;
+            }
+            else
+            {
+                close(p);
+                record = p + 1;
+                number = 0;
+            }
+            field = p + 1;
+        }
+    }
+    if (more && last && record < end)
+    {
+        close(end);
+        record = end;
+    }
+    if (more && rows > 0)
+    {
+        send();
+    }
+    return record;
+}
+
+bool cash::CsvReader::feed(const char* data, size_t size, const BatchConsumer& consumer)
+{
+    if (!problem.empty())
+    {
+        return false;
+    }
+    bool more = true;
+    if (!pending.empty())
+    {
+        // The unfinished record mostly ends at the next line break, so only that much is copied
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+        size_t taken = newline != nullptr ? newline - data + 1 : size;
+        pending.append(data, taken);
+        const char* done = parse(pending.data(), pending.data() + pending.size(), false, consumer, more);
+        if (!more)
+        {
+            return false;
+        }
+        if (done != pending.data() + pending.size())
+        {
+            // A quoted line break: the rest of the chunk is added too, instead of a line at a time
+            pending.erase(0, done - pending.data());
+            pending.append(data + taken, size - taken);
+            taken = size;
+            done = parse(pending.data(), pending.data() + pending.size(), false, consumer, more);
+            pending.erase(0, done - pending.data());
+            return more;
+        }
+        pending.clear();
+        data += taken;
+        size -= taken;
+    }
+    const char* done = parse(data, data + size, false, consumer, more);
+    pending.assign(done, data + size - done);
+    return more;
+}
+
+bool cash::CsvReader::finish(const BatchConsumer& consumer)
+{
+    bool more = problem.empty();
+    if (more && !pending.empty())
+    {
+        parse(pending.data(), pending.data() + pending.size(), true, consumer, more);
+        pending.clear();
+    }
+    names.reset();
+    return more;
+}
+
+cash::RecordStage::RecordStage(const std::string& name)
+    : name(name)
+{
+}
+
+bool cash::RecordStage::feed(const char* data, const size_t size)
+{
+    return parsed(reader.feed(data, size, [this](const RecordBatch& batch)
+    {
+        return feed_parsed(batch);
+    }));
+}
+
+void cash::RecordStage::begin_input(const std::string&)
+{
+    // The last record of the previous file, whose header no longer applies
+    parsed(reader.finish([this](const RecordBatch& batch)
+    {
+        return feed_parsed(batch);
+    }));
+}
+
+void cash::RecordStage::finish()
+{
+    parsed(reader.finish([this](const RecordBatch& batch)
+    {
+        return feed_parsed(batch);
+    }));
+    complete();
+    if (!sent && names)
+    {
+        RecordBatch empty;
+        empty.names = names;
+        empty.columns.assign(names->size(), std::make_shared<Column>());
+        emit_records(empty);
+    }
+    end();
+}
+
+int cash::RecordStage::status() const
+{
+    return failed ? 1 : 0;
+}
+
+bool cash::RecordStage::pass(const RecordBatch& batch)
+{
+    names = batch.names;
+    if (batch.rows == 0)
+    {
+        return true;
+    }
+    sent = true;
+    return emit_records(batch);
+}
+
+bool cash::RecordStage::fail(const std::string& message)
+{
+    if (!failed)
+    {
+        report(name, message);
+    }
+    failed = true;
+    return false;
+}
+
+void cash::RecordStage::complete()
+{
+}
+
+bool cash::RecordStage::feed_parsed(const RecordBatch& batch)
+{
+    return feed_records(batch);
+}
+
+bool cash::RecordStage::parsed(const bool more)
+{
+    if (!more && !reader.error().empty())
+    {
+        return fail(reader.error());
+    }
+    return more;
+}
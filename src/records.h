@@ -0,0 +1,261 @@
+/**
+ * @file records.h
+ * @brief typed record batches passed between pipeline stages
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the columnar batches that from-csv, where, select, sort-by and
+ * to-text exchange instead of text, the CSV reader turning text into them
+ * and the writer turning them back into text where a stage or command that
+ * reads bytes takes over.
+ */
+
+
+#ifndef CASH_RECORDS_H
+#define CASH_RECORDS_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "stream.h"
+#include "table.h"
+
+namespace cash
+{
+    /**
+    * @brief A value as written, pointing into the input or into an arena.
+    */
+    struct Field
+    {
+        const char* data;
+        size_t size;
+    };
+
+    /**
+    * @brief The values of one column in a batch.
+    *
+    * Every value keeps its text, which is what gets written out; columns
+    * whose values are all numbers also have them parsed, once, for the
+    * comparisons of later stages.
+    */
+    class Column
+    {
+    public:
+        enum Type
+        {
+            TEXT,
+            INTEGER,
+            REAL
+        };
+
+        Type type = TEXT;
+        std::vector<Field> text; //!< Every value as written.
+        std::vector<int64_t> integers; //!< The values of INTEGER columns.
+        std::vector<double> reals; //!< The values of REAL columns.
+
+        /**
+        * @brief Parses the text, making the column INTEGER or REAL if every value is a number.
+        */
+        void infer();
+
+        /**
+        * @brief Appends a value of another column, widening the type when they differ.
+        *
+        * @param from the column.
+        * @param row the row of the value.
+        */
+        void append(const Column& from, size_t row);
+
+        /**
+        * @brief Reads a value as a number.
+        *
+        * @return false if the value is not a number.
+        */
+        bool number(size_t row, double& value) const;
+
+        size_t size() const { return text.size(); }
+    };
+
+    /**
+    * @brief Compares two values: numbers by value and before text, text byte by byte.
+    *
+    * @return negative, zero or positive, like strcmp.
+    */
+    int compare(const Column& left, size_t i, const Column& right, size_t j);
+
+    /**
+    * @brief Rows of named columns, only valid during the call they are passed to.
+    */
+    struct RecordBatch
+    {
+        std::shared_ptr<const std::vector<std::string>> names; //!< Column names.
+        std::vector<std::shared_ptr<const Column>> columns; //!< One per name.
+        size_t rows = 0;
+
+        /**
+        * @brief Finds a column by name, or by its number from 1 if no column has that name.
+        *
+        * @return the index, or -1.
+        */
+        long find(const std::string& name) const;
+    };
+
+    /**
+    * @brief Appends records as CSV text.
+    *
+    * @param batch the records.
+    * @param header whether to write the column names first.
+    * @param text where to append.
+    */
+    void write_csv(const RecordBatch& batch, bool header, std::string& text);
+
+    /**
+    * @brief How a CsvReader reads its text.
+    */
+    struct CsvFormat
+    {
+        char delimiter = ',';
+        bool quoted = true; //!< Whether double quotes enclose fields, as in RFC 4180; not in TSV.
+        bool header = true; //!< Whether the first record names the columns; they are numbered otherwise.
+        std::vector<std::string> columns; //!< Columns to keep, by name or number, or empty for all.
+    };
+
+    /**
+    * @brief Turns CSV text, fed in chunks of any size, into batches.
+    *
+    * Parsing runs in two passes over windows of the input. The first finds
+    * the delimiters and line breaks outside quotes 64 bytes at a time with
+    * SSE2, telling what is inside quotes by a prefix XOR of the quote mask.
+    * The second walks those positions, storing only the fields of the kept
+    * columns. Fields point into the chunk they came in, so batches go out
+    * before the chunk is gone; quoted fields with doubled quotes are undone
+    * into an arena.
+    */
+    class CsvReader
+    {
+    public:
+        typedef std::function<bool(const RecordBatch& batch)> BatchConsumer;
+
+        explicit CsvReader(const CsvFormat& format = CsvFormat());
+
+        /**
+        * @brief Changes the format, before any input.
+        */
+        void configure(const CsvFormat& format);
+
+        /**
+        * @brief Parses a chunk.
+        *
+        * @param consumer takes the batches of records completed by the chunk.
+        * @return false when the consumer wants no more, or on an error.
+        */
+        bool feed(const char* data, size_t size, const BatchConsumer& consumer);
+
+        /**
+        * @brief Ends an input, passing on its last record, and expects a header next.
+        *
+        * @return false when the consumer wants no more, or on an error.
+        */
+        bool finish(const BatchConsumer& consumer);
+
+        /**
+        * @brief Why parsing stopped, such as a kept column missing from the header, or empty.
+        */
+        const std::string& error() const;
+
+    private:
+        /**
+        * @brief Parses the records completed in a range, which starts a record.
+        *
+        * @param last whether the range ends the input.
+        * @return the end of the last complete record.
+        */
+        const char* parse(const char* begin, const char* end, bool last, const BatchConsumer& consumer, bool& more);
+
+        /**
+        * @brief Finds the delimiters and line breaks outside quotes in a window.
+        *
+        * @param inside all ones if the window starts inside quotes, updated for the next one.
+        * @return the number of positions found.
+        */
+        size_t index(const char* begin, const char* end, uint64_t& inside);
+
+        /**
+        * @brief Names the columns from the first record and finds the kept ones.
+        *
+        * @return false if a kept column is not there.
+        */
+        bool start(const std::vector<Field>& first);
+
+        // The value of a field, without its quotes
+        Field value(const char* begin, const char* end);
+
+        CsvFormat format;
+        std::string pending; //!< The start of a record that did not end in its chunk.
+        std::shared_ptr<std::vector<std::string>> names; //!< Names of the kept columns, once known.
+        std::vector<long> slots; //!< The column each field goes to, or -1.
+        std::vector<uint32_t> positions; //!< Delimiters and line breaks of the current window.
+        Arena unquoted; //!< Quoted fields with doubled quotes, undone.
+        std::string scratch; //!< Room for undoing doubled quotes.
+        std::string problem; //!< Why parsing stopped, if it did.
+    };
+
+    /**
+    * @brief A stage taking records, from earlier record stages or as CSV text.
+    */
+    class RecordStage : public Stage
+    {
+    public:
+        /**
+        * @brief Creates a stage.
+        *
+        * @param name builtin name, for error messages.
+        */
+        explicit RecordStage(const std::string& name);
+
+        bool feed(const char* data, size_t size) override;
+        void begin_input(const std::string& name) override;
+        void finish() override;
+        int status() const override;
+
+    protected:
+        /**
+        * @brief Passes records on, holding back empty batches until the end.
+        *
+        * Text further down still gets the column names when no row makes it through.
+        */
+        bool pass(const RecordBatch& batch);
+
+        /**
+        * @brief Called once all records are in, before the output ends.
+        */
+        virtual void complete();
+
+        /**
+        * @brief Takes the records parsed from text input, the same as records from a stage unless overridden.
+        */
+        virtual bool feed_parsed(const RecordBatch& batch);
+
+        /**
+        * @brief Reports an error, the first one only, and makes the status 1.
+        *
+        * @return false, for stages to return when they stop.
+        */
+        bool fail(const std::string& message);
+
+        CsvReader reader; //!< Parses text input.
+
+    private:
+        // Reports why the reader stopped, if it failed
+        bool parsed(bool more);
+
+        std::string name; //!< Builtin name.
+        bool failed = false;
+        bool sent = false; //!< Whether a batch went out.
+        std::shared_ptr<const std::vector<std::string>> names; //!< The columns of the last batch seen.
+    };
+}
+
+#endif //CASH_RECORDS_H
@@ -0,0 +1,205 @@
+/**
+ * @file redirect.cpp
+ * @brief file descriptor redirections for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * A command's redirections are applied in the shell itself, so builtins
+ * see them, and spawned commands inherit them. The descriptors they
+ * replace are copied above 10, close-on-exec, and put back afterwards.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include "profile.h"
+#include "redirect.h"
+#include "stream.h"
+
+namespace
+{
+    // Copies of replaced descriptors stay clear of the ones scripts use
+    const int SAVED_BASE = 10;
+
+    // How many commands running in the shell have redirected each descriptor
+    std::map<int, int> active_counts;
+
+    // Reads up to 4 digits, as descriptors are small
+    bool parse_descriptor(const std::string& word, size_t& position, int& fd)
+    {
+        const size_t begin = position;
+        fd = 0;
+        while (position < word.size() && position - begin < 4 && word[position] >= '0' && word[position] <= '9')
+        {
+            fd = fd * 10 + (word[position++] - '0');
+        }
+        return position > begin;
+    }
+
+    /**
+    * @brief Recognizes [n]>&m, [n]<&m, [n]>&- and [n]<&-.
+    *
+    * @param word the word to check.
+    * @param fd set to the redirected descriptor.
+    * @param source set to the descriptor it becomes a copy of, -1 to close it.
+    * @return true if word is a redirection.
+    */
+    bool parse_redirection(const std::string& word, int& fd, int& source)
+    {
+        size_t position = 0;
+        const bool numbered = parse_descriptor(word, position, fd);
+        if (position + 2 > word.size() || (word[position] != '>' && word[position] != '<') || word[position + 1] != '&')
+        {
+            return false;
+        }
+        if (!numbered)
+        {
+            fd = word[position] == '>' ? STDOUT_FILENO : STDIN_FILENO;
+        }
+        position += 2;
+        if (position + 1 == word.size() && word[position] == '-')
+        {
+            source = -1;
+            return true;
+        }
+        return parse_descriptor(word, position, source) && position == word.size();
+    }
+}
+
+cash::Redirections::~Redirections()
+{
+    restore();
+}
+
+void cash::Redirections::take(std::vector<std::string>& words, size_t* list_begin, size_t* list_end)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        int fd = 0, source = 0;
+        if (parse_redirection(words[i], fd, source))
+        {
+            redirections.emplace_back(fd, source);
+            // The indexes of a word list after it move down
+            if (list_begin != nullptr && *list_begin > kept)
+            {
+                --*list_begin;
+            }
+            if (list_end != nullptr && *list_end > kept)
+            {
+                --*list_end;
+            }
+            continue;
+        }
+        if (kept != i)
+        {
+            words[kept] = std::move(words[i]);
+        }
+        ++kept;
+    }
+    words.resize(kept);
+}
+
+bool cash::Redirections::empty() const
+{
+    return redirections.empty();
+}
+
+bool cash::Redirections::apply(const std::string& name)
+{
+    std::cout.flush();
+    for (const auto& redirection : redirections)
+    {
+        const int fd = redirection.first;
+        const int source = redirection.second;
+        if (source != -1 && fcntl(source, F_GETFD) == -1)
+        {
+            report(name, std::to_string(source) + ": " + strerror(EBADF));
+            restore();
+            return false;
+        }
+        bool saved_already = false;
+        for (const auto& copy : saved)
+        {
+            saved_already = saved_already || copy.first == fd;
+        }
+        if (!saved_already)
+        {
+            saved.emplace_back(fd, fcntl(fd, F_DUPFD_CLOEXEC, SAVED_BASE));
+            ++active_counts[fd];
+        }
+        if (source == -1)
+        {
+            close(fd);
+        }
+        else if (source != fd)
+        {
+            dup2(source, fd);
+        }
+    }
+    return true;
+}
+
+void cash::Redirections::restore()
+{
+    if (saved.empty())
+    {
+        return;
+    }
+    std::cout.flush();
+    for (auto copy = saved.rbegin(); copy != saved.rend(); ++copy)
+    {
+        if (copy->second == -1)
+        {
+            close(copy->first);
+        }
+        else
+        {
+            dup2(copy->second, copy->first);
+            close(copy->second);
+        }
+        --active_counts[copy->first];
+    }
+    saved.clear();
+}
+
+void cash::Redirections::keep()
+{
+    for (const auto& copy : saved)
+    {
+        if (copy.second != -1)
+        {
+            close(copy.second);
+        }
+        --active_counts[copy.first];
+    }
+    saved.clear();
+}
+
+bool cash::Redirections::active(const int fd)
+{
+    const auto found = active_counts.find(fd);
+    return found != active_counts.end() && found->second > 0;
+}
+
+int cash::exec(const std::vector<std::string>& args)
+{
+    if (args.size() == 1)
+    {
+        return 0;
+    }
+    std::vector<char*> c_args;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        c_args.push_back(const_cast<char*>(args[i].c_str()));
+    }
+    c_args.push_back(nullptr);
+    std::cout.flush();
+    profile_exec();
+    execvp(c_args[0], c_args.data());
+    report("exec", args[1] + ": " + strerror(errno));
+    return 127;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file redirect.h
+ * @brief file descriptor redirections for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of the [n]>&m, [n]<&m and [n]>&- words of a
+ * command, which point its descriptors at others, such as the pipes of a
+ * coprocess, and of exec, which keeps them for the shell itself.
+ */
+
+
+#ifndef CASH_REDIRECT_H
+#define CASH_REDIRECT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief The redirections of a command, undone when it is destroyed.
+    *
+    * Only duplications are redirections: a lone > stays a word, as where
+    * age > 30 needs it to.
+    */
+    class Redirections
+    {
+    public:
+        Redirections() = default;
+        Redirections(const Redirections&) = delete;
+        Redirections& operator=(const Redirections&) = delete;
+
+        /**
+        * @brief Puts back the descriptors the redirections replaced, unless kept.
+        */
+        ~Redirections();
+
+        /**
+        * @brief Takes the redirection words out of an expanded command.
+        *
+        * @param words the command, left with the other words.
+        * @param list_begin if given, the start of a word list in words, moved down past removed words.
+        * @param list_end if given, one past the end of that list, moved likewise.
+        */
+        void take(std::vector<std::string>& words, size_t* list_begin = nullptr, size_t* list_end = nullptr);
+
+        /**
+        * @brief Whether the command had no redirections.
+        */
+        bool empty() const;
+
+        /**
+        * @brief Applies the redirections, saving the descriptors they replace.
+        *
+        * @param name command name, for error messages.
+        * @return false after reporting a descriptor that is not open, with nothing applied.
+        */
+        bool apply(const std::string& name);
+
+        /**
+        * @brief Puts back the descriptors the redirections replaced.
+        */
+        void restore();
+
+        /**
+        * @brief Makes the applied redirections permanent, as exec does.
+        */
+        void keep();
+
+        /**
+        * @brief Whether a descriptor of the shell is redirected by a command running in it.
+        *
+        * @param fd the descriptor.
+        */
+        static bool active(int fd);
+
+    private:
+        std::vector<std::pair<int, int>> redirections; //!< Descriptor and its new source, -1 to close it.
+        std::vector<std::pair<int, int>> saved; //!< Descriptor and a copy of what it was, -1 if it was closed.
+    };
+
+    /**
+    * @brief Keeps redirections for the shell, or replaces the shell with a command: exec [command [arg...]]
+    *
+    * The redirections are taken and applied by execute_command before this runs.
+    *
+    * @param args arguments.
+    * @return 0 without a command, 127 if the command cannot be run.
+    */
+    int exec(const std::vector<std::string>& args);
+}
+
+#endif //CASH_REDIRECT_H
@@ -0,0 +1,348 @@
+/**
+ * @file seq.cpp
+ * @brief the seq builtin, for integers
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Numbers are turned into digits 8 or 16 at a time with SSE2: the value is
+ * split into groups of four digits, each group is broadcast across 16-bit
+ * lanes and divided by 1000, 100, 10 and 1 through multiplications, and the
+ * digits are what remains after subtracting ten times the lane before.
+ * Output is built in fresh pages that are moved into the pipe with vmsplice.
+ * Fractions, formats and numbers beyond 64 bits go to the seq in PATH.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Size of the blocks output is built in
+    const size_t BLOCK_SIZE = 1 << 20;
+
+    // Longest number, -9223372036854775808
+    const size_t MAX_DIGITS = 20;
+
+    // Digits are stored 16 bytes at a time, overwriting up to this much past the number
+    const size_t SLACK = 16;
+
+#ifdef __SSE2__
+    // The 8 digits of a value below 10^8, as 16-bit lanes
+    inline __m128i eight_digits(const uint32_t value)
+    {
+        const __m128i divide_10000 = _mm_set1_epi32(static_cast<int>(0xd1b71759));
+        const __m128i ten_thousand = _mm_set1_epi32(10000);
+        // Reciprocals of 1000, 100, 10 and 1, scaled to fit 16 bits, then the shifts undoing the scaling
+        const __m128i divide_powers = _mm_setr_epi16(8389, 5243, 13108, static_cast<short>(32768),
+                                                     8389, 5243, 13108, static_cast<short>(32768));
+        const __m128i shift_powers = _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, static_cast<short>(1 << 15),
+                                                    1 << 7, 1 << 11, 1 << 13, static_cast<short>(1 << 15));
+        const __m128i ten = _mm_set1_epi16(10);
+
+        const __m128i both = _mm_cvtsi32_si128(static_cast<int>(value));
+        const __m128i high = _mm_srli_epi64(_mm_mul_epu32(both, divide_10000), 45);
+        const __m128i low = _mm_sub_epi32(both, _mm_mul_epu32(high, ten_thousand));
+
+        // Each group of four digits times 4, in four lanes
+        const __m128i groups = _mm_slli_epi64(_mm_unpacklo_epi16(high, low), 2);
+        const __m128i pairs = _mm_unpacklo_epi16(groups, groups);
+        const __m128i spread = _mm_unpacklo_epi32(pairs, pairs);
+
+        // a, ab, abc, abcd, e, ef, efg, efgh
+        const __m128i prefixes = _mm_mulhi_epu16(_mm_mulhi_epu16(spread, divide_powers), shift_powers);
+        // Minus 0, a0, ab0, abc0, 0, e0, ef0, efg0
+        return _mm_sub_epi16(prefixes, _mm_slli_epi64(_mm_mullo_epi16(prefixes, ten), 16));
+    }
+
+    // Stores 16 bytes of digits without their leading zeros, returns how many digits are left
+    inline size_t store_digits(__m128i digits, char* out)
+    {
+        const unsigned zeros = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(digits, _mm_set1_epi8('0'))));
+        // The last digit stays, even when it is a zero
+        const unsigned skip = __builtin_ctz(~zeros | 0x8000);
+        // SSE2 only shifts bytes by constants, so by 8, 4, 2 and 1 as the bits of the count say
+        if (skip & 8)
+        {
+            digits = _mm_srli_si128(digits, 8);
+        }
+        if (skip & 4)
+        {
+            digits = _mm_srli_si128(digits, 4);
+        }
+        if (skip & 2)
+        {
+            digits = _mm_srli_si128(digits, 2);
+        }
+        if (skip & 1)
+        {
+            digits = _mm_srli_si128(digits, 1);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), digits);
+        return 16 - skip;
+    }
+#endif
+
+    /**
+    * @brief Writes the decimal digits of a value.
+    *
+    * @param value the value.
+    * @param out room for MAX_DIGITS + SLACK bytes, the bytes after the digits are overwritten.
+    * @return the number of digits.
+    */
+    inline size_t put_digits(const uint64_t value, char* out)
+    {
+#ifdef __SSE2__
+        if (value < 100000000)
+        {
+            // Eight digits in the high half, behind eight zeros
+            return store_digits(_mm_add_epi8(_mm_packus_epi16(_mm_setzero_si128(),
+                                                              eight_digits(static_cast<uint32_t>(value))),
+                                             _mm_set1_epi8('0')), out);
+        }
+        if (value < 10000000000000000ULL)
+        {
+            return store_digits(_mm_add_epi8(_mm_packus_epi16(eight_digits(static_cast<uint32_t>(value / 100000000)),
+                                                              eight_digits(static_cast<uint32_t>(value % 100000000))),
+                                             _mm_set1_epi8('0')), out);
+        }
+        // At most 4 more digits in front of the last 16
+        const size_t length = put_digits(value / 10000000000000000ULL, out);
+        const uint64_t rest = value % 10000000000000000ULL;
+        const __m128i sixteen = _mm_add_epi8(
+            _mm_packus_epi16(eight_digits(static_cast<uint32_t>(rest / 100000000)),
+                             eight_digits(static_cast<uint32_t>(rest % 100000000))),
+            _mm_set1_epi8('0'));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + length), sixteen);
+        return length + 16;
+#else
+        char digits[MAX_DIGITS];
+        size_t length = 0;
+        uint64_t left = value;
+        do
+        {
+            digits[MAX_DIGITS - ++length] = static_cast<char>('0' + left % 10);
+            left /= 10;
+        } while (left != 0);
+        std::memcpy(out, digits + MAX_DIGITS - length, length);
+        return length;
+#endif
+    }
+
+    /**
+    * @brief Writes a number, padded with zeros after the sign to a width.
+    *
+    * @param out room for the width, or for MAX_DIGITS + SLACK bytes.
+    * @return the number of bytes written.
+    */
+    inline size_t format(const int64_t value, char* out, const size_t width)
+    {
+        const uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        size_t size = 0;
+        if (value < 0)
+        {
+            out[size++] = '-';
+        }
+        if (width == 0)
+        {
+            return size + put_digits(magnitude, out + size);
+        }
+        char digits[MAX_DIGITS + SLACK];
+        const size_t length = put_digits(magnitude, digits);
+        if (size + length < width)
+        {
+            std::memset(out + size, '0', width - size - length);
+            size = width - length;
+        }
+        std::memcpy(out + size, digits, length);
+        return size + length;
+    }
+
+    // Reads an integer operand, false for anything else
+    bool parse_integer(const std::string& text, int64_t& value)
+    {
+        const size_t start = !text.empty() && (text[0] == '-' || text[0] == '+') ? 1 : 0;
+        if (text.size() == start || text.find_first_not_of("0123456789", start) != std::string::npos)
+        {
+            return false;
+        }
+        errno = 0;
+        value = std::strtoll(text.c_str(), nullptr, 10);
+        return errno == 0;
+    }
+
+    /**
+    * @brief What the command line asks for.
+    */
+    struct Sequence
+    {
+        int64_t first = 1;
+        int64_t step = 1;
+        int64_t last = 0;
+        std::string separator = "\n";
+        bool equal_width = false;
+    };
+
+    // Reads the command line, false if it is for the seq in PATH
+    bool parse(const std::vector<std::string>& args, Sequence& sequence)
+    {
+        std::vector<std::string> operands;
+        size_t i = 1;
+        // Negative numbers are operands, not options
+        for (; i < args.size() && args[i].size() > 1 && args[i][0] == '-'
+               && !(args[i][1] >= '0' && args[i][1] <= '9'); ++i)
+        {
+            const std::string& arg = args[i];
+            if (arg == "--")
+            {
+                ++i;
+                break;
+            }
+            if (arg == "-w")
+            {
+                sequence.equal_width = true;
+            }
+            else if (arg.compare(0, 2, "-s") == 0)
+            {
+                if (arg.size() > 2)
+                {
+                    sequence.separator = arg.substr(2);
+                }
+                else if (i + 1 < args.size())
+                {
+                    sequence.separator = args[++i];
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        operands.assign(args.begin() + i, args.end());
+
+        int64_t numbers[3];
+        if (operands.empty() || operands.size() > 3)
+        {
+            return false;
+        }
+        for (size_t n = 0; n < operands.size(); ++n)
+        {
+            if (!parse_integer(operands[n], numbers[n]))
+            {
+                return false;
+            }
+        }
+        sequence.last = numbers[operands.size() - 1];
+        if (operands.size() > 1)
+        {
+            sequence.first = numbers[0];
+        }
+        if (operands.size() == 3)
+        {
+            sequence.step = numbers[1];
+        }
+        return true;
+    }
+}
+
+int cash::seq(const std::vector<std::string>& args)
+{
+    Sequence sequence;
+    if (!parse(args, sequence))
+    {
+        return spawn(args);
+    }
+    if (sequence.step == 0)
+    {
+        report("seq", "invalid Zero increment value: '0'");
+        return 1;
+    }
+
+    size_t width = 0;
+    if (sequence.equal_width)
+    {
+        char digits[MAX_DIGITS + SLACK];
+        width = std::max(format(sequence.first, digits, 0), format(sequence.last, digits, 0));
+    }
+    // Room for one more number and what follows it
+    const size_t margin = std::max(width, MAX_DIGITS + 1) + SLACK + sequence.separator.size() + 1;
+    const size_t block_size = std::max(BLOCK_SIZE, 4 * margin);
+
+    SpliceWriter writer;
+    std::unique_ptr<Pages> block(new Pages(block_size));
+    if (block->data() == nullptr)
+    {
+        report("seq", strerror(errno));
+        return 1;
+    }
+    // Sends what was written and returns where to write next; the position is kept out of
+    // the lambda's captures so that the stores of digits do not force it back to memory
+    bool ok = true;
+    auto send = [&](const char* end)
+    {
+        ok = writer.send(block->data(), end - block->data());
+        // Pages given to the pipe are never written again
+        if (ok && writer.splicing())
+        {
+            block.reset(new Pages(block_size));
+            ok = block->data() != nullptr;
+        }
+        return block->data();
+    };
+
+    const bool up = sequence.step > 0;
+    const int64_t step = sequence.step, last = sequence.last;
+    const std::string separator = sequence.separator;
+    const char single = separator.size() == 1 ? separator[0] : '\0';
+    char* position = block->data();
+    char* limit = position + block_size - margin;
+    int64_t value = sequence.first;
+    bool any = false;
+    while (ok && (up ? value <= last : value >= last))
+    {
+        if (position > limit)
+        {
+            position = send(position);
+            limit = position + block_size - margin;
+        }
+        // Every number is followed by the separator, the last one is replaced below
+        position += format(value, position, width);
+        if (single != '\0')
+        {
+            *position++ = single;
+        }
+        else
+        {
+            std::memcpy(position, separator.data(), separator.size());
+            position += separator.size();
+        }
+        any = true;
+        // Stepping past the largest or smallest number ends the sequence too
+        if (__builtin_add_overflow(value, step, &value))
+        {
+            break;
+        }
+    }
+    if (ok && any)
+    {
+        position -= separator.size();
+        *position++ = '\n';
+        send(position);
+    }
+    return ok ? 0 : 1;
+}
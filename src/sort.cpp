@@ -0,0 +1,839 @@
+/**
+ * @file sort.cpp
+ * @brief the sort builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Lines are sorted as records pointing into mapped files or read blocks,
+ * each carrying an 8-byte prefix of its first key so most comparisons never
+ * look at the line. The records are split into one piece per core, sorted
+ * in parallel and merged through a loser tree. Input beyond the memory
+ * budget is sorted the same way and spilled to temporary files, which the
+ * final merge reads back mapped.
+ */
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    // The budget when -S is not given, as a fraction of physical memory
+    const size_t DEFAULT_BUDGET_SHARE = 4;
+
+    // Buffer of the writer filling a spill file
+    const size_t SPILL_BUFFER = 1 << 20;
+
+    // The smallest budget -S gives, so that a tiny one does not spill a file every few lines
+    const size_t MIN_BUDGET = 1 << 20;
+
+    // Spilled runs merged into one at a time once there are this many of a size, so open files stay few
+    const size_t MERGE_FAN_IN = 16;
+
+    /**
+    * @brief A sort key: -k field1[.char1][,field2[.char2]][bnr]
+    */
+    struct Key
+    {
+        size_t field1 = 1;
+        size_t char1 = 1;
+        size_t field2 = 0; //!< Last field, 0 for the end of the line.
+        size_t char2 = 0; //!< Last character of the last field, 0 for its end.
+        bool numeric = false;
+        bool reverse = false;
+        bool blanks = false; //!< Whether leading blanks are skipped.
+    };
+
+    /**
+    * @brief Settings from the command line.
+    */
+    struct Settings
+    {
+        std::vector<Key> keys;
+        char separator = '\0'; //!< Field separator, or '\0' for runs of blanks.
+        bool reverse = false;
+        bool unique = false;
+        bool stable = false;
+    };
+
+    /**
+    * @brief A line to sort.
+    */
+    struct Record
+    {
+        const char* line;
+        size_t length; //!< Length without the newline.
+        uint64_t prefix; //!< Order-preserving summary of the first key.
+    };
+
+    /**
+    * @brief A number as sort -n reads it, compared digit by digit.
+    */
+    struct Number
+    {
+        bool negative = false;
+        const char* integer = nullptr; //!< Integer digits, leading zeros skipped.
+        size_t integer_length = 0;
+        const char* fraction = nullptr; //!< Fraction digits, trailing zeros dropped.
+        size_t fraction_length = 0;
+    };
+
+    Number parse_number(const char* begin, const char* end)
+    {
+        Number number;
+        while (begin < end && cash::is_blank(*begin))
+        {
+            ++begin;
+        }
+        if (begin < end && *begin == '-')
+        {
+            number.negative = true;
+            ++begin;
+        }
+        while (begin < end && *begin == '0')
+        {
+            ++begin;
+        }
+        number.integer = begin;
+        while (begin < end && *begin >= '0' && *begin <= '9')
+        {
+            ++begin;
+        }
+        number.integer_length = begin - number.integer;
+        if (begin < end && *begin == '.')
+        {
+            number.fraction = ++begin;
+            while (begin < end && *begin >= '0' && *begin <= '9')
+            {
+                ++begin;
+            }
+            number.fraction_length = begin - number.fraction;
+            while (number.fraction_length > 0 && number.fraction[number.fraction_length - 1] == '0')
+            {
+                --number.fraction_length;
+            }
+        }
+        // -0 is 0
+        if (number.integer_length == 0 && number.fraction_length == 0)
+        {
+            number.negative = false;
+        }
+        return number;
+    }
+
+    int compare_numbers(const Number& a, const Number& b)
+    {
+        if (a.negative != b.negative)
+        {
+            return a.negative ? -1 : 1;
+        }
+        int result = 0;
+        if (a.integer_length != b.integer_length)
+        {
+            result = a.integer_length < b.integer_length ? -1 : 1;
+        }
+        else
+        {
+            result = std::memcmp(a.integer, b.integer, a.integer_length);
+            if (result == 0)
+            {
+                const size_t common = std::min(a.fraction_length, b.fraction_length);
+                result = common > 0 ? std::memcmp(a.fraction, b.fraction, common) : 0;
+                if (result == 0 && a.fraction_length != b.fraction_length)
+                {
+                    result = a.fraction_length < b.fraction_length ? -1 : 1;
+                }
+            }
+        }
+        return a.negative ? -result : result;
+    }
+
+    /**
+    * @brief Orders lines by the keys, building records with their prefixes.
+    */
+    class Comparator
+    {
+    public:
+        explicit Comparator(const Settings& settings) : settings(settings)
+        {
+            // The usual sort of whole lines, where the key and the last resort are the same comparison
+            const Key& key = settings.keys[0];
+            whole_lines = settings.keys.size() == 1 && key.field1 == 1 && key.char1 == 1 && key.field2 == 0
+                && !key.numeric && !key.blanks;
+        }
+
+        Record make(const char* line, const size_t length) const
+        {
+            Record record{line, length, 0};
+            const char* begin;
+            const char* end;
+            const Key& key = settings.keys[0];
+            extract(key, line, length, begin, end);
+            if (key.numeric)
+            {
+                // The integer part, saturated, with negatives below positives
+                const Number number = parse_number(begin, end);
+                uint64_t integer = 0;
+                if (number.integer_length > 18)
+                {
+                    integer = 1ULL << 62;
+                }
+                for (size_t i = 0; i < number.integer_length && number.integer_length <= 18; ++i)
+                {
+                    integer = integer * 10 + (number.integer[i] - '0');
+                }
+                integer = std::min<uint64_t>(integer, 1ULL << 62);
+                record.prefix = number.negative ? (1ULL << 63) - 1 - integer : (1ULL << 63) + integer;
+            }
+            else
+            {
+                for (size_t i = 0; i < 8; ++i)
+                {
+                    const uint64_t byte = begin + i < end ? static_cast<unsigned char>(begin[i]) : 0;
+                    record.prefix |= byte << (56 - 8 * i);
+                }
+            }
+            return record;
+        }
+
+        int compare(const Record& a, const Record& b) const
+        {
+            if (whole_lines)
+            {
+                int result = a.prefix < b.prefix ? -1 : a.prefix > b.prefix ? 1 : 0;
+                if (result == 0)
+                {
+                    // Equal prefixes of lines of 8 bytes or more are equal first 8 bytes
+                    const size_t skip = std::min<size_t>(8, std::min(a.length, b.length));
+                    result = compare_bytes(a.line + skip, a.length - skip, b.line + skip, b.length - skip);
+                }
+                return settings.keys[0].reverse ? -result : result;
+            }
+            for (size_t k = 0; k < settings.keys.size(); ++k)
+            {
+                const Key& key = settings.keys[k];
+                int result = 0;
+                if (k == 0 && a.prefix != b.prefix)
+                {
+                    result = a.prefix < b.prefix ? -1 : 1;
+                }
+                else
+                {
+                    result = compare_key(key, a, b);
+                }
+                if (result != 0)
+                {
+                    return key.reverse ? -result : result;
+                }
+            }
+            if (settings.unique || settings.stable)
+            {
+                return 0;
+            }
+            // Lines with equal keys fall back to comparing the whole line
+            const int result = compare_bytes(a.line, a.length, b.line, b.length);
+            return settings.reverse ? -result : result;
+        }
+
+    private:
+        static int compare_bytes(const char* a, const size_t a_length, const char* b, const size_t b_length)
+        {
+            const int result = std::memcmp(a, b, std::min(a_length, b_length));
+            if (result != 0)
+            {
+                return result;
+            }
+            return a_length < b_length ? -1 : a_length > b_length ? 1 : 0;
+        }
+
+        int compare_key(const Key& key, const Record& a, const Record& b) const
+        {
+            const char* a_begin;
+            const char* a_end;
+            const char* b_begin;
+            const char* b_end;
+            extract(key, a.line, a.length, a_begin, a_end);
+            extract(key, b.line, b.length, b_begin, b_end);
+            if (key.numeric)
+            {
+                return compare_numbers(parse_number(a_begin, a_end), parse_number(b_begin, b_end));
+            }
+            return compare_bytes(a_begin, a_end - a_begin, b_begin, b_end - b_begin);
+        }
+
+        // Start of a field, counting from 1, or the end of the line; without -t a field is blanks followed by non-blanks
+        const char* field_start(const char* line, const char* end, size_t field) const
+        {
+            const char* position = line;
+            while (--field > 0 && position < end)
+            {
+                const char* stop = cash::field_end(position, end, settings.separator);
+                position = cash::next_field(stop, end, settings.separator);
+            }
+            return position;
+        }
+
+        const char* field_end(const char* start, const char* end) const
+        {
+            return cash::field_end(start, end, settings.separator);
+        }
+
+        void extract(const Key& key, const char* line, const size_t length, const char*& begin, const char*& end) const
+        {
+            const char* line_end = line + length;
+            begin = field_start(line, line_end, key.field1);
+            if (key.blanks)
+            {
+                while (begin < line_end && cash::is_blank(*begin))
+                {
+                    ++begin;
+                }
+            }
+            begin = std::min(begin + (key.char1 - 1), line_end);
+
+            end = line_end;
+            if (key.field2 != 0)
+            {
+                const char* start = field_start(line, line_end, key.field2);
+                if (key.char2 == 0)
+                {
+                    end = field_end(start, line_end);
+                }
+                else
+                {
+                    if (key.blanks)
+                    {
+                        while (start < line_end && cash::is_blank(*start))
+                        {
+                            ++start;
+                        }
+                    }
+                    end = std::min(start + key.char2, line_end);
+                }
+            }
+            end = std::max(begin, end);
+        }
+
+        const Settings& settings;
+        bool whole_lines; //!< Whether lines are compared whole, bytewise.
+    };
+
+    /**
+    * @brief A sorted run being merged: records in memory, or lines of a spilled file.
+    */
+    struct Run
+    {
+        const Record* next = nullptr;
+        const Record* last = nullptr;
+        std::unique_ptr<cash::MappedFile> file;
+        const char* position = nullptr;
+        const char* limit = nullptr;
+        Record current{nullptr, 0, 0};
+        bool valid = false;
+
+        void advance(const Comparator& comparator)
+        {
+            if (file)
+            {
+                valid = position < limit;
+                if (valid)
+                {
+                    const char* newline = static_cast<const char*>(std::memchr(position, '\n', limit - position));
+                    const char* end = newline != nullptr ? newline : limit;
+                    current = comparator.make(position, end - position);
+                    position = end + 1;
+                }
+                return;
+            }
+            valid = next < last;
+            if (valid)
+            {
+                current = *next++;
+            }
+        }
+    };
+
+    /**
+    * @brief Picks the smallest head of k runs with log2(k) comparisons per record.
+    *
+    * Inner nodes hold the loser of the match played there, so replacing the
+    * winner only replays the matches on its path to the root. Ties go to the
+    * earlier run, which keeps -u and -s in input order.
+    */
+    class LoserTree
+    {
+    public:
+        LoserTree(std::vector<Run>& runs, const Comparator& comparator)
+            : runs(runs), comparator(comparator), tree(std::max<size_t>(runs.size(), 1))
+        {
+            for (auto& run : runs)
+            {
+                run.advance(comparator);
+            }
+            tree[0] = runs.size() == 1 ? 0 : build(1);
+        }
+
+        /**
+        * @brief The run holding the smallest record, or nullptr when all are done.
+        */
+        Run* top()
+        {
+            Run& run = runs[tree[0]];
+            return run.valid ? &run : nullptr;
+        }
+
+        /**
+        * @brief Moves the top run on to its next record.
+        */
+        void pop()
+        {
+            size_t winner = tree[0];
+            runs[winner].advance(comparator);
+            for (size_t node = (winner + runs.size()) / 2; node >= 1; node /= 2)
+            {
+                if (beats(tree[node], winner))
+                {
+                    std::swap(tree[node], winner);
+                }
+            }
+            tree[0] = winner;
+        }
+
+    private:
+        bool beats(const size_t a, const size_t b) const
+        {
+            if (!runs[a].valid || !runs[b].valid)
+            {
+                return runs[a].valid;
+            }
+            const int result = comparator.compare(runs[a].current, runs[b].current);
+            return result < 0 || (result == 0 && a < b);
+        }
+
+        // Plays the matches below a node, leaves being nodes k to 2k - 1
+        size_t build(const size_t node)
+        {
+            if (node >= runs.size())
+            {
+                return node - runs.size();
+            }
+            const size_t left = build(2 * node);
+            const size_t right = build(2 * node + 1);
+            const bool left_wins = beats(left, right);
+            tree[node] = left_wins ? right : left;
+            return left_wins ? left : right;
+        }
+
+        std::vector<Run>& runs;
+        const Comparator& comparator;
+        std::vector<size_t> tree; //!< tree[0] is the winner, the others losers.
+    };
+
+    /**
+    * @brief Lines read so far and not yet spilled.
+    */
+    struct Batch
+    {
+        std::vector<Record> records;
+        std::deque<std::string> blocks; //!< Copies of piped input the records point into.
+        size_t bytes = 0;
+    };
+
+    /**
+    * @brief Parses -S: a number of bytes with an optional b, K, M, G or T suffix (K by default) or %.
+    */
+    bool parse_size(const std::string& text, size_t& size)
+    {
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+        if (end == text.c_str())
+        {
+            return false;
+        }
+        const std::string suffix(end);
+        const size_t physical = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const char* units = "bKMGT";
+        if (suffix == "%")
+        {
+            size = physical / 100 * value;
+            return true;
+        }
+        const char* unit = suffix.empty() ? units + 1 : suffix.size() == 1 ? std::strchr(units, suffix[0]) : nullptr;
+        if (unit == nullptr || *unit == '\0')
+        {
+            return false;
+        }
+        size = value << (10 * (unit - units));
+        return true;
+    }
+
+    /**
+    * @brief Parses a key definition.
+    */
+    bool parse_key(const std::string& text, const Key& global, Key& key)
+    {
+        size_t i = 0;
+        auto number = [&](size_t& value) -> bool
+        {
+            const size_t start = i;
+            value = 0;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9')
+            {
+                value = value * 10 + (text[i++] - '0');
+            }
+            return i > start;
+        };
+        bool ordering = false;
+        auto modifiers = [&]()
+        {
+            for (; i < text.size() && std::strchr("bnr", text[i]) != nullptr; ++i)
+            {
+                key.blanks = key.blanks || text[i] == 'b';
+                key.numeric = key.numeric || text[i] == 'n';
+                key.reverse = key.reverse || text[i] == 'r';
+                ordering = true;
+            }
+        };
+
+        if (!number(key.field1) || key.field1 == 0)
+        {
+            return false;
+        }
+        if (i < text.size() && text[i] == '.' && (++i, !number(key.char1) || key.char1 == 0))
+        {
+            return false;
+        }
+        modifiers();
+        if (i < text.size() && text[i] == ',')
+        {
+            ++i;
+            if (!number(key.field2) || key.field2 == 0)
+            {
+                return false;
+            }
+            if (i < text.size() && text[i] == '.' && (++i, !number(key.char2)))
+            {
+                return false;
+            }
+            modifiers();
+        }
+        // A key without options of its own takes the global ones
+        if (!ordering)
+        {
+            key.blanks = global.blanks;
+            key.numeric = global.numeric;
+            key.reverse = global.reverse;
+        }
+        return i == text.size();
+    }
+
+    /**
+    * @brief Sorts a batch: one piece per core, sorted in parallel, as runs to merge.
+    */
+    void sort_pieces(Batch& batch, const Comparator& comparator, const bool stable, std::vector<Run>& runs)
+    {
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        const size_t pieces = std::max<size_t>(1, std::min(cores, batch.records.size() / 4096));
+        const size_t size = (batch.records.size() + pieces - 1) / pieces;
+        auto less = [&](const Record& a, const Record& b)
+        {
+            return comparator.compare(a, b) < 0;
+        };
+        cash::parallel_for(pieces, [&](const size_t p)
+        {
+            Record* begin = batch.records.data() + std::min(p * size, batch.records.size());
+            Record* end = batch.records.data() + std::min((p + 1) * size, batch.records.size());
+            if (stable)
+            {
+                std::stable_sort(begin, end, less);
+            }
+            else
+            {
+                std::sort(begin, end, less);
+            }
+        });
+        for (size_t p = 0; p < pieces; ++p)
+        {
+            runs.emplace_back();
+            runs.back().next = batch.records.data() + std::min(p * size, batch.records.size());
+            runs.back().last = batch.records.data() + std::min((p + 1) * size, batch.records.size());
+        }
+    }
+
+    // Maps spilled runs to merge them, closing their files
+    void map_spills(const std::vector<int>& spills, std::vector<Run>& runs)
+    {
+        for (const int fd : spills)
+        {
+            runs.emplace_back();
+            Run& run = runs.back();
+            run.file.reset(new cash::MappedFile());
+            run.file->map(fd);
+            close(fd);
+            run.position = run.file->data();
+            run.limit = run.file->data() + run.file->size();
+        }
+    }
+
+    // Merges runs into a writer, dropping lines equal to the one before with -u
+    void merge(std::vector<Run>& runs, const Comparator& comparator, const bool unique, cash::Output& output)
+    {
+        LoserTree tree(runs, comparator);
+        Record previous{nullptr, 0, 0};
+        bool first = true;
+        for (Run* run = tree.top(); run != nullptr && !output.failed(); run = tree.top())
+        {
+            if (!unique || first || comparator.compare(previous, run->current) != 0)
+            {
+                output.write(run->current.line, run->current.length);
+                output.put('\n');
+                previous = run->current;
+                first = false;
+            }
+            tree.pop();
+        }
+    }
+}
+
+int cash::sort(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    // Options, keys and sizes not handled here, like -h, -o or -S 50%, run the sort in PATH
+    if (!get_options(args, "bk:nrsS:t:T:u", options, operands, true))
+    {
+        return spawn(args);
+    }
+
+    Settings settings;
+    settings.reverse = options.count('r') != 0;
+    settings.unique = options.count('u') != 0;
+    settings.stable = options.count('s') != 0;
+    if (options.count('t'))
+    {
+        if (options['t'].size() != 1)
+        {
+            return spawn(args);
+        }
+        settings.separator = options['t'][0];
+    }
+
+    Key global;
+    global.numeric = options.count('n') != 0;
+    global.reverse = settings.reverse;
+    global.blanks = options.count('b') != 0;
+    if (options.count('k'))
+    {
+        // Repeated -k arrive separated by newlines
+        const std::string& definitions = options['k'];
+        size_t begin = 0;
+        while (begin <= definitions.size())
+        {
+            size_t end = definitions.find('\n', begin);
+            end = end == std::string::npos ? definitions.size() : end;
+            Key key;
+            if (!parse_key(definitions.substr(begin, end - begin), global, key))
+            {
+                return spawn(args);
+            }
+            settings.keys.push_back(key);
+            begin = end + 1;
+        }
+    }
+    else
+    {
+        settings.keys.push_back(global);
+    }
+
+    size_t budget = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE))
+        / DEFAULT_BUDGET_SHARE;
+    if (options.count('S') && !parse_size(options['S'], budget))
+    {
+        return spawn(args);
+    }
+    budget = std::max(budget, MIN_BUDGET);
+    const char* temporary = std::getenv("TMPDIR");
+    const std::string directory = options.count('T') ? options['T'] : temporary != nullptr ? temporary : "/tmp";
+
+    if (operands.empty())
+    {
+        operands.push_back("-");
+    }
+
+    const Comparator comparator(settings);
+    const bool stable = settings.unique || settings.stable;
+    Batch batch;
+    std::vector<std::unique_ptr<MappedFile>> mapped;
+    std::vector<int> spills;
+    // How many merges made each spilled run, never more than for the runs before it
+    std::vector<size_t> levels;
+    int status = 0;
+
+    // Merges runs into a temporary file, returning it open or -1
+    auto write_run = [&](std::vector<Run>& runs) -> int
+    {
+        std::string path = directory + "/cash-sort-XXXXXX";
+        const int fd = mkstemp(&path[0]);
+        if (fd == -1)
+        {
+            report("sort", directory + ": " + strerror(errno));
+            return -1;
+        }
+        unlink(path.c_str());
+        Output output(fd, SPILL_BUFFER);
+        merge(runs, comparator, settings.unique, output);
+        if (!output.flush())
+        {
+            report("sort", "write failed: " + std::string(strerror(errno)));
+            close(fd);
+            return -1;
+        }
+        return fd;
+    };
+
+    // Sorts the batch and writes it to a temporary file
+    auto spill = [&]() -> bool
+    {
+        int fd;
+        {
+            std::vector<Run> runs;
+            sort_pieces(batch, comparator, stable, runs);
+            fd = write_run(runs);
+        }
+        if (fd == -1)
+        {
+            return false;
+        }
+        spills.push_back(fd);
+        levels.push_back(0);
+        batch.records.clear();
+        // The last block may still be being split into lines
+        batch.blocks.erase(batch.blocks.begin(), batch.blocks.end() - std::min<size_t>(1, batch.blocks.size()));
+        batch.bytes = 0;
+        // The last runs of one level become one of the next, in their place in the input
+        while (spills.size() >= MERGE_FAN_IN && levels[levels.size() - MERGE_FAN_IN] == levels.back())
+        {
+            const std::vector<int> group(spills.end() - MERGE_FAN_IN, spills.end());
+            const size_t level = levels.back() + 1;
+            spills.resize(spills.size() - MERGE_FAN_IN);
+            levels.resize(levels.size() - MERGE_FAN_IN);
+            std::vector<Run> runs;
+            map_spills(group, runs);
+            fd = write_run(runs);
+            if (fd == -1)
+            {
+                return false;
+            }
+            spills.push_back(fd);
+            levels.push_back(level);
+        }
+        return true;
+    };
+
+    auto add = [&](const char* line, const size_t length) -> bool
+    {
+        batch.records.push_back(comparator.make(line, length));
+        batch.bytes += length + sizeof(Record);
+        return batch.bytes <= budget || spill();
+    };
+
+    // Adds the whole lines of a buffer, returning the offset of the partial line at its end
+    auto add_lines = [&](const char* data, const size_t size, size_t& done) -> bool
+    {
+        const char* position = data;
+        const char* end = data + size;
+        while (position < end)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+            if (newline == nullptr)
+            {
+                break;
+            }
+            if (!add(position, newline - position))
+            {
+                return false;
+            }
+            position = newline + 1;
+        }
+        done = position - data;
+        return true;
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < operands.size() && ok; ++i)
+    {
+        const int fd = open_input("sort", operands[i]);
+        if (fd == -1)
+        {
+            status = 2;
+            continue;
+        }
+        std::unique_ptr<MappedFile> file(new MappedFile());
+        if (file->map(fd))
+        {
+            size_t done = 0;
+            ok = add_lines(file->data(), file->size(), done);
+            if (ok && done < file->size())
+            {
+                ok = add(file->data() + done, file->size() - done);
+            }
+            mapped.push_back(std::move(file));
+        }
+        else
+        {
+            // Piped input is copied into blocks, a line cut by a chunk moving to the next block
+            std::string carry;
+            const bool read = read_chunks(fd, [&](const char* data, const size_t size)
+            {
+                batch.blocks.push_back(carry);
+                std::string& block = batch.blocks.back();
+                block.append(data, size);
+                size_t done = 0;
+                ok = add_lines(block.data(), block.size(), done);
+                carry.assign(block, done, std::string::npos);
+                block.resize(done);
+                return ok;
+            });
+            if (!read)
+            {
+                report("sort", operands[i] + ": " + strerror(errno));
+                status = 2;
+            }
+            if (ok && !carry.empty())
+            {
+                batch.blocks.push_back(carry);
+                ok = add(batch.blocks.back().data(), carry.size());
+            }
+        }
+        close_input(fd);
+    }
+    if (!ok)
+    {
+        for (const int fd : spills)
+        {
+            close(fd);
+        }
+        return 2;
+    }
+
+    // Spilled runs come first, being earlier in the input
+    std::vector<Run> runs;
+    map_spills(spills, runs);
+    sort_pieces(batch, comparator, stable, runs);
+
+    Output output;
+    merge(runs, comparator, settings.unique, output);
+    return status;
+}
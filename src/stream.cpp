@@ -0,0 +1,566 @@
+/**
+ * @file stream.cpp
+ * @brief input and output helpers for stream builtins
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Buffered output, mapped and chunked input, option parsing and a small
+ * thread pool.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "stream.h"
+#include "cash.h"
+#include "records.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Size the pipes of SpliceWriter are grown to
+    const int PIPE_SIZE = 1 << 20;
+
+    volatile sig_atomic_t interrupted = 0;
+
+    void stop_sending(int)
+    {
+        interrupted = 1;
+    }
+}
+
+cash::Output::Output(const int fd, const size_t capacity) : fd(fd), buffer(capacity), used(0), error(false)
+{
+}
+
+cash::Output::~Output()
+{
+    flush();
+}
+
+void cash::Output::write(const char* data, size_t size)
+{
+    if (used + size > buffer.size())
+    {
+        flush();
+        // Large writes skip the buffer
+        if (size >= buffer.size())
+        {
+            while (size > 0 && !error)
+            {
+                const ssize_t written = ::write(fd, data, size);
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (written <= 0)
+                {
+                    error = true;
+                    break;
+                }
+                data += written;
+                size -= written;
+            }
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+void cash::Output::write(const std::string& text)
+{
+    write(text.data(), text.size());
+}
+
+void cash::Output::put(const char ch)
+{
+    if (used == buffer.size())
+    {
+        flush();
+    }
+    buffer[used++] = ch;
+}
+
+bool cash::Output::flush()
+{
+    size_t done = 0;
+    while (done < used && !error)
+    {
+        const ssize_t written = ::write(fd, buffer.data() + done, used - done);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            error = true;
+            break;
+        }
+        done += written;
+    }
+    used = 0;
+    return !error;
+}
+
+bool cash::Output::failed() const
+{
+    return error;
+}
+
+bool cash::Stage::feed_records(const RecordBatch& batch)
+{
+    std::string text;
+    write_csv(batch, !header_fed, text);
+    header_fed = true;
+    return text.empty() || feed(text.data(), text.size());
+}
+
+void cash::Stage::begin_input(const std::string&)
+{
+}
+
+void cash::Stage::finish()
+{
+    end();
+}
+
+int cash::Stage::status() const
+{
+    return 0;
+}
+
+void cash::Stage::connect(Stage* const stage)
+{
+    next = stage;
+    output = nullptr;
+}
+
+void cash::Stage::connect(Output* const writer)
+{
+    output = writer;
+    next = nullptr;
+}
+
+const std::vector<std::string>& cash::Stage::files() const
+{
+    return inputs;
+}
+
+bool cash::Stage::emit(const char* data, const size_t size)
+{
+    if (next != nullptr)
+    {
+        return next->feed(data, size);
+    }
+    output->write(data, size);
+    return !output->failed();
+}
+
+bool cash::Stage::emit_records(const RecordBatch& batch)
+{
+    if (next != nullptr)
+    {
+        return next->feed_records(batch);
+    }
+    // Records end as text where the pipeline leaves the shell
+    std::string text;
+    write_csv(batch, !header_emitted, text);
+    header_emitted = true;
+    return emit(text.data(), text.size());
+}
+
+void cash::Stage::end()
+{
+    if (next != nullptr)
+    {
+        next->finish();
+    }
+    else
+    {
+        output->flush();
+    }
+}
+
+cash::MappedFile::~MappedFile()
+{
+    if (address != nullptr)
+    {
+        munmap(address, length);
+    }
+}
+
+bool cash::MappedFile::map(const int fd)
+{
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0)
+    {
+        return true;
+    }
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        length = 0;
+        return false;
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    address = static_cast<char*>(mapped);
+    return true;
+}
+
+cash::Pages::Pages(const size_t size)
+{
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped != MAP_FAILED)
+    {
+        address = static_cast<char*>(mapped);
+        length = size;
+    }
+}
+
+cash::Pages::~Pages()
+{
+    // Pages still in a pipe outlive the mapping
+    if (address != nullptr)
+    {
+        munmap(address, length);
+    }
+}
+
+cash::SpliceWriter::SpliceWriter(const int fd) : fd(fd), pipe(false), saved()
+{
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode))
+    {
+        pipe = true;
+        // A bigger pipe means fewer trips between writer and reader, it is fine if the limit refuses
+        fcntl(fd, F_SETPIPE_SZ, PIPE_SIZE);
+    }
+
+    // Ctrl+C interrupts the blocked write and ends the output, not the shell
+    struct sigaction action = {};
+    action.sa_handler = stop_sending;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &saved);
+    interrupted = 0;
+}
+
+cash::SpliceWriter::~SpliceWriter()
+{
+    sigaction(SIGINT, &saved, nullptr);
+}
+
+bool cash::SpliceWriter::send(const char* data, size_t size)
+{
+    while (size > 0 && !interrupted)
+    {
+        ssize_t sent;
+        if (pipe)
+        {
+            struct iovec piece = {const_cast<char*>(data), size};
+            sent = vmsplice(fd, &piece, 1, 0);
+            if (sent < 0 && errno == EINVAL)
+            {
+                // Not a pipe after all, as far as vmsplice is concerned
+                pipe = false;
+                continue;
+            }
+        }
+        else
+        {
+            sent = ::write(fd, data, size);
+        }
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return !interrupted;
+}
+
+bool cash::read_chunks(const int fd, const ChunkConsumer& consumer, const bool eager)
+{
+    MappedFile file;
+    if (file.map(fd))
+    {
+        if (file.size() > 0)
+        {
+            consumer(file.data(), file.size());
+        }
+        return true;
+    }
+
+    std::vector<char> chunk(CHUNK_SIZE);
+    // Hands over what a terminal has typed instead of waiting for a full chunk
+    const bool partial = eager || isatty(fd);
+    while (true)
+    {
+        // Fills the chunk as far as the pipe allows before handing it over
+        size_t filled = 0;
+        bool end = false;
+        while (filled < chunk.size())
+        {
+            const ssize_t got = read(fd, chunk.data() + filled, chunk.size() - filled);
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (got < 0)
+            {
+                return false;
+            }
+            if (got == 0)
+            {
+                end = true;
+                break;
+            }
+            filled += got;
+            if (partial)
+            {
+                break;
+            }
+        }
+        if (filled > 0 && !consumer(chunk.data(), filled))
+        {
+            return true;
+        }
+        if (end)
+        {
+            return true;
+        }
+    }
+}
+
+int cash::open_input(const std::string& name, const std::string& path)
+{
+    if (path == "-")
+    {
+        return STDIN_FILENO;
+    }
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        report(name, path + ": " + strerror(errno));
+    }
+    return fd;
+}
+
+void cash::close_input(const int fd)
+{
+    if (fd != STDIN_FILENO && fd != -1)
+    {
+        close(fd);
+    }
+}
+
+void cash::report(const std::string& name, const std::string& message)
+{
+    std::cerr << RED << name << ": " << message << RESET << std::endl;
+}
+
+bool cash::get_options(const std::vector<std::string>& args, const std::string& spec,
+                       std::map<char, std::string>& options, std::vector<std::string>& operands, const bool quiet)
+{
+    size_t i = 1;
+    for (; i < args.size(); ++i)
+    {
+        const std::string& arg = args[i];
+        if (arg == "--")
+        {
+            ++i;
+            break;
+        }
+        if (arg.size() < 2 || arg[0] != '-')
+        {
+            break;
+        }
+
+        for (size_t j = 1; j < arg.size(); ++j)
+        {
+            const size_t found = spec.find(arg[j]);
+            if (found == std::string::npos || arg[j] == ':')
+            {
+                if (!quiet)
+                {
+                    report(args[0], std::string("invalid option -- '") + arg[j] + "'");
+                }
+                return false;
+            }
+            if (found + 1 < spec.size() && spec[found + 1] == ':')
+            {
+                // The value is the rest of this word, or the next word
+                std::string value;
+                if (j + 1 < arg.size())
+                {
+                    value = arg.substr(j + 1);
+                }
+                else if (i + 1 < args.size())
+                {
+                    value = args[++i];
+                }
+                else
+                {
+                    if (!quiet)
+                    {
+                        report(args[0], std::string("option requires an argument -- '") + arg[j] + "'");
+                    }
+                    return false;
+                }
+                const auto previous = options.find(arg[j]);
+                if (previous != options.end())
+                {
+                    previous->second += '\n' + value;
+                }
+                else
+                {
+                    options[arg[j]] = value;
+                }
+                break;
+            }
+            options[arg[j]] = "";
+        }
+    }
+    operands.assign(args.begin() + std::min(i, args.size()), args.end());
+    return true;
+}
+
+uint64_t cash::count_lines(const char* data, const size_t size)
+{
+    uint64_t lines = 0;
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (i + 16 <= size)
+    {
+        // Sums compare results in byte lanes, which overflow after 255 blocks
+        __m128i sums = _mm_setzero_si128();
+        const size_t blocks = std::min<size_t>((size - i) / 16, 255);
+        for (size_t b = 0; b < blocks; ++b, i += 16)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            sums = _mm_sub_epi8(sums, _mm_cmpeq_epi8(bytes, newline));
+        }
+        const __m128i total = _mm_sad_epu8(sums, _mm_setzero_si128());
+        lines += static_cast<uint64_t>(_mm_cvtsi128_si32(total)) + _mm_extract_epi16(total, 4);
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        lines += data[i] == '\n';
+    }
+    return lines;
+}
+
+int cash::run_stages(const std::vector<std::vector<std::string>>& commands)
+{
+    std::vector<std::unique_ptr<Stage>> stages;
+    for (const auto& command : commands)
+    {
+        std::unique_ptr<Stage> stage = find_builtin(command[0], true)->stage(command);
+        if (!stage)
+        {
+            // The builder has reported the error
+            return 1;
+        }
+        stages.push_back(std::move(stage));
+    }
+
+    // Stages before one reading files would only be ignored
+    size_t first = stages.size() - 1;
+    while (first > 0 && stages[first]->files().empty())
+    {
+        --first;
+    }
+
+    Output output;
+    for (size_t i = first; i + 1 < stages.size(); ++i)
+    {
+        stages[i]->connect(stages[i + 1].get());
+    }
+    stages.back()->connect(&output);
+
+    Stage& source = *stages[first];
+    const std::string& name = commands[first][0];
+    std::vector<std::string> files = source.files();
+    if (files.empty())
+    {
+        files.push_back("-");
+    }
+    int status = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const int fd = open_input(name, files[i]);
+        if (fd == -1)
+        {
+            status = 1;
+            continue;
+        }
+        source.begin_input(files[i]);
+        // Stages pass data on as it arrives, like the pipes they replace
+        if (!read_chunks(fd, [&](const char* data, const size_t size)
+        {
+            return source.feed(data, size);
+        }, true))
+        {
+            report(name, files[i] + ": " + strerror(errno));
+            status = 1;
+        }
+        close_input(fd);
+    }
+    source.finish();
+    return std::max(status, stages.back()->status());
+}
+
+void cash::parallel_for(const size_t count, const std::function<void(size_t)>& task)
+{
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const size_t threads = std::min(cores, count);
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            task(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+}
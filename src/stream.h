@@ -0,0 +1,550 @@
+/**
+ * @file stream.h
+ * @brief input and output helpers for stream builtins
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations shared by the builtins that filter data, such as wc.
+ */
+
+
+#ifndef CASH_STREAM_H
+#define CASH_STREAM_H
+
+#include <unistd.h>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __PCLMUL__
+#include <wmmintrin.h>
+#endif
+
+namespace cash
+{
+    /**
+    * @brief Buffered writer on a file descriptor, bypassing std::cout.
+    */
+    class Output
+    {
+    public:
+        /**
+        * @brief Creates a writer.
+        *
+        * @param fd file descriptor to write to.
+        * @param capacity buffer size in bytes.
+        */
+        explicit Output(int fd = STDOUT_FILENO, size_t capacity = 1 << 16);
+        Output(const Output&) = delete;
+        Output& operator=(const Output&) = delete;
+
+        /**
+        * @brief Flushes what is left.
+        */
+        ~Output();
+
+        /**
+        * @brief Appends bytes, flushing when the buffer is full.
+        *
+        * @param data bytes to write.
+        * @param size number of bytes.
+        */
+        void write(const char* data, size_t size);
+
+        /**
+        * @brief Appends a string.
+        *
+        * @param text the string.
+        */
+        void write(const std::string& text);
+
+        /**
+        * @brief Appends a byte.
+        *
+        * @param ch the byte.
+        */
+        void put(char ch);
+
+        /**
+        * @brief Writes the buffer out.
+        *
+        * @return false once a write has failed, e.g. because the reader of a pipe went away.
+        */
+        bool flush();
+
+        /**
+        * @brief Checks for failed writes.
+        *
+        * @return true if a write has failed.
+        */
+        bool failed() const;
+
+    private:
+        int fd; //!< Destination.
+        std::vector<char> buffer; //!< Pending bytes, buffer.size() is the capacity.
+        size_t used; //!< Number of pending bytes.
+        bool error; //!< Whether a write has failed.
+    };
+
+    struct RecordBatch;
+
+    /**
+    * @brief A builtin that transforms its input chunk by chunk.
+    *
+    * Adjacent stages of a pipeline run in one process, each passing its
+    * output chunks to the next instead of writing them to a pipe.
+    */
+    class Stage
+    {
+    public:
+        virtual ~Stage() = default;
+
+        /**
+        * @brief Consumes a chunk of input.
+        *
+        * @param data bytes of input, only valid during the call.
+        * @param size number of bytes.
+        * @return false when no more of the current input is wanted.
+        */
+        virtual bool feed(const char* data, size_t size) = 0;
+
+        /**
+        * @brief Consumes a batch of records from a stage before it.
+        *
+        * Stages that read text get the records as CSV, with the column names first.
+        *
+        * @param batch the records, only valid during the call.
+        * @return false when no more of the current input is wanted.
+        */
+        virtual bool feed_records(const RecordBatch& batch);
+
+        /**
+        * @brief Announces the next of several files read by this stage.
+        *
+        * @param name the file operand.
+        */
+        virtual void begin_input(const std::string& name);
+
+        /**
+        * @brief Ends the input, letting the stage emit what it has held back.
+        */
+        virtual void finish();
+
+        /**
+        * @brief Exit status, once finished.
+        */
+        virtual int status() const;
+
+        /**
+        * @brief Sends the output to another stage, instead of standard output.
+        *
+        * @param stage the next stage, owned by the caller.
+        */
+        void connect(Stage* stage);
+
+        /**
+        * @brief Sends the output to a writer.
+        *
+        * @param writer the writer, owned by the caller.
+        */
+        void connect(Output* writer);
+
+        /**
+        * @brief Files the stage reads instead of its standard input, if any.
+        */
+        const std::vector<std::string>& files() const;
+
+    protected:
+        /**
+        * @brief Passes output on.
+        *
+        * @param data bytes of output.
+        * @param size number of bytes.
+        * @return false when the rest of the pipeline wants no more input.
+        */
+        bool emit(const char* data, size_t size);
+
+        /**
+        * @brief Passes records on, as they are to a stage taking records and as CSV otherwise.
+        *
+        * @param batch the records.
+        * @return false when the rest of the pipeline wants no more input.
+        */
+        bool emit_records(const RecordBatch& batch);
+
+        /**
+        * @brief Ends the output.
+        */
+        void end();
+
+        std::vector<std::string> inputs; //!< File operands, set by the stage builder.
+
+    private:
+        Stage* next = nullptr; //!< The stage reading the output, if any.
+        Output* output = nullptr; //!< The writer taking the output otherwise.
+        bool header_fed = false; //!< Whether CSV fed to this stage from records has had its column names.
+        bool header_emitted = false; //!< Whether CSV emitted from records has had its column names.
+    };
+
+    /**
+    * @brief Splits chunks of input into whole lines, keeping a line cut at the end of a chunk for the next.
+    */
+    class LineSplitter
+    {
+    public:
+        /**
+        * @brief Passes on the whole lines of a chunk, in blocks each ending with a newline.
+        *
+        * The line started in an earlier chunk is completed and passed on by
+        * itself first; what follows the last newline waits for the next chunk.
+        *
+        * @param data bytes of input.
+        * @param size number of bytes.
+        * @param block called with [begin, end) of one or more lines.
+        */
+        template <typename Block>
+        void split(const char* data, const size_t size, Block&& block)
+        {
+            const char* last = static_cast<const char*>(memrchr(data, '\n', size));
+            if (last == nullptr)
+            {
+                carry.append(data, size);
+                return;
+            }
+            const char* start = data;
+            if (!carry.empty())
+            {
+                const char* first = static_cast<const char*>(std::memchr(data, '\n', size));
+                carry.append(data, first + 1 - data);
+                block(carry.data(), carry.data() + carry.size());
+                carry.clear();
+                start = first + 1;
+            }
+            if (start <= last)
+            {
+                block(start, last + 1);
+            }
+            carry.assign(last + 1, data + size - last - 1);
+        }
+
+        /**
+        * @brief Passes on a last line without a newline, if there is one.
+        *
+        * @param block called with [begin, end) of the line.
+        * @param newline whether the line gets a newline first, as coreutils gives it.
+        */
+        template <typename Block>
+        void finish(Block&& block, const bool newline = false)
+        {
+            if (carry.empty())
+            {
+                return;
+            }
+            if (newline)
+            {
+                carry += '\n';
+            }
+            block(carry.data(), carry.data() + carry.size());
+            carry.clear();
+        }
+
+    private:
+        std::string carry; //!< A line cut at the end of a chunk.
+    };
+
+    /**
+    * @brief Calls a function for each line of a block, without its newline.
+    *
+    * @param begin start of the block.
+    * @param end end of the block, after the newline of its last line if it has one.
+    * @param line called with the start and length of each line.
+    */
+    template <typename Line>
+    void for_each_line(const char* begin, const char* end, Line&& line)
+    {
+        while (begin < end)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            const char* stop = newline != nullptr ? newline : end;
+            line(begin, static_cast<size_t>(stop - begin));
+            begin = stop + 1;
+        }
+    }
+
+    /**
+    * @brief Whether a byte separates fields when no separator is given.
+    */
+    inline bool is_blank(const char ch)
+    {
+        return ch == ' ' || ch == '\t';
+    }
+
+    /**
+    * @brief Finds the end of a field.
+    *
+    * With a separator, fields end at it and empty fields count; without one,
+    * fields are separated by runs of blanks, as in awk.
+    *
+    * @param begin where the field starts, moved past leading blanks without a separator.
+    * @param end end of the line.
+    * @param separator field separator, or '\0' for runs of blanks.
+    * @return the end of the field.
+    */
+    inline const char* field_end(const char*& begin, const char* end, const char separator)
+    {
+        if (separator != '\0')
+        {
+            const char* found = static_cast<const char*>(std::memchr(begin, separator, end - begin));
+            return found != nullptr ? found : end;
+        }
+        while (begin < end && is_blank(*begin))
+        {
+            ++begin;
+        }
+        const char* stop = begin;
+        while (stop < end && !is_blank(*stop))
+        {
+            ++stop;
+        }
+        return stop;
+    }
+
+    /**
+    * @brief Where the field after one ending at stop starts.
+    */
+    inline const char* next_field(const char* stop, const char* end, const char separator)
+    {
+        return separator != '\0' && stop < end ? stop + 1 : stop;
+    }
+
+    /**
+    * @brief Finds a field of a line, empty past the last one.
+    *
+    * @param begin start of the line, moved to the start of the field.
+    * @param end end of the line.
+    * @param field the field, from 1.
+    * @param separator field separator, or '\0' for runs of blanks.
+    * @return the end of the field.
+    */
+    inline const char* nth_field(const char*& begin, const char* end, const size_t field, const char separator)
+    {
+        const char* stop = field_end(begin, end, separator);
+        for (size_t f = 1; f < field; ++f)
+        {
+            // Past the last field, however far the field asked for is
+            if (stop == end)
+            {
+                begin = end;
+                break;
+            }
+            begin = next_field(stop, end, separator);
+            stop = field_end(begin, end, separator);
+        }
+        return stop;
+    }
+
+    /**
+    * @brief Sets bit i to the XOR of bits 0 to i, so from each opening quote of a block to its closing one.
+    *
+    * Used by the CSV and JSON scanners, which mark 64 bytes at a time. In CSV,
+    * doubled quotes inside a field close and reopen it with nothing in between.
+    */
+    inline uint64_t prefix_xor(uint64_t bits)
+    {
+#ifdef __PCLMUL__
+        // Carry-less multiplication by all ones
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(
+            _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(bits)), _mm_set1_epi8(-1), 0)));
+#else
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+#endif
+    }
+
+    /**
+    * @brief A read-only memory mapping of a whole regular file.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        /**
+        * @brief Maps a file descriptor if it refers to a regular file.
+        *
+        * @param fd an open file descriptor, still owned by the caller.
+        * @return true if the file is mapped (empty files count as mapped).
+        */
+        bool map(int fd);
+
+        const char* data() const { return address; }
+        size_t size() const { return length; }
+
+    private:
+        char* address = nullptr; //!< Start of the mapping.
+        size_t length = 0; //!< Size of the mapping.
+    };
+
+    /**
+    * @brief Fresh anonymous pages, page-aligned as vmsplice wants them.
+    */
+    class Pages
+    {
+    public:
+        explicit Pages(size_t size);
+        Pages(const Pages&) = delete;
+        Pages& operator=(const Pages&) = delete;
+        ~Pages();
+
+        char* data() const { return address; }
+        size_t size() const { return length; }
+
+    private:
+        char* address = nullptr; //!< Start of the mapping, nullptr if mapping failed.
+        size_t length = 0; //!< Size of the mapping.
+    };
+
+    /**
+    * @brief Writes generated output, moving it into a pipe with vmsplice instead of copying it.
+    *
+    * Spliced pages stay shared with the pipe until they are read, and longer
+    * if the reader splices them on, so a sent buffer must never change: send
+    * fresh Pages every time, or the same unchanging ones again. Other outputs
+    * are written normally. Ctrl+C stops the writing.
+    */
+    class SpliceWriter
+    {
+    public:
+        explicit SpliceWriter(int fd = STDOUT_FILENO);
+        SpliceWriter(const SpliceWriter&) = delete;
+        SpliceWriter& operator=(const SpliceWriter&) = delete;
+        ~SpliceWriter();
+
+        /**
+        * @brief Whether the output is a pipe taking pages by vmsplice.
+        */
+        bool splicing() const { return pipe; }
+
+        /**
+        * @brief Sends bytes out.
+        *
+        * @param data page-aligned bytes, never to change once sent when splicing.
+        * @param size number of bytes.
+        * @return false once the output failed or Ctrl+C was pressed.
+        */
+        bool send(const char* data, size_t size);
+
+    private:
+        int fd;
+        bool pipe; //!< Whether vmsplice is used.
+        struct sigaction saved; //!< The SIGINT action before this writer.
+    };
+
+    /**
+    * @brief Size of the chunks read from pipes and terminals.
+    */
+    const size_t CHUNK_SIZE = 1 << 20;
+
+    /**
+    * @brief Receives a chunk of input, returns false to stop reading.
+    */
+    typedef std::function<bool(const char* data, size_t size)> ChunkConsumer;
+
+    /**
+    * @brief Feeds an input to a consumer, as one mapped chunk for regular files or in CHUNK_SIZE pieces otherwise.
+    *
+    * @param fd file descriptor to read.
+    * @param consumer receives the chunks.
+    * @param eager whether to hand over every read instead of filling whole chunks.
+    * @return false on read errors.
+    */
+    bool read_chunks(int fd, const ChunkConsumer& consumer, bool eager = false);
+
+    /**
+    * @brief Opens a file operand, - meaning standard input.
+    *
+    * Prints an error prefixed with the builtin name on failure.
+    *
+    * @param name builtin name, for error messages.
+    * @param path the operand.
+    * @return a file descriptor, or -1.
+    */
+    int open_input(const std::string& name, const std::string& path);
+
+    /**
+    * @brief Closes a file descriptor returned by open_input, leaving standard input open.
+    *
+    * @param fd the file descriptor.
+    */
+    void close_input(int fd);
+
+    /**
+    * @brief Prints an error message of a builtin on standard error.
+    *
+    * @param name builtin name.
+    * @param message the message.
+    */
+    void report(const std::string& name, const std::string& message);
+
+    /**
+    * @brief Parses options in the style of getopt.
+    *
+    * Options may be grouped (-lw) and values attached (-n5) or separate (-n 5).
+    * -- ends the options, and so does the first operand. Values of repeated
+    * options are joined with newlines (-e a -e b gives "a\nb").
+    *
+    * @param args arguments, args[0] being the builtin name.
+    * @param spec option letters, each followed by : if it takes a value.
+    * @param options parsed options, letter to value ("" for flags).
+    * @param operands the remaining arguments.
+    * @param quiet whether to fail without printing errors.
+    * @return false after printing an error for unknown options or missing values.
+    */
+    bool get_options(const std::vector<std::string>& args, const std::string& spec,
+                     std::map<char, std::string>& options, std::vector<std::string>& operands, bool quiet = false);
+
+    /**
+    * @brief Counts newline bytes, 16 at a time with SSE2.
+    *
+    * @param data bytes to scan.
+    * @param size number of bytes.
+    * @return the number of newlines.
+    */
+    uint64_t count_lines(const char* data, size_t size);
+
+    /**
+    * @brief Runs commands with stage builders as one pipeline, in this process.
+    *
+    * Standard input feeds the first stage, the last writes standard output.
+    * A stage with file operands reads them instead, and the stages before
+    * it, whose output it would ignore, do not run.
+    *
+    * @param commands the commands, expanded, each having a stage builder.
+    * @return exit status of the last command.
+    */
+    int run_stages(const std::vector<std::vector<std::string>>& commands);
+
+    /**
+    * @brief Runs a task for every index on a pool of threads, one per core at most.
+    *
+    * @param count number of indexes.
+    * @param task called once for every index in [0, count), from any thread.
+    */
+    void parallel_for(size_t count, const std::function<void(size_t)>& task);
+}
+
+#endif //CASH_STREAM_H
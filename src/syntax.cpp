@@ -0,0 +1,625 @@
+/**
+ * @file syntax.cpp
+ * @brief syntax tree for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * A recursive descent parser turning words into nodes, and the nodes' behaviour.
+ */
+
+#include <iostream>
+#include "syntax.h"
+#include "variables.h"
+#include "cash.h"
+#include "profile.h"
+
+namespace
+{
+    /**
+    * @brief Parser state over the words of a command line.
+    */
+    struct Parser
+    {
+        const std::vector<std::string>& words;
+        size_t pos;
+        bool incomplete;
+        bool error;
+        int braces; //!< How many fan-ins the parser is inside, where } ends a command.
+        const std::vector<size_t>* lines; //!< Input line of each word, if known.
+        const std::vector<bool>* quoted; //!< Whether each word had its pattern characters quoted, if known.
+
+        bool at(const char* word) const
+        {
+            return pos < words.size() && words[pos] == word;
+        }
+
+        // Reserved words that end a list when they appear where a command should start
+        bool at_terminator() const
+        {
+            return pos < words.size() && (words[pos] == "esac" || words[pos] == ";;"
+                || words[pos] == "do" || words[pos] == "done");
+        }
+
+        size_t line_at() const
+        {
+            return lines != nullptr && pos < lines->size() ? (*lines)[pos] : 0;
+        }
+
+        bool quoted_at() const
+        {
+            return quoted != nullptr && pos < quoted->size() && (*quoted)[pos];
+        }
+
+        void fail(const std::string& near)
+        {
+            if (!error)
+            {
+                std::cout << RED << "cash: Bad syntax near " << near << "." << RESET << std::endl;
+            }
+            error = true;
+        }
+
+        // Reports running out of words, which means more lines are needed
+        bool need_more()
+        {
+            if (pos >= words.size())
+            {
+                incomplete = true;
+                return true;
+            }
+            return false;
+        }
+
+        void skip_separators()
+        {
+            while (at(";"))
+            {
+                ++pos;
+            }
+        }
+
+        cash::NodePtr sequence();
+        cash::NodePtr and_or();
+        cash::NodePtr command();
+        cash::NodePtr pipeline();
+        cash::NodePtr case_command();
+        cash::NodePtr for_command();
+        cash::NodePtr fan_in();
+        cash::NodePtr loop_body();
+    };
+
+    cash::NodePtr Parser::sequence()
+    {
+        std::unique_ptr<cash::SequenceNode> node(new cash::SequenceNode);
+        skip_separators();
+        while (pos < words.size() && !at_terminator() && !error && !incomplete)
+        {
+            cash::NodePtr item = and_or();
+            if (!item)
+            {
+                return nullptr;
+            }
+            node->items.push_back(std::move(item));
+            skip_separators();
+        }
+        if (error || incomplete)
+        {
+            return nullptr;
+        }
+        // Skip the extra node for a single command
+        if (node->items.size() == 1)
+        {
+            return std::move(node->items[0]);
+        }
+        return std::move(node);
+    }
+
+    cash::NodePtr Parser::and_or()
+    {
+        std::unique_ptr<cash::AndOrNode> node(new cash::AndOrNode);
+        while (true)
+        {
+            cash::NodePtr item = command();
+            if (!item)
+            {
+                return nullptr;
+            }
+            node->items.push_back(std::move(item));
+            if (!at("&&") && !at("||"))
+            {
+                break;
+            }
+            node->connectors.push_back(words[pos++]);
+            if (need_more())
+            {
+                return nullptr;
+            }
+        }
+        if (node->items.size() == 1)
+        {
+            return std::move(node->items[0]);
+        }
+        return std::move(node);
+    }
+
+    cash::NodePtr Parser::command()
+    {
+        const size_t line = line_at();
+        cash::NodePtr node;
+        if (at("case"))
+        {
+            node = case_command();
+        }
+        else if (at("for"))
+        {
+            node = for_command();
+        }
+        else if (at("{"))
+        {
+            node = fan_in();
+        }
+        else
+        {
+            node = pipeline();
+        }
+        if (node)
+        {
+            node->line = line;
+        }
+        return node;
+    }
+
+    cash::NodePtr Parser::pipeline()
+    {
+        std::unique_ptr<cash::PipelineNode> node(new cash::PipelineNode);
+        bool in_conditional = false;
+        while (pos < words.size())
+        {
+            const std::string& word = words[pos];
+            // Operators inside [[ ]] belong to the conditional expression
+            if (word == "[[")
+            {
+                in_conditional = true;
+            }
+            else if (word == "]]")
+            {
+                in_conditional = false;
+            }
+            else if (!in_conditional && (word == ";" || word == ";;" || word == "&&" || word == "||"
+                || word == "&" || (word == "}" && braces > 0)))
+            {
+                break;
+            }
+            node->words.push_back(word);
+            node->quoted.push_back(quoted_at());
+            ++pos;
+        }
+
+        if (node->words.empty())
+        {
+            fail(pos < words.size() ? words[pos] : "end of line");
+            return nullptr;
+        }
+        if (node->words.back() == "|")
+        {
+            incomplete = true;
+            return nullptr;
+        }
+        return std::move(node);
+    }
+
+    cash::NodePtr Parser::case_command()
+    {
+        std::unique_ptr<cash::CaseNode> node(new cash::CaseNode);
+        ++pos;
+        if (need_more())
+        {
+            return nullptr;
+        }
+        node->word = words[pos++];
+        if (need_more())
+        {
+            return nullptr;
+        }
+        if (!at("in"))
+        {
+            fail(words[pos]);
+            return nullptr;
+        }
+        ++pos;
+
+        while (true)
+        {
+            skip_separators();
+            if (need_more())
+            {
+                return nullptr;
+            }
+            if (at("esac"))
+            {
+                ++pos;
+                return std::move(node);
+            }
+
+            // Patterns run up to the word ending with ), e.g. "(a|b*)" or "a | b )"
+            std::string text;
+            while (true)
+            {
+                if (need_more())
+                {
+                    return nullptr;
+                }
+                const std::string& word = words[pos++];
+                text += word;
+                if (!word.empty() && word.back() == ')')
+                {
+                    break;
+                }
+            }
+            text.pop_back();
+            if (!text.empty() && text[0] == '(')
+            {
+                text.erase(0, 1);
+            }
+
+            // Splits alternatives on | outside brackets
+            std::vector<std::string> alternatives(1);
+            bool in_bracket = false;
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                const char ch = text[i];
+                if (ch == '\\' && i + 1 < text.size())
+                {
+                    alternatives.back() += ch;
+                    alternatives.back() += text[++i];
+                    continue;
+                }
+                if (ch == '[')
+                {
+                    in_bracket = true;
+                }
+                else if (ch == ']')
+                {
+                    in_bracket = false;
+                }
+                else if (ch == '|' && !in_bracket)
+                {
+                    alternatives.emplace_back();
+                    continue;
+                }
+                alternatives.back() += ch;
+            }
+            for (const auto& alternative : alternatives)
+            {
+                node->dynamic = node->dynamic || alternative.find('$') != std::string::npos;
+            }
+            node->patterns.push_back(alternatives);
+
+            cash::NodePtr body = sequence();
+            if (!body)
+            {
+                if (!error && !incomplete)
+                {
+                    // An arm with no commands
+                    body.reset(new cash::SequenceNode);
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+            node->bodies.push_back(std::move(body));
+
+            if (at(";;"))
+            {
+                ++pos;
+            }
+            else if (need_more())
+            {
+                return nullptr;
+            }
+            else if (!at("esac"))
+            {
+                fail(words[pos]);
+                return nullptr;
+            }
+        }
+    }
+
+    cash::NodePtr Parser::for_command()
+    {
+        ++pos;
+        if (need_more())
+        {
+            return nullptr;
+        }
+
+        // for ((init; condition; update))
+        const std::string& header = words[pos];
+        if (header.compare(0, 2, "((") == 0)
+        {
+            std::unique_ptr<cash::ArithmeticForNode> node(new cash::ArithmeticForNode);
+            const size_t first = header.find(';');
+            const size_t second = first == std::string::npos ? first : header.find(';', first + 1);
+            if (second == std::string::npos || header.size() < 4 || header.compare(header.size() - 2, 2, "))") != 0)
+            {
+                fail(header);
+                return nullptr;
+            }
+            node->init.reset(new cash::Arithmetic(header.substr(2, first - 2)));
+            node->condition.reset(new cash::Arithmetic(header.substr(first + 1, second - first - 1)));
+            node->update.reset(new cash::Arithmetic(header.substr(second + 1, header.size() - second - 3)));
+            ++pos;
+            node->body = loop_body();
+            return node->body ? std::move(node) : nullptr;
+        }
+
+        std::unique_ptr<cash::ForNode> node(new cash::ForNode);
+        if (!cash::is_name(header))
+        {
+            fail(header);
+            return nullptr;
+        }
+        node->name = header;
+        ++pos;
+        skip_separators();
+        if (need_more())
+        {
+            return nullptr;
+        }
+        if (at("in"))
+        {
+            ++pos;
+            while (pos < words.size() && !at(";"))
+            {
+                node->quoted.push_back(quoted_at());
+                node->words.push_back(words[pos++]);
+            }
+        }
+        node->body = loop_body();
+        return node->body ? std::move(node) : nullptr;
+    }
+
+    // Parses "{ producer & producer ... } |+ consumer", the consumer being optional
+    cash::NodePtr Parser::fan_in()
+    {
+        std::unique_ptr<cash::FanInNode> node(new cash::FanInNode);
+        ++pos;
+        ++braces;
+        while (true)
+        {
+            skip_separators();
+            if (need_more())
+            {
+                return nullptr;
+            }
+            if (at("}"))
+            {
+                break;
+            }
+            cash::NodePtr producer = and_or();
+            if (!producer)
+            {
+                return nullptr;
+            }
+            node->producers.push_back(std::move(producer));
+            // A line break may follow the &, but does not separate producers by itself
+            skip_separators();
+            if (need_more())
+            {
+                return nullptr;
+            }
+            if (at("&"))
+            {
+                ++pos;
+            }
+            else if (!at("}"))
+            {
+                fail(words[pos]);
+                return nullptr;
+            }
+        }
+        --braces;
+        ++pos;
+        if (node->producers.empty())
+        {
+            fail("}");
+            return nullptr;
+        }
+
+        if (at("|+"))
+        {
+            ++pos;
+            if (need_more())
+            {
+                return nullptr;
+            }
+            node->consumer = command();
+            if (!node->consumer)
+            {
+                return nullptr;
+            }
+        }
+        if (pos < words.size() && !at(";") && !at(";;") && !at("&&") && !at("||") && !at("&")
+            && !(at("}") && braces > 0))
+        {
+            fail(words[pos]);
+            return nullptr;
+        }
+        return std::move(node);
+    }
+
+    // Parses "do commands done"
+    cash::NodePtr Parser::loop_body()
+    {
+        skip_separators();
+        if (need_more())
+        {
+            return nullptr;
+        }
+        if (!at("do"))
+        {
+            fail(words[pos]);
+            return nullptr;
+        }
+        ++pos;
+        cash::NodePtr body = sequence();
+        if (!body)
+        {
+            return nullptr;
+        }
+        if (need_more())
+        {
+            return nullptr;
+        }
+        if (!at("done"))
+        {
+            fail(words[pos]);
+            return nullptr;
+        }
+        ++pos;
+        return body;
+    }
+}
+
+int cash::PipelineNode::run()
+{
+    ProfileScope scope(line);
+    return execute_pipeline(words, &quoted);
+}
+
+int cash::AndOrNode::run()
+{
+    int status = items[0]->run();
+    last_status = status;
+    for (size_t i = 1; i < items.size(); ++i)
+    {
+        // && runs the next pipeline on success, || on failure
+        if ((connectors[i - 1] == "&&") == (status == 0))
+        {
+            status = items[i]->run();
+            last_status = status;
+        }
+    }
+    return status;
+}
+
+int cash::SequenceNode::run()
+{
+    int status = 0;
+    for (const auto& item : items)
+    {
+        status = item->run();
+        last_status = status;
+    }
+    return status;
+}
+
+int cash::CaseNode::run()
+{
+    ProfileScope scope(line);
+    // Constant patterns are compiled once; ones with variables are expanded again, the DFA rebuilt when that changes the text
+    if (!matcher || dynamic)
+    {
+        std::vector<std::vector<std::string>> expanded(patterns.size());
+        std::string text;
+        for (size_t arm = 0; arm < patterns.size(); ++arm)
+        {
+            for (const auto& pattern : patterns[arm])
+            {
+                expanded[arm].push_back(expand_word(pattern));
+                text += expanded[arm].back();
+                text += '\0';
+            }
+            text += '\n';
+        }
+        if (!matcher || text != compiled_text)
+        {
+            matcher.reset(new GlobDfa(expanded));
+            compiled_text = text;
+        }
+    }
+
+    const int arm = matcher->match(expand_word(word));
+    if (arm == -1)
+    {
+        return 0;
+    }
+    return bodies[arm]->run();
+}
+
+int cash::ForNode::run()
+{
+    ProfileScope scope(line);
+    int status = 0;
+    for (size_t w = 0; w < words.size(); ++w)
+    {
+        const std::string& word = words[w];
+        BraceRange range;
+        if (word.find('$') == std::string::npos && parse_range(word, range))
+        {
+            // Ranges are walked lazily, never materialized
+            const unsigned long long steps = range.steps();
+            const bool plain = range.prefix.empty() && range.suffix.empty();
+            for (unsigned long long n = 0;; ++n)
+            {
+                if (plain)
+                {
+                    set_integer(name, range.at(n));
+                }
+                else
+                {
+                    set_variable(name, range.prefix + std::to_string(range.at(n)) + range.suffix);
+                }
+                status = body->run();
+                // Counted in steps, as stepping past a limit of long long would overflow
+                if (n == steps)
+                {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        const std::vector<bool> literal{quoted[w]};
+        const std::vector<std::string> values = expand_all(std::vector<std::string>{word}, &literal);
+        for (const auto& value : values)
+        {
+            set_variable(name, value);
+            status = body->run();
+        }
+    }
+    return status;
+}
+
+int cash::ArithmeticForNode::run()
+{
+    ProfileScope scope(line);
+    int status = 0;
+    bool error = false;
+    init->evaluate(error);
+    while (!error && (condition->empty() || condition->evaluate(error) != 0) && !error)
+    {
+        status = body->run();
+        update->evaluate(error);
+    }
+    return error ? 1 : status;
+}
+
+cash::NodePtr cash::parse_tree(const std::vector<std::string>& args, bool& incomplete,
+                              const std::vector<size_t>* lines, const std::vector<bool>* quoted)
+{
+    Parser parser{args, 0, false, false, 0, lines, quoted};
+    NodePtr tree = parser.sequence();
+    incomplete = parser.incomplete && !parser.error;
+    if (!tree || parser.error || parser.incomplete)
+    {
+        return nullptr;
+    }
+    if (parser.pos != args.size())
+    {
+        parser.fail(args[parser.pos]);
+        return nullptr;
+    }
+    return tree;
+}
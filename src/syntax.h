@@ -0,0 +1,146 @@
+/**
+ * @file syntax.h
+ * @brief syntax tree for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of the command parser and the nodes it produces.
+ */
+
+
+#ifndef CASH_SYNTAX_H
+#define CASH_SYNTAX_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "arithmetic.h"
+#include "glob_dfa.h"
+
+namespace cash
+{
+    /**
+    * @brief A parsed piece of a command line.
+    */
+    struct Node
+    {
+        virtual ~Node() = default;
+
+        size_t line = 0; //!< Input line it starts on, 0 when not known.
+
+        /**
+        * @brief Runs the node.
+        *
+        * @return an integer, exit status.
+        */
+        virtual int run() = 0;
+    };
+
+    typedef std::unique_ptr<Node> NodePtr;
+
+    /**
+    * @brief A pipeline of simple commands, kept as words until it runs.
+    */
+    struct PipelineNode : Node
+    {
+        std::vector<std::string> words; //!< Words, including the | separators.
+        std::vector<bool> quoted; //!< Whether each word had its pattern characters quoted.
+
+        int run() override;
+    };
+
+    /**
+    * @brief Pipelines joined by && and ||.
+    */
+    struct AndOrNode : Node
+    {
+        std::vector<NodePtr> items; //!< The pipelines.
+        std::vector<std::string> connectors; //!< connectors[i] joins items[i] and items[i + 1].
+
+        int run() override;
+    };
+
+    /**
+    * @brief Commands separated by ;.
+    */
+    struct SequenceNode : Node
+    {
+        std::vector<NodePtr> items; //!< The commands, in order.
+
+        int run() override;
+    };
+
+    /**
+    * @brief case word in pattern) commands;; ... esac
+    */
+    struct CaseNode : Node
+    {
+        std::string word; //!< The word to dispatch on.
+        std::vector<std::vector<std::string>> patterns; //!< Alternative patterns of each arm.
+        std::vector<NodePtr> bodies; //!< Commands of each arm.
+        bool dynamic = false; //!< Whether a pattern expands a variable, so its text can change between runs.
+
+        int run() override;
+
+    private:
+        std::string compiled_text; //!< Expanded patterns the matcher was built from.
+        std::unique_ptr<GlobDfa> matcher; //!< All arms compiled together.
+    };
+
+    /**
+    * @brief for name in words; do commands; done
+    *
+    * Brace sequences in the word list are iterated lazily, and a plain
+    * {first..last} sets the loop variable as a native integer.
+    */
+    struct ForNode : Node
+    {
+        std::string name; //!< The loop variable.
+        std::vector<std::string> words; //!< Unexpanded words to iterate over.
+        std::vector<bool> quoted; //!< Whether each word had its pattern characters quoted.
+        NodePtr body; //!< Commands run for each word.
+
+        int run() override;
+    };
+
+    /**
+    * @brief for ((init; condition; update)); do commands; done
+    */
+    struct ArithmeticForNode : Node
+    {
+        std::unique_ptr<Arithmetic> init; //!< Evaluated once.
+        std::unique_ptr<Arithmetic> condition; //!< Checked before each iteration, true when empty.
+        std::unique_ptr<Arithmetic> update; //!< Evaluated after each iteration.
+        NodePtr body; //!< Commands run while the condition holds.
+
+        int run() override;
+    };
+
+    /**
+    * @brief { producer & producer ... } |+ consumer
+    *
+    * The producers run at the same time, and their output is merged a
+    * whole line at a time, so that lines of different producers never mix.
+    */
+    struct FanInNode : Node
+    {
+        std::vector<NodePtr> producers; //!< Commands run side by side.
+        NodePtr consumer; //!< Reads the merged lines, null to leave them on standard output.
+
+        int run() override;
+    };
+
+    /**
+    * @brief Parses words into a syntax tree.
+    *
+    * @param args the words of one or more lines.
+    * @param incomplete set to true when the input ends inside a compound command.
+    * @param lines if given, the input line of each word, for the profiler.
+    * @param quoted if given, whether each word had its pattern characters quoted, as parse tells.
+    * @return the tree, or nullptr on a syntax error or incomplete input.
+    */
+    NodePtr parse_tree(const std::vector<std::string>& args, bool& incomplete,
+                       const std::vector<size_t>* lines = nullptr, const std::vector<bool>* quoted = nullptr);
+}
+
+#endif //CASH_SYNTAX_H
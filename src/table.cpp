@@ -0,0 +1,78 @@
+/**
+ * @file table.cpp
+ * @brief hash tables keyed by byte strings
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * The hash and the arena behind KeyTable.
+ */
+
+#include <algorithm>
+#include "table.h"
+
+namespace
+{
+    // Blocks of the arena, large keys get a block of their own
+    const size_t BLOCK_SIZE = 1 << 20;
+
+    const uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+
+    inline uint64_t load(const char* data)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+
+    // MurmurHash3's finalizer, so every input bit reaches every output bit
+    inline uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        value ^= value >> 33;
+        return value;
+    }
+}
+
+uint64_t cash::hash_bytes(const char* data, const size_t size)
+{
+    uint64_t hash = size * MULTIPLIER;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        hash = (hash ^ mix(load(data + i))) * MULTIPLIER;
+    }
+    if (i < size)
+    {
+        uint64_t tail = 0;
+        std::memcpy(&tail, data + i, size - i);
+        hash = (hash ^ mix(tail)) * MULTIPLIER;
+    }
+    return mix(hash);
+}
+
+const char* cash::Arena::store(const char* data, const size_t size)
+{
+    // Empty keys need a block to point into too
+    if (used + size > capacity || blocks.empty())
+    {
+        capacity = std::max(BLOCK_SIZE, size);
+        blocks.emplace_back(new char[capacity]);
+        used = 0;
+    }
+    char* copy = blocks.back().get() + used;
+    std::memcpy(copy, data, size);
+    used += size;
+    return copy;
+}
+
+void cash::Arena::clear()
+{
+    if (blocks.size() > 1)
+    {
+        blocks.erase(blocks.begin(), blocks.end() - 1);
+    }
+    used = 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file table.h
+ * @brief hash tables keyed by byte strings
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains the arena and the open-addressing table used by the builtins
+ * that group lines by a key.
+ */
+
+
+#ifndef CASH_TABLE_H
+#define CASH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief Hashes bytes, 8 at a time.
+    *
+    * @param data bytes to hash.
+    * @param size number of bytes.
+    * @return a 64-bit hash.
+    */
+    uint64_t hash_bytes(const char* data, size_t size);
+
+    /**
+    * @brief Copies of byte strings in large blocks, freed all at once.
+    */
+    class Arena
+    {
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /**
+        * @brief Copies bytes into the arena.
+        *
+        * @param data bytes to copy.
+        * @param size number of bytes.
+        * @return the copy, valid as long as the arena.
+        */
+        const char* store(const char* data, size_t size);
+
+        /**
+        * @brief Forgets what was stored, keeping the last block for what comes next.
+        */
+        void clear();
+
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks; //!< Blocks, the last one being filled.
+        size_t used = 0; //!< Bytes used in the last block.
+        size_t capacity = 0; //!< Size of the last block.
+    };
+
+    /**
+    * @brief Open-addressing hash table from byte strings to values.
+    *
+    * Entries are kept in insertion order in a dense vector and the slots
+    * only hold their indexes, so growing moves 4 bytes per entry and
+    * walking the entries is a scan. Keys are copied into an arena.
+    */
+    template <typename Value>
+    class KeyTable
+    {
+    public:
+        /**
+        * @brief An entry, in insertion order.
+        */
+        struct Entry
+        {
+            const char* key;
+            size_t length;
+            uint64_t hash;
+            Value value;
+        };
+
+        KeyTable() : slots(16, 0)
+        {
+        }
+
+        /**
+        * @brief Finds the value of a key, inserting a default one if missing.
+        *
+        * @param key bytes of the key, copied if inserted.
+        * @param length length of the key.
+        * @return the value, valid until the next insertion.
+        */
+        Value& operator()(const char* key, const size_t length)
+        {
+            const uint64_t hash = hash_bytes(key, length);
+            uint32_t& slot = locate(key, length, hash);
+            if (slot == 0)
+            {
+                entries.push_back(Entry{arena.store(key, length), length, hash, Value()});
+                slot = static_cast<uint32_t>(entries.size());
+                // Growing at half full keeps probe sequences short
+                if (entries.size() * 2 > slots.size())
+                {
+                    grow();
+                }
+                return entries.back().value;
+            }
+            return entries[slot - 1].value;
+        }
+
+        /**
+        * @brief Finds the value of a key.
+        *
+        * @param key bytes of the key.
+        * @param length length of the key.
+        * @return the value, or nullptr if the key is missing.
+        */
+        Value* find(const char* key, const size_t length)
+        {
+            const uint32_t slot = locate(key, length, hash_bytes(key, length));
+            return slot == 0 ? nullptr : &entries[slot - 1].value;
+        }
+
+        /**
+        * @brief The entries, in insertion order.
+        */
+        std::vector<Entry>& items()
+        {
+            return entries;
+        }
+
+    private:
+        // The slot of a key, or the empty slot where it would go
+        uint32_t& locate(const char* key, const size_t length, const uint64_t hash)
+        {
+            const size_t mask = slots.size() - 1;
+            for (size_t i = hash & mask; ; i = (i + 1) & mask)
+            {
+                uint32_t& slot = slots[i];
+                if (slot == 0)
+                {
+                    return slot;
+                }
+                const Entry& entry = entries[slot - 1];
+                if (entry.hash == hash && entry.length == length && std::memcmp(entry.key, key, length) == 0)
+                {
+                    return slot;
+                }
+            }
+        }
+
+        void grow()
+        {
+            slots.assign(slots.size() * 2, 0);
+            const size_t mask = slots.size() - 1;
+            for (size_t e = 0; e < entries.size(); ++e)
+            {
+                size_t i = entries[e].hash & mask;
+                while (slots[i] != 0)
+                {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = static_cast<uint32_t>(e + 1);
+            }
+        }
+
+        std::vector<Entry> entries;
+        std::vector<uint32_t> slots; //!< Entry index + 1, or 0 for empty slots.
+        Arena arena;
+    };
+}
+
+#endif //CASH_TABLE_H
@@ -0,0 +1,325 @@
+/**
+ * @file tail.cpp
+ * @brief the tail builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Regular files are mapped and scanned backwards from the end for newlines,
+ * so only the pages holding the last lines are ever read. Pipes have to be
+ * read through, keeping only about as much as the last lines need. -f
+ * waits on inotify for the followed files to change instead of polling.
+ */
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    // Pipe input is trimmed to the last lines whenever it grows past this
+    const size_t TRIM_SIZE = 4 * cash::CHUNK_SIZE;
+
+    volatile sig_atomic_t interrupted = 0;
+
+    void stop_following(int)
+    {
+        interrupted = 1;
+    }
+
+    /**
+    * @brief What to print: the last lines or bytes, or everything from one on.
+    */
+    struct Selection
+    {
+        bool bytes = false;
+        bool from_start = false; //!< Whether the count is +N, the first line or byte printed.
+        uint64_t count = 10;
+    };
+
+    // Offset of the first byte printed
+    size_t start_of(const char* data, const size_t size, const Selection& selection)
+    {
+        if (selection.from_start)
+        {
+            const uint64_t skip = selection.count > 0 ? selection.count - 1 : 0;
+            if (selection.bytes)
+            {
+                return static_cast<size_t>(std::min<uint64_t>(skip, size));
+            }
+            const char* position = data;
+            for (uint64_t line = 0; line < skip; ++line)
+            {
+                const char* newline = static_cast<const char*>(std::memchr(position, '\n', data + size - position));
+                if (newline == nullptr)
+                {
+                    return size;
+                }
+                position = newline + 1;
+            }
+            return position - data;
+        }
+
+        if (selection.bytes)
+        {
+            return size - static_cast<size_t>(std::min<uint64_t>(selection.count, size));
+        }
+        if (selection.count == 0)
+        {
+            return size;
+        }
+        // The newline ending the last line does not start a line
+        size_t end = size > 0 && data[size - 1] == '\n' ? size - 1 : size;
+        for (uint64_t left = selection.count; ; --left)
+        {
+            const char* newline = static_cast<const char*>(memrchr(data, '\n', end));
+            if (newline == nullptr)
+            {
+                return 0;
+            }
+            if (left == 1)
+            {
+                return newline - data + 1;
+            }
+            end = newline - data;
+        }
+    }
+
+    /**
+    * @brief A file being followed with -f.
+    */
+    struct Followed
+    {
+        std::string name;
+        int fd;
+        off_t offset; //!< How far the file has been printed.
+        int watch;
+    };
+
+    // Prints what has been appended to a followed file since last time
+    void print_appended(Followed& file, cash::Output& output)
+    {
+        struct stat info;
+        if (fstat(file.fd, &info) != 0)
+        {
+            return;
+        }
+        if (info.st_size < file.offset)
+        {
+            cash::report("tail", file.name + ": file truncated");
+            file.offset = 0;
+        }
+        std::vector<char> buffer(cash::CHUNK_SIZE);
+        while (file.offset < info.st_size)
+        {
+            const ssize_t got = pread(file.fd, buffer.data(), buffer.size(), file.offset);
+            if (got <= 0)
+            {
+                break;
+            }
+            output.write(buffer.data(), static_cast<size_t>(got));
+            file.offset += got;
+        }
+    }
+
+    /**
+    * @brief Prints what is appended to the files until interrupted.
+    */
+    void follow(std::vector<Followed>& files, cash::Output& output, const bool headers)
+    {
+        const int notify = inotify_init1(IN_CLOEXEC);
+        if (notify == -1)
+        {
+            cash::report("tail", std::string("inotify: ") + strerror(errno));
+            return;
+        }
+        for (auto& file : files)
+        {
+            file.watch = inotify_add_watch(notify, file.name.c_str(), IN_MODIFY | IN_ATTRIB);
+        }
+
+        // Ctrl+C ends following and returns to the prompt
+        struct sigaction action = {}, saved = {};
+        action.sa_handler = stop_following;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, &saved);
+        interrupted = 0;
+
+        const Followed* last = files.empty() ? nullptr : &files.back();
+        std::vector<char> events(4096);
+        while (!interrupted && !output.failed())
+        {
+            output.flush();
+            const ssize_t got = read(notify, events.data(), events.size());
+            if (got <= 0)
+            {
+                if (got < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            for (ssize_t offset = 0; offset < got; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+                for (auto& file : files)
+                {
+                    if (file.watch != event->wd)
+                    {
+                        continue;
+                    }
+                    // A header whenever the output switches files, like coreutils
+                    if (headers && last != &file)
+                    {
+                        output.write("\n==> " + file.name + " <==\n");
+                        last = &file;
+                    }
+                    print_appended(file, output);
+                }
+            }
+        }
+        sigaction(SIGINT, &saved, nullptr);
+        output.flush();
+        close(notify);
+    }
+}
+
+int cash::tail(const std::vector<std::string>& args)
+{
+    std::vector<std::string> arguments = args;
+    // tail -5 and tail +5 are tail -n 5 and tail -n +5
+    if (arguments.size() > 1 && arguments[1].size() > 1 && (arguments[1][0] == '-' || arguments[1][0] == '+')
+        && arguments[1].find_first_not_of("0123456789", 1) == std::string::npos)
+    {
+        arguments[1] = "-n" + arguments[1];
+    }
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    // Other options, and counts like -c 1K, run the tail in PATH
+    if (!get_options(arguments, "n:c:fqv", options, operands, true))
+    {
+        return spawn(args);
+    }
+
+    Selection selection;
+    selection.bytes = options.count('c') != 0;
+    std::string count = selection.bytes ? options['c'] : options.count('n') ? options['n'] : "10";
+    // +N counts from the start, -N (as rewritten from tail -N) from the end
+    if (!count.empty() && (count[0] == '+' || count[0] == '-'))
+    {
+        selection.from_start = count[0] == '+';
+        count.erase(0, 1);
+    }
+    if (count.empty() || count.size() > 18 || count.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return spawn(args);
+    }
+    selection.count = std::stoull(count);
+
+    if (operands.empty())
+    {
+        operands.push_back("-");
+    }
+    const bool headers = (operands.size() > 1 || options.count('v')) && !options.count('q');
+
+    int status = 0;
+    Output output;
+    std::vector<Followed> followed;
+    for (size_t i = 0; i < operands.size(); ++i)
+    {
+        const std::string name = operands[i] == "-" ? "standard input" : operands[i];
+        const int fd = open_input("tail", operands[i]);
+        if (fd == -1)
+        {
+            status = 1;
+            continue;
+        }
+        if (headers)
+        {
+            output.write((i > 0 ? "\n" : "") + std::string("==> ") + name + " <==\n");
+        }
+
+        MappedFile file;
+        if (file.map(fd))
+        {
+            const size_t start = start_of(file.data(), file.size(), selection);
+            output.write(file.data() + start, file.size() - start);
+            // Pipes cannot be followed, like in coreutils
+            if (options.count('f') && operands[i] != "-")
+            {
+                followed.push_back(Followed{operands[i], fd, static_cast<off_t>(file.size()), -1});
+                continue;
+            }
+        }
+        else if (selection.from_start)
+        {
+            // Everything after the skipped lines or bytes goes out as it arrives
+            uint64_t skip = selection.count > 0 ? selection.count - 1 : 0;
+            read_chunks(fd, [&](const char* data, const size_t size)
+            {
+                size_t begin = 0;
+                while (skip > 0 && begin < size)
+                {
+                    if (selection.bytes)
+                    {
+                        const size_t skipped = static_cast<size_t>(std::min<uint64_t>(skip, size - begin));
+                        begin += skipped;
+                        skip -= skipped;
+                        continue;
+                    }
+                    const char* newline = static_cast<const char*>(std::memchr(data + begin, '\n', size - begin));
+                    if (newline == nullptr)
+                    {
+                        begin = size;
+                        break;
+                    }
+                    begin = newline - data + 1;
+                    --skip;
+                }
+                output.write(data + begin, size - begin);
+                return !output.failed();
+            });
+        }
+        else
+        {
+            // Only the end is kept, cut back whenever it grows
+            std::string kept;
+            if (!read_chunks(fd, [&](const char* data, const size_t size)
+            {
+                kept.append(data, size);
+                if (kept.size() > TRIM_SIZE)
+                {
+                    kept.erase(0, start_of(kept.data(), kept.size(), selection));
+                }
+                return true;
+            }))
+            {
+                report("tail", name + ": " + strerror(errno));
+                status = 1;
+            }
+            const size_t start = start_of(kept.data(), kept.size(), selection);
+            output.write(kept.data() + start, kept.size() - start);
+        }
+        close_input(fd);
+    }
+
+    if (!followed.empty())
+    {
+        follow(followed, output, headers);
+        for (const auto& file : followed)
+        {
+            close(file.fd);
+        }
+    }
+    return status;
+}
@@ -0,0 +1,495 @@
+/**
+ * @file tr.cpp
+ * @brief the tr builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * The character sets are compiled once into 256-entry tables. Tables that
+ * change a few ranges of bytes by a constant, like a-z to A-Z or space to
+ * newline, are applied 16 bytes at a time with SSE2 compares and masked
+ * adds; SSE2 has no byte shuffle, so other tables are looked up byte by
+ * byte. Deleting and squeezing copy 16 bytes at a time until a block holds
+ * a byte of their set.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Options handled here, the others run the external tr
+    const std::string OPTIONS = "cCds";
+
+    // Tables with more ranges than this are looked up byte by byte
+    const size_t MAX_RANGES = 8;
+
+    /**
+    * @brief Bytes from low to low + span, shifted by delta.
+    */
+    struct Range
+    {
+        uint8_t low;
+        uint8_t span;
+        uint8_t delta;
+    };
+
+    // Splits a translation table into ranges of consecutive bytes moved by the same amount
+    std::vector<Range> ranges_of(const uint8_t (&table)[256])
+    {
+        std::vector<Range> ranges;
+        for (int ch = 0; ch < 256; ++ch)
+        {
+            const uint8_t delta = static_cast<uint8_t>(table[ch] - ch);
+            if (delta == 0)
+            {
+                continue;
+            }
+            if (!ranges.empty() && ranges.back().low + ranges.back().span + 1 == ch && ranges.back().delta == delta)
+            {
+                ++ranges.back().span;
+            }
+            else
+            {
+                ranges.push_back(Range{static_cast<uint8_t>(ch), 0, delta});
+            }
+        }
+        return ranges;
+    }
+
+    // Ranges of the bytes in a set, the delta being unused
+    std::vector<Range> ranges_of(const bool (&set)[256])
+    {
+        uint8_t table[256];
+        for (int ch = 0; ch < 256; ++ch)
+        {
+            table[ch] = static_cast<uint8_t>(set[ch] ? ch + 1 : ch);
+        }
+        // Neighbouring members get the same delta and merge
+        return ranges_of(table);
+    }
+
+#ifdef __SSE2__
+    // Lanes of the bytes in a range
+    inline __m128i in_range(const __m128i bytes, const Range& range)
+    {
+        const __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(static_cast<char>(range.low)));
+        return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(static_cast<char>(range.span))), shifted);
+    }
+
+    inline uint32_t set_mask(const __m128i bytes, const std::vector<Range>& ranges)
+    {
+        __m128i hits = _mm_setzero_si128();
+        for (const auto& range : ranges)
+        {
+            hits = _mm_or_si128(hits, in_range(bytes, range));
+        }
+        return static_cast<uint32_t>(_mm_movemask_epi8(hits));
+    }
+#endif
+
+    /**
+    * @brief Expands a set operand into its characters, in order.
+    *
+    * Understands escapes (\n, \\, \NNN), ranges (a-z), classes ([:alpha:]),
+    * equivalence classes ([=c=]) and repeats ([c*n], or [c*] to fill up to
+    * fill characters).
+    */
+    bool expand_set(const std::string& text, const size_t fill, std::string& set, std::string& error)
+    {
+        // Reads one character at i, with escapes
+        auto character = [&](size_t& i) -> unsigned char
+        {
+            if (text[i] != '\\' || i + 1 == text.size())
+            {
+                return static_cast<unsigned char>(text[i++]);
+            }
+            ++i;
+            if (text[i] >= '0' && text[i] <= '7')
+            {
+                int value = 0;
+                for (int digits = 0; digits < 3 && i < text.size() && text[i] >= '0' && text[i] <= '7'; ++digits)
+                {
+                    value = value * 8 + text[i++] - '0';
+                }
+                return static_cast<unsigned char>(value);
+            }
+            const char escaped = text[i++];
+            switch (escaped)
+            {
+            case 'a': return '\a';
+            case 'b': return '\b';
+            case 'f': return '\f';
+            case 'n': return '\n';
+            case 'r': return '\r';
+            case 't': return '\t';
+            case 'v': return '\v';
+            default: return static_cast<unsigned char>(escaped);
+            }
+        };
+
+        static const struct
+        {
+            const char* name;
+            int (*test)(int);
+        } classes[] = {
+            {"alnum", isalnum}, {"alpha", isalpha}, {"blank", isblank}, {"cntrl", iscntrl},
+            {"digit", isdigit}, {"graph", isgraph}, {"lower", islower}, {"print", isprint},
+            {"punct", ispunct}, {"space", isspace}, {"upper", isupper}, {"xdigit", isxdigit}
+        };
+
+        size_t i = 0;
+        size_t fill_at = std::string::npos;
+        unsigned char fill_with = 0;
+        while (i < text.size())
+        {
+            if (text.compare(i, 2, "[:") == 0 && text.find(":]", i + 2) != std::string::npos)
+            {
+                const size_t close = text.find(":]", i + 2);
+                const std::string name = text.substr(i + 2, close - i - 2);
+                bool found = false;
+                for (const auto& type : classes)
+                {
+                    if (name == type.name)
+                    {
+                        for (int ch = 0; ch < 256; ++ch)
+                        {
+                            if (type.test(ch))
+                            {
+                                set += static_cast<char>(ch);
+                            }
+                        }
+                        found = true;
+                    }
+                }
+                if (!found)
+                {
+                    error = "invalid character class '" + name + "'";
+                    return false;
+                }
+                i = close + 2;
+                continue;
+            }
+            if (text.compare(i, 2, "[=") == 0 && i + 4 < text.size() && text.compare(i + 3, 2, "=]") == 0)
+            {
+                set += text[i + 2];
+                i += 5;
+                continue;
+            }
+            if (text[i] == '[' && i + 2 < text.size())
+            {
+                size_t j = i + 1;
+                const unsigned char repeated = character(j);
+                const size_t close = text.find(']', j);
+                const std::string count = close != std::string::npos && j < close ? text.substr(j + 1, close - j - 1) : "";
+                if (close != std::string::npos && j < close && text[j] == '*' && count.find_first_not_of("0123456789") == std::string::npos)
+                {
+                    if (count.empty() || count.find_first_not_of('0') == std::string::npos)
+                    {
+                        fill_at = set.size();
+                        fill_with = repeated;
+                    }
+                    else
+                    {
+                        const unsigned long times = std::stoul(count, nullptr, count[0] == '0' ? 8 : 10);
+                        set.append(times, static_cast<char>(repeated));
+                    }
+                    i = close + 1;
+                    continue;
+                }
+            }
+
+            const unsigned char first = character(i);
+            if (i + 1 < text.size() && text[i] == '-')
+            {
+                ++i;
+                const unsigned char last = character(i);
+                if (last < first)
+                {
+                    error = "range-endpoints of '" + std::string(1, first) + "-" + std::string(1, last)
+                        + "' are in reverse collating sequence order";
+                    return false;
+                }
+                for (int ch = first; ch <= last; ++ch)
+                {
+                    set += static_cast<char>(ch);
+                }
+                continue;
+            }
+            set += static_cast<char>(first);
+        }
+        if (fill_at != std::string::npos && set.size() < fill)
+        {
+            set.insert(fill_at, fill - set.size(), static_cast<char>(fill_with));
+        }
+        return true;
+    }
+
+    /**
+    * @brief tr as a pipeline stage, with one output buffer reused for every chunk.
+    */
+    class Translate : public cash::Stage
+    {
+    public:
+        Translate() : table(), deleted(), squeezed()
+        {
+            for (int ch = 0; ch < 256; ++ch)
+            {
+                table[ch] = static_cast<uint8_t>(ch);
+            }
+        }
+
+        /**
+        * @brief Builds the tables from the command line.
+        *
+        * @return false after reporting invalid arguments.
+        */
+        bool compile(const std::vector<std::string>& args)
+        {
+            std::map<char, std::string> options;
+            std::vector<std::string> operands;
+            if (!cash::get_options(args, OPTIONS, options, operands))
+            {
+                return false;
+            }
+            const bool complement = options.count('c') || options.count('C');
+            deleting = options.count('d') != 0;
+            squeezing = options.count('s') != 0;
+            translating = !deleting && operands.size() == 2;
+            const size_t wanted = deleting && squeezing ? 2 : deleting || (squeezing && operands.size() == 1) ? 1 : 2;
+            if (operands.size() != wanted)
+            {
+                cash::report("tr", operands.size() < wanted ? "missing operand" : "extra operand '" + operands[wanted] + "'");
+                return false;
+            }
+
+            std::string first, second, error;
+            if (!expand_set(operands[0], 0, first, error))
+            {
+                cash::report("tr", error);
+                return false;
+            }
+            if (complement)
+            {
+                bool member[256] = {};
+                for (const char ch : first)
+                {
+                    member[static_cast<unsigned char>(ch)] = true;
+                }
+                first.clear();
+                for (int ch = 0; ch < 256; ++ch)
+                {
+                    if (!member[ch])
+                    {
+                        first += static_cast<char>(ch);
+                    }
+                }
+            }
+            if (operands.size() == 2 && !expand_set(operands[1], first.size(), second, error))
+            {
+                cash::report("tr", error);
+                return false;
+            }
+
+            if (translating)
+            {
+                if (second.empty())
+                {
+                    cash::report("tr", "when not truncating set1, string2 must be non-empty");
+                    return false;
+                }
+                // A shorter second set is padded with its last character
+                second.resize(std::max(second.size(), first.size()), second.back());
+                for (size_t i = 0; i < first.size(); ++i)
+                {
+                    table[static_cast<unsigned char>(first[i])] = static_cast<uint8_t>(second[i]);
+                }
+            }
+            if (deleting)
+            {
+                for (const char ch : first)
+                {
+                    deleted[static_cast<unsigned char>(ch)] = true;
+                }
+            }
+            if (squeezing)
+            {
+                // Squeezing applies to the last set given
+                for (const char ch : operands.size() == 2 ? second : first)
+                {
+                    squeezed[static_cast<unsigned char>(ch)] = true;
+                }
+            }
+            table_ranges = ranges_of(table);
+            deleted_ranges = ranges_of(deleted);
+            squeezed_ranges = ranges_of(squeezed);
+            return true;
+        }
+
+        bool feed(const char* data, const size_t size) override
+        {
+            if (buffer.size() < size)
+            {
+                buffer.resize(size);
+            }
+            char* out = buffer.data();
+            size_t length = size;
+            if (deleting)
+            {
+                length = remove(data, size, out);
+            }
+            else if (translating)
+            {
+                translate(data, size, out);
+            }
+            else
+            {
+                std::memcpy(out, data, size);
+            }
+            if (squeezing)
+            {
+                length = squeeze(out, length);
+            }
+            return length == 0 || emit(out, length);
+        }
+
+    private:
+        void translate(const char* data, const size_t size, char* out) const
+        {
+            size_t i = 0;
+#ifdef __SSE2__
+            if (table_ranges.size() <= MAX_RANGES)
+            {
+                for (; i + 16 <= size; i += 16)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    __m128i result = bytes;
+                    for (const auto& range : table_ranges)
+                    {
+                        const __m128i delta = _mm_set1_epi8(static_cast<char>(range.delta));
+                        result = _mm_add_epi8(result, _mm_and_si128(in_range(bytes, range), delta));
+                    }
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+                }
+            }
+#endif
+            for (; i < size; ++i)
+            {
+                out[i] = static_cast<char>(table[static_cast<unsigned char>(data[i])]);
+            }
+        }
+
+        size_t remove(const char* data, const size_t size, char* out) const
+        {
+            size_t i = 0, length = 0;
+            while (i < size)
+            {
+#ifdef __SSE2__
+                if (i + 16 <= size && deleted_ranges.size() <= MAX_RANGES)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    if (set_mask(bytes, deleted_ranges) == 0)
+                    {
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + length), bytes);
+                        length += 16;
+                        i += 16;
+                        continue;
+                    }
+                }
+                const size_t end = std::min(size, i + 16);
+#else
+                const size_t end = size;
+#endif
+                for (; i < end; ++i)
+                {
+                    out[length] = data[i];
+                    length += !deleted[static_cast<unsigned char>(data[i])];
+                }
+            }
+            return length;
+        }
+
+        // Squeezes in place, remembering the last byte across chunks
+        size_t squeeze(char* data, const size_t size)
+        {
+            size_t i = 0, length = 0;
+            while (i < size)
+            {
+#ifdef __SSE2__
+                if (i + 16 <= size && squeezed_ranges.size() <= MAX_RANGES)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    if (set_mask(bytes, squeezed_ranges) == 0)
+                    {
+                        // The block is loaded before the store, which may only overlap it
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + length), bytes);
+                        length += 16;
+                        i += 16;
+                        previous = static_cast<unsigned char>(data[length - 1]);
+                        continue;
+                    }
+                }
+                const size_t end = std::min(size, i + 16);
+#else
+                const size_t end = size;
+#endif
+                for (; i < end; ++i)
+                {
+                    const unsigned char ch = static_cast<unsigned char>(data[i]);
+                    if (ch == previous && squeezed[ch])
+                    {
+                        continue;
+                    }
+                    data[length++] = static_cast<char>(ch);
+                    previous = ch;
+                }
+            }
+            return length;
+        }
+
+        uint8_t table[256]; //!< What every byte translates to.
+        bool deleted[256]; //!< Bytes removed by -d.
+        bool squeezed[256]; //!< Bytes whose repeats are squeezed by -s.
+        std::vector<Range> table_ranges, deleted_ranges, squeezed_ranges;
+        bool translating = false, deleting = false, squeezing = false;
+        int previous = -1; //!< The last byte written, for squeezing.
+        std::vector<char> buffer; //!< Output, reused for every chunk.
+    };
+}
+
+std::unique_ptr<cash::Stage> cash::tr_stage(const std::vector<std::string>& args)
+{
+    std::unique_ptr<Translate> stage(new Translate());
+    if (!stage->compile(args))
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Stage>(stage.release());
+}
+
+bool cash::tr_in_process(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    return get_options(args, OPTIONS, options, operands, true);
+}
+
+int cash::tr(const std::vector<std::string>& args)
+{
+    // Other options, like -t, run the tr in PATH
+    if (!tr_in_process(args))
+    {
+        return spawn(args);
+    }
+    return run_stages({args});
+}
@@ -0,0 +1,395 @@
+/**
+ * @file variables.cpp
+ * @brief shell variables for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * The variable store and word expansion.
+ */
+
+#include <glob.h>
+#include <cctype>
+#include <cstdlib>
+#include "arithmetic.h"
+#include "variables.h"
+
+std::map<std::string, cash::Variable> cash::variables;
+int cash::last_status = 0;
+
+bool cash::is_name(const std::string& name)
+{
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+    {
+        return false;
+    }
+    for (const char ch : name)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void cash::set_variable(const std::string& name, const std::string& value)
+{
+    Variable& variable = variables[name];
+    variable.values.assign(1, value);
+    variable.integer = false;
+}
+
+void cash::set_array(const std::string& name, const std::vector<std::string>& values)
+{
+    Variable& variable = variables[name];
+    variable.values = values;
+    variable.integer = false;
+}
+
+void cash::set_integer(const std::string& name, const long long value)
+{
+    Variable& variable = variables[name];
+    variable.integer = true;
+    variable.number = value;
+}
+
+long long cash::get_integer(const std::string& name)
+{
+    const auto found = variables.find(name);
+    if (found == variables.end())
+    {
+        return 0;
+    }
+    if (found->second.integer)
+    {
+        return found->second.number;
+    }
+    return found->second.values.empty() ? 0 : std::strtoll(found->second.values[0].c_str(), nullptr, 10);
+}
+
+void cash::unset_variable(const std::string& name)
+{
+    variables.erase(name);
+}
+
+bool cash::assign(const std::string& word)
+{
+    const size_t equals = word.find('=');
+    if (equals == std::string::npos || !is_name(word.substr(0, equals)))
+    {
+        return false;
+    }
+    set_variable(word.substr(0, equals), expand_word(word.substr(equals + 1)));
+    return true;
+}
+
+namespace
+{
+    // Looks up one element of a variable, empty if either does not exist
+    std::string element(const std::string& name, const std::string& index)
+    {
+        if (name == "?")
+        {
+            return std::to_string(cash::last_status);
+        }
+        const auto found = cash::variables.find(name);
+        if (found == cash::variables.end())
+        {
+            return "";
+        }
+        const long i = std::strtol(index.c_str(), nullptr, 10);
+        if (found->second.integer)
+        {
+            // Integers are formatted only here, when used as strings
+            return i == 0 ? std::to_string(found->second.number) : "";
+        }
+        if (i < 0 || static_cast<size_t>(i) >= found->second.values.size())
+        {
+            return "";
+        }
+        return found->second.values[i];
+    }
+
+    std::vector<std::string> elements(const std::string& name)
+    {
+        const auto found = cash::variables.find(name);
+        if (found == cash::variables.end())
+        {
+            return std::vector<std::string>();
+        }
+        if (found->second.integer)
+        {
+            return std::vector<std::string>{std::to_string(found->second.number)};
+        }
+        return found->second.values;
+    }
+
+    std::string join(const std::vector<std::string>& values)
+    {
+        std::string joined;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (i != 0)
+            {
+                joined += ' ';
+            }
+            joined += values[i];
+        }
+        return joined;
+    }
+}
+
+bool cash::parse_range(const std::string& word, BraceRange& range)
+{
+    const size_t open = word.find('{');
+    if (open == std::string::npos)
+    {
+        return false;
+    }
+    const size_t close = word.find('}', open);
+    if (close == std::string::npos)
+    {
+        return false;
+    }
+
+    // {first..last} or {first..last..step}, all integers
+    const std::string inner = word.substr(open + 1, close - open - 1);
+    long long numbers[3] = {0, 0, 1};
+    int count = 0;
+    size_t pos = 0;
+    while (count < 3)
+    {
+        const char* begin = inner.c_str() + pos;
+        char* end = nullptr;
+        numbers[count++] = std::strtoll(begin, &end, 10);
+        if (end == begin)
+        {
+            return false;
+        }
+        pos = end - inner.c_str();
+        if (pos == inner.size())
+        {
+            break;
+        }
+        if (inner.compare(pos, 2, "..") != 0)
+        {
+            return false;
+        }
+        pos += 2;
+    }
+    if (count < 2 || pos != inner.size())
+    {
+        return false;
+    }
+
+    range.prefix = word.substr(0, open);
+    range.first = numbers[0];
+    range.last = numbers[1];
+    range.step = numbers[2] < 0 ? 0 - static_cast<unsigned long long>(numbers[2]) : static_cast<unsigned long long>(numbers[2]);
+    if (range.step == 0)
+    {
+        range.step = 1;
+    }
+    range.suffix = word.substr(close + 1);
+    return true;
+}
+
+unsigned long long cash::BraceRange::steps() const
+{
+    typedef unsigned long long Bits;
+    const Bits span = first <= last ? static_cast<Bits>(last) - static_cast<Bits>(first)
+                                    : static_cast<Bits>(first) - static_cast<Bits>(last);
+    return span / step;
+}
+
+long long cash::BraceRange::at(const unsigned long long n) const
+{
+    typedef unsigned long long Bits;
+    // Within the span, so the result is a long long again
+    const Bits offset = n * step;
+    return static_cast<long long>(first <= last ? static_cast<Bits>(first) + offset : static_cast<Bits>(first) - offset);
+}
+
+void cash::expand(const std::string& word, std::vector<std::string>& out)
+{
+    // Fast path: nothing to expand
+    if (word.find('$') == std::string::npos && word.find('{') == std::string::npos)
+    {
+        out.push_back(word);
+        return;
+    }
+
+    BraceRange range;
+    if (word.find('$') == std::string::npos && parse_range(word, range))
+    {
+        const unsigned long long steps = range.steps();
+        for (unsigned long long n = 0;; ++n)
+        {
+            out.push_back(range.prefix + std::to_string(range.at(n)) + range.suffix);
+            if (n == steps)
+            {
+                break;
+            }
+        }
+        return;
+    }
+
+    std::string result;
+    size_t i = 0;
+    while (i < word.size())
+    {
+        if (word[i] != '$' || i + 1 == word.size())
+        {
+            result += word[i++];
+            continue;
+        }
+
+        const char next = word[i + 1];
+        if (word.compare(i, 3, "$((") == 0)
+        {
+            // Arithmetic expansion, up to the matching ))
+            size_t end = i + 3;
+            int depth = 2;
+            while (end < word.size() && depth > 0)
+            {
+                depth += word[end] == '(' ? 1 : word[end] == ')' ? -1 : 0;
+                ++end;
+            }
+            if (depth != 0)
+            {
+                result += word.substr(i);
+                break;
+            }
+            const Arithmetic expression(expand_word(word.substr(i + 3, end - i - 5)));
+            bool error = false;
+            const long long value = expression.evaluate(error);
+            if (!error)
+            {
+                result += std::to_string(value);
+            }
+            i = end;
+        }
+        else if (next == '?')
+        {
+            result += std::to_string(last_status);
+            i += 2;
+        }
+        else if (next == '{')
+        {
+            const size_t close = word.find('}', i + 2);
+            if (close == std::string::npos)
+            {
+                // Unterminated, keep it literally
+                result += word.substr(i);
+                break;
+            }
+            std::string inner = word.substr(i + 2, close - i - 2);
+            const bool length = !inner.empty() && inner[0] == '#';
+            if (length)
+            {
+                inner.erase(0, 1);
+            }
+
+            std::string name = inner, index = "0";
+            const size_t bracket = inner.find('[');
+            if (bracket != std::string::npos && inner.back() == ']')
+            {
+                name = inner.substr(0, bracket);
+                index = inner.substr(bracket + 1, inner.size() - bracket - 2);
+            }
+
+            if (length && (index == "@" || index == "*"))
+            {
+                result += std::to_string(elements(name).size());
+            }
+            else if (length)
+            {
+                result += std::to_string(element(name, index).size());
+            }
+            else if (index == "@" || index == "*")
+            {
+                // A bare ${NAME[@]} word becomes one word per element
+                if (i == 0 && close + 1 == word.size() && index == "@")
+                {
+                    const auto values = elements(name);
+                    out.insert(out.end(), values.begin(), values.end());
+                    return;
+                }
+                result += join(elements(name));
+            }
+            else
+            {
+                result += element(name, expand_word(index));
+            }
+            i = close + 1;
+        }
+        else if (std::isalpha(static_cast<unsigned char>(next)) || next == '_')
+        {
+            size_t end = i + 1;
+            while (end < word.size() && (std::isalnum(static_cast<unsigned char>(word[end])) || word[end] == '_'))
+            {
+                ++end;
+            }
+            result += element(word.substr(i + 1, end - i - 1), "0");
+            i = end;
+        }
+        else
+        {
+            // Not an expansion, e.g. the end anchor of a regex
+            result += word[i++];
+        }
+    }
+    out.push_back(result);
+}
+
+std::string cash::expand_word(const std::string& word)
+{
+    std::vector<std::string> words;
+    expand(word, words);
+    return join(words);
+}
+
+std::vector<std::string> cash::expand_all(const std::vector<std::string>& args, const std::vector<bool>* quoted,
+                                          size_t* list_begin, size_t* list_end)
+{
+    std::vector<std::string> expanded, words;
+    expanded.reserve(args.size());
+    size_t widest = 0;
+    for (size_t a = 0; a < args.size(); ++a)
+    {
+        const size_t begin = expanded.size();
+        const bool pattern = quoted == nullptr || a >= quoted->size() || !(*quoted)[a];
+        words.clear();
+        expand(args[a], words);
+        for (const auto& word : words)
+        {
+            if (!pattern || word.find_first_of("*?[") == std::string::npos)
+            {
+                expanded.push_back(word);
+                continue;
+            }
+            glob_t matches;
+            if (glob(word.c_str(), 0, nullptr, &matches) == 0)
+            {
+                expanded.insert(expanded.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+            }
+            else
+            {
+                expanded.push_back(word);
+            }
+            globfree(&matches);
+        }
+
+        // Remembers the longest list, e.g. the files of *.o in rm -f *.o
+        if (expanded.size() - begin > widest)
+        {
+            widest = expanded.size() - begin;
+            if (list_begin != nullptr && list_end != nullptr)
+            {
+                *list_begin = begin;
+                *list_end = expanded.size();
+            }
+        }
+    }
+    return expanded;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file variables.h
+ * @brief shell variables for cash
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Contains declarations of the variable store and word expansion.
+ */
+
+
+#ifndef CASH_VARIABLES_H
+#define CASH_VARIABLES_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cash
+{
+    /**
+    * @brief A shell variable. A scalar is an array with a single element.
+    */
+    struct Variable
+    {
+        std::vector<std::string> values; //!< Elements, unused while integer is set.
+        bool integer = false; //!< Whether the value is kept as a native integer.
+        long long number = 0; //!< The value of an integer variable, formatted only when expanded.
+    };
+
+    /**
+    * @brief Shell variables.
+    */
+    extern std::map<std::string, Variable> variables;
+
+    /**
+    * @brief Exit status of the last command, expanded by $?.
+    */
+    extern int last_status;
+
+    /**
+    * @brief Checks whether a string is a valid variable name.
+    *
+    * @param name the name to check.
+    * @return true if name is made of letters, digits and underscores and does not start with a digit.
+    */
+    bool is_name(const std::string& name);
+
+    /**
+    * @brief Sets a scalar variable.
+    *
+    * @param name variable name.
+    * @param value new value.
+    */
+    void set_variable(const std::string& name, const std::string& value);
+
+    /**
+    * @brief Sets an array variable.
+    *
+    * @param name variable name.
+    * @param values new elements.
+    */
+    void set_array(const std::string& name, const std::vector<std::string>& values);
+
+    /**
+    * @brief Sets an integer variable without formatting it.
+    *
+    * @param name variable name.
+    * @param value new value.
+    */
+    void set_integer(const std::string& name, long long value);
+
+    /**
+    * @brief Reads a variable as an integer.
+    *
+    * @param name variable name.
+    * @return the value, 0 for unset or non-numeric variables.
+    */
+    long long get_integer(const std::string& name);
+
+    /**
+    * @brief Removes a variable.
+    *
+    * @param name variable name.
+    */
+    void unset_variable(const std::string& name);
+
+    /**
+    * @brief Handles a NAME=value word.
+    *
+    * @param word the word to check.
+    * @return true if word was an assignment and has been performed.
+    */
+    bool assign(const std::string& word);
+
+    /**
+    * @brief Expands $NAME, ${NAME}, ${NAME[i]}, ${NAME[@]}, ${#NAME[@]}, $? and $((expr)) in a word.
+    *
+    * A word consisting only of ${NAME[@]} expands to one word per element,
+    * otherwise the elements are joined with spaces. Brace sequences such as
+    * file{1..3} expand to one word per number.
+    *
+    * @param word the word to expand.
+    * @param out expanded words are appended here.
+    */
+    void expand(const std::string& word, std::vector<std::string>& out);
+
+    /**
+    * @brief A brace sequence, prefix{first..last..step}suffix.
+    */
+    struct BraceRange
+    {
+        std::string prefix; //!< Text before the braces.
+        long long first; //!< First number.
+        long long last; //!< Last number, inclusive.
+        unsigned long long step; //!< Positive distance between numbers.
+        std::string suffix; //!< Text after the braces.
+
+        /**
+        * @brief Steps from first to the last number reached, one less than the numbers.
+        *
+        * Counted without overflow, so ranges may end at either limit of long long.
+        */
+        unsigned long long steps() const;
+
+        /**
+        * @brief The number n steps from first, towards last.
+        */
+        long long at(unsigned long long n) const;
+    };
+
+    /**
+    * @brief Recognizes a brace sequence.
+    *
+    * @param word the word to check.
+    * @param range filled in when word is a brace sequence.
+    * @return true if word is a brace sequence.
+    */
+    bool parse_range(const std::string& word, BraceRange& range);
+
+    /**
+    * @brief Expands a word into a single string, joining multiple words with spaces.
+    *
+    * @param word the word to expand.
+    * @return the expanded string.
+    */
+    std::string expand_word(const std::string& word);
+
+    /**
+    * @brief Expands every word of a command, then matches words containing *, ? or [ against file names.
+    *
+    * Patterns matching no file are kept as they are.
+    *
+    * @param args the words to expand.
+    * @param quoted if given, whether each word had its pattern characters quoted, and is not matched.
+    * @param list_begin if given, set to the first of the most words produced by a single argument.
+    * @param list_end if given, set to one past the last of those words.
+    * @return expanded words.
+    */
+    std::vector<std::string> expand_all(const std::vector<std::string>& args, const std::vector<bool>* quoted = nullptr,
+                                        size_t* list_begin = nullptr, size_t* list_end = nullptr);
+}
+
+#endif //CASH_VARIABLES_H
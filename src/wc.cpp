@@ -0,0 +1,351 @@
+/**
+ * @file wc.cpp
+ * @brief the wc builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Counts newlines and word starts 64 bytes at a time with SSE2 compares and
+ * movemask, so a line or word costs a bit in a mask instead of a branch.
+ * Words are runs of printable characters, as in coreutils with the C locale:
+ * other non-space bytes neither start nor end a word, and blocks containing
+ * them take the scalar path.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "cash.h"
+#include "filters.h"
+#include "stream.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Files larger than this are split across threads
+    const size_t PIECE_SIZE = 32 << 20;
+
+    /**
+    * @brief Counts of one input, or of a piece of one.
+    */
+    enum Class { NONE, SPACE, WORD };
+
+    struct Counts
+    {
+        uint64_t lines = 0;
+        uint64_t words = 0;
+        uint64_t bytes = 0;
+        Class first = NONE; //!< Class of the first space or word byte.
+        Class last = NONE; //!< Class of the last space or word byte.
+    };
+
+    inline bool is_space(const unsigned char ch)
+    {
+        // The C locale's isspace: space, \t, \n, \v, \f and \r
+        return ch == ' ' || static_cast<unsigned char>(ch - '\t') < 5;
+    }
+
+    // Other bytes are neither, e.g. control characters and bytes above 0x7e
+    inline Class class_of(const unsigned char ch)
+    {
+        if (is_space(ch))
+        {
+            return SPACE;
+        }
+        return static_cast<unsigned char>(ch - 0x21) < 0x5e ? WORD : NONE;
+    }
+
+#ifdef __SSE2__
+    // Bitmask of the whitespace bytes of 16 bytes
+    inline uint32_t space_mask(const __m128i bytes)
+    {
+        const __m128i blank = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+        // \t..\r are the bytes b with b - 9 <= 4 unsigned
+        const __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(blank, control)));
+    }
+
+    // Bitmask of the printable bytes, 0x20..0x7e
+    inline uint32_t printable_mask(const __m128i bytes)
+    {
+        const __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(0x20));
+        const __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(0x5e)), shifted);
+        return static_cast<uint32_t>(_mm_movemask_epi8(in_range));
+    }
+
+    inline uint32_t newline_mask(const __m128i bytes)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+    }
+
+#endif
+
+    /**
+    * @brief Counts lines and words of a buffer, continuing from previous buffers.
+    */
+    void count_words(const char* data, const size_t size, Counts& counts, bool& in_word)
+    {
+        size_t i = 0;
+        while (i < size)
+        {
+#ifdef __SSE2__
+            if (i + 64 <= size)
+            {
+                uint64_t spaces = 0, printable = 0, newlines = 0;
+                for (int part = 0; part < 4; ++part)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16 * part));
+                    spaces |= static_cast<uint64_t>(space_mask(bytes)) << (16 * part);
+                    printable |= static_cast<uint64_t>(printable_mask(bytes)) << (16 * part);
+                    newlines |= static_cast<uint64_t>(newline_mask(bytes)) << (16 * part);
+                }
+                if ((spaces | printable) == ~0ULL)
+                {
+                    // A word starts at a non-space whose previous byte is a space
+                    const uint64_t previous = (spaces << 1) | (in_word ? 0 : 1);
+                    counts.words += __builtin_popcountll(~spaces & previous);
+                    counts.lines += __builtin_popcountll(newlines);
+                    in_word = (spaces >> 63) == 0;
+                    i += 64;
+                    continue;
+                }
+            }
+            const size_t end = std::min(size, i + 64);
+#else
+            const size_t end = size;
+#endif
+            for (; i < end; ++i)
+            {
+                const unsigned char ch = data[i];
+                const Class type = class_of(ch);
+                counts.words += type == WORD && !in_word;
+                counts.lines += ch == '\n';
+                in_word = type == NONE ? in_word : type == WORD;
+            }
+        }
+    }
+
+    // Class of the first space or word byte, scanning forwards or backwards
+    Class edge_class(const char* data, const size_t size, const bool forwards)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            const Class type = class_of(data[forwards ? i : size - 1 - i]);
+            if (type != NONE)
+            {
+                return type;
+            }
+        }
+        return NONE;
+    }
+
+    /**
+    * @brief Counts a buffer on its own, recording how it starts and ends for merging.
+    */
+    Counts count_piece(const char* data, const size_t size, const bool lines, const bool words)
+    {
+        Counts counts;
+        counts.bytes = size;
+        if (words)
+        {
+            counts.first = edge_class(data, size, true);
+            counts.last = edge_class(data, size, false);
+            bool in_word = false;
+            count_words(data, size, counts, in_word);
+        }
+        else if (lines)
+        {
+            counts.lines = cash::count_lines(data, size);
+        }
+        return counts;
+    }
+
+    // Appends a piece counted separately, a word running across the boundary counts once
+    void merge(Counts& total, const Counts& piece)
+    {
+        if (total.last == WORD && piece.first == WORD)
+        {
+            --total.words;
+        }
+        if (total.first == NONE)
+        {
+            total.first = piece.first;
+        }
+        if (piece.last != NONE)
+        {
+            total.last = piece.last;
+        }
+        total.lines += piece.lines;
+        total.words += piece.words;
+        total.bytes += piece.bytes;
+    }
+
+    /**
+    * @brief One operand and what is known about it.
+    */
+    struct Input
+    {
+        std::string name;
+        int fd = -1;
+        Counts counts;
+    };
+
+    std::string pad(const uint64_t number, const size_t width)
+    {
+        std::string text = std::to_string(number);
+        if (text.size() < width)
+        {
+            text.insert(0, width - text.size(), ' ');
+        }
+        return text;
+    }
+}
+
+int cash::wc(const std::vector<std::string>& args)
+{
+    std::map<char, std::string> options;
+    std::vector<std::string> operands;
+    // Other options, like -L or --files0-from, run the wc in PATH
+    if (!get_options(args, "lwcm", options, operands, true))
+    {
+        return spawn(args);
+    }
+    bool lines = options.count('l') != 0, words = options.count('w') != 0;
+    bool bytes = options.count('c') != 0 || options.count('m') != 0;
+    if (!lines && !words && !bytes)
+    {
+        lines = words = bytes = true;
+    }
+    const bool from_stdin = operands.empty();
+    if (from_stdin)
+    {
+        operands.push_back("-");
+    }
+
+    int status = 0;
+    std::vector<Input> inputs(operands.size());
+    std::vector<MappedFile> files(operands.size());
+    bool all_regular = true;
+    size_t total_size = 0;
+
+    // Pieces of mapped files: (input, offset, size)
+    struct Piece
+    {
+        size_t input, offset, size;
+        Counts counts;
+    };
+    std::vector<Piece> pieces;
+
+    for (size_t i = 0; i < operands.size(); ++i)
+    {
+        Input& input = inputs[i];
+        input.name = operands[i];
+        input.fd = open_input("wc", operands[i]);
+        if (input.fd == -1)
+        {
+            status = 1;
+            continue;
+        }
+        if (files[i].map(input.fd))
+        {
+            total_size += files[i].size();
+            // -c alone needs no reading at all
+            if (!lines && !words)
+            {
+                input.counts.bytes = files[i].size();
+                continue;
+            }
+            for (size_t offset = 0; offset < files[i].size(); offset += PIECE_SIZE)
+            {
+                pieces.push_back(Piece{i, offset, std::min(PIECE_SIZE, files[i].size() - offset), Counts()});
+            }
+        }
+        else
+        {
+            // Pipes and terminals are read in order, here
+            all_regular = false;
+            bool in_word = false;
+            read_chunks(input.fd, [&](const char* data, const size_t size)
+            {
+                Counts& counts = input.counts;
+                if (words)
+                {
+                    count_words(data, size, counts, in_word);
+                }
+                else if (lines)
+                {
+                    counts.lines += cash::count_lines(data, size);
+                }
+                counts.bytes += size;
+                return true;
+            });
+        }
+    }
+
+    // Mapped pieces are counted in parallel and merged in order
+    parallel_for(pieces.size(), [&](const size_t p)
+    {
+        Piece& piece = pieces[p];
+        piece.counts = count_piece(files[piece.input].data() + piece.offset, piece.size, lines, words);
+    });
+    for (const auto& piece : pieces)
+    {
+        merge(inputs[piece.input].counts, piece.counts);
+    }
+
+    // Columns are as wide as the largest possible count, like coreutils
+    size_t width = 1;
+    const int columns = lines + words + bytes;
+    if (columns > 1 || inputs.size() > 1)
+    {
+        width = all_regular ? std::to_string(total_size).size() : 7;
+    }
+
+    Output output;
+    Counts total;
+    for (auto& input : inputs)
+    {
+        close_input(input.fd);
+        if (input.fd == -1)
+        {
+            continue;
+        }
+        std::string line;
+        const uint64_t values[] = {input.counts.lines, input.counts.words, input.counts.bytes};
+        const bool shown[] = {lines, words, bytes};
+        for (int c = 0; c < 3; ++c)
+        {
+            if (shown[c])
+            {
+                line += (line.empty() ? "" : " ") + pad(values[c], width);
+            }
+        }
+        if (!from_stdin)
+        {
+            line += " " + input.name;
+        }
+        output.write(line + "\n");
+        total.lines += input.counts.lines;
+        total.words += input.counts.words;
+        total.bytes += input.counts.bytes;
+    }
+    if (inputs.size() > 1)
+    {
+        std::string line;
+        const uint64_t values[] = {total.lines, total.words, total.bytes};
+        const bool shown[] = {lines, words, bytes};
+        for (int c = 0; c < 3; ++c)
+        {
+            if (shown[c])
+            {
+                line += (line.empty() ? "" : " ") + pad(values[c], width);
+            }
+        }
+        output.write(line + " total\n");
+    }
+    return status;
+}
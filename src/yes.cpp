@@ -0,0 +1,52 @@
+/**
+ * @file yes.cpp
+ * @brief the yes builtin
+ * @Author Angine (me@angine.tech)
+ * @date   October 18, 2026
+ *
+ * Fills one block of pages with copies of the line and hands the same
+ * pages to the pipe over and over with vmsplice; they never change, so the
+ * pipe can keep referring to them.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include "filters.h"
+#include "stream.h"
+
+namespace
+{
+    // Size of the block of repeated lines
+    const size_t BLOCK_SIZE = 1 << 18;
+}
+
+int cash::yes(const std::vector<std::string>& args)
+{
+    std::string line = args.size() > 1 ? args[1] : "y";
+    for (size_t i = 2; i < args.size(); ++i)
+    {
+        line += ' ' + args[i];
+    }
+    line += '\n';
+
+    // Whole lines only, so every send ends on a line
+    const size_t copies = std::max<size_t>(1, BLOCK_SIZE / line.size());
+    Pages block(copies * line.size());
+    if (block.data() == nullptr)
+    {
+        report("yes", strerror(errno));
+        return 1;
+    }
+    for (size_t i = 0; i < copies; ++i)
+    {
+        std::memcpy(block.data() + i * line.size(), line.data(), line.size());
+    }
+
+    SpliceWriter writer;
+    while (writer.send(block.data(), block.size()))
+    {
+    }
+    return 1;
+}